@@ -0,0 +1,1089 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Host benchmark for the hot functions in the library.
+//
+// Build and run from the root of the library:
+//
+//     g++ -O2 -std=gnu++11 -Iextras/host -Isrc extras/benchmark/benchmark.cpp src/*.cpp -o astrocalcs_benchmark
+//     ./astrocalcs_benchmark > bench_output.txt
+//
+// For every function it prints the throughput, the latency percentiles per call, and the largest error against a
+// long double reference of the same formula (in arc-seconds), so each optimisation can be checked against the last run.
+
+#include "Arduino.h"
+#include "AstroCalcs.h"
+#include "PositionBatch.h"
+#include "SiteBatch.h"
+#include "SkyIndex.h"
+#include "Catalog.h"
+#include "Trajectory.h"
+#include "TrackedSet.h"
+#include "CrossingEvents.h"
+#include "Frame.h"
+#include "AltAzKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// amount of different inputs every function is run on
+#define INPUTS 4096
+
+// amount of targets in the catalog the SkyIndex benchmarks search
+#define CATALOG 100000
+
+// calls per timed block, so the clock overhead does not swamp fast functions
+#define BLOCK 64
+
+// timed blocks per function
+#define SAMPLES 4000
+
+#define LONGITUDE 172.5
+#define LATITUDE -43.5
+
+
+/**
+ * Reaches the private stages of AstroCalcs so they can be timed on their own.
+ */
+struct AstroCalcsBenchmark
+{
+    template<class Math> static void lst(BasicAstroCalcs<Math>& a) { a.lst(); }
+    template<class Math> static void refract(BasicAstroCalcs<Math>& a) { a.refract(); }
+};
+
+
+// long double references, written straight from the formulas in the library
+
+
+static long double wrapDegrees(long double x)
+{
+    x = fmodl(x, 360.0L);
+    return (x < 0.0L) ? x + 360.0L : x;
+}
+
+static long double rad(long double x)
+{
+    return x * 3.14159265358979323846264338327950288L / 180.0L;
+}
+
+static long double deg(long double x)
+{
+    return x * 180.0L / 3.14159265358979323846264338327950288L;
+}
+
+static long double referenceJD(int Y, int M, int D, int h, int m, int s)
+{
+    if(M <= 2)
+    {
+        M += 12;
+        Y -= 1;
+    }
+    long A = (long)floorl(Y / 100);
+    long B = (long)floorl(A / 4);
+    long C = 2 - A + B;
+    long E = (long)floorl(365.25L * (Y + 4716)) - 2451545L;
+    long F = (long)floorl(30.6001L * (M + 1));
+    return C + D + E + F - 1524.5L + h / 24.0L + m / 1440.0L + s / 86400.0L;
+}
+
+static long double referenceLST(int Y, int M, int D, int h, int m, int s, long double longitude)
+{
+    long double jd = referenceJD(Y, M, D, h, m, s);
+    long double t = jd / 36525.0L;
+    long double theta = 280.46061837L + 360.98564736629L * jd + 0.000387933L * t * t - t * t * t / 38710000.0L;
+    return wrapDegrees(theta + longitude);
+}
+
+static void referenceAltAz(long double ra, long double dec, long double latitude, long double LST, long double* alt, long double* az)
+{
+    long double h = rad(wrapDegrees(LST - ra));
+    long double d = rad(dec);
+    long double l = rad(latitude);
+    long double x = cosl(h) * cosl(d) * sinl(l) - sinl(d) * cosl(l);
+    long double y = sinl(h) * cosl(d);
+    long double z = sinl(l) * sinl(d) + cosl(h) * cosl(d) * cosl(l);
+    *az = wrapDegrees(deg(3.14159265358979323846264338327950288L + atan2l(y, x)));
+    *alt = deg(atan2l(z, sqrtl(x * x + y * y)));
+}
+
+static void referencePrecess(long double ra, long double dec, int year, long double* ra_out, long double* dec_out)
+{
+    long double T = (year - 2000.0L) / 100.0L;
+    *ra_out = wrapDegrees(ra + (307.0L * T + 134.0L * T * sinl(rad(ra)) * tanl(rad(dec))) / 240.0L);
+    *dec_out = dec + 2004.0L * T * cosl(rad(ra)) / 3600.0L;
+}
+
+/// IAU 2006 precession, as the three rotations R3(-z) R2(theta) R3(-zeta) applied one after another
+static void referencePrecessIau2006(long double ra, long double dec, long double jd, long double* ra_out, long double* dec_out)
+{
+    long double t = jd / 36525.0L;
+    long double zeta = rad((2.650545L + t * (2306.083227L + t * (0.2988499L + t * (0.01801828L + t * (-0.000005971L + t * -0.0000003173L))))) / 3600.0L);
+    long double z = rad((-2.650545L + t * (2306.077181L + t * (1.0927348L + t * (0.01826837L + t * (-0.000028596L + t * -0.0000002904L))))) / 3600.0L);
+    long double theta = rad((t * (2004.191903L + t * (-0.4294934L + t * (-0.04182264L + t * (-0.000007089L + t * -0.0000001274L))))) / 3600.0L);
+
+    long double x = cosl(rad(dec)) * cosl(rad(ra));
+    long double y = cosl(rad(dec)) * sinl(rad(ra));
+    long double w = sinl(rad(dec));
+    long double a;
+
+    a = cosl(zeta) * x - sinl(zeta) * y;
+    y = sinl(zeta) * x + cosl(zeta) * y;
+    x = a;
+
+    a = cosl(theta) * x - sinl(theta) * w;
+    w = sinl(theta) * x + cosl(theta) * w;
+    x = a;
+
+    a = cosl(z) * x - sinl(z) * y;
+    y = sinl(z) * x + cosl(z) * y;
+    x = a;
+
+    *ra_out = wrapDegrees(deg(atan2l(y, x)));
+    *dec_out = deg(atan2l(w, sqrtl(x * x + y * y)));
+}
+
+/// nutation as the rotation R1(-eps) R3(-dpsi) R1(eps0), then aberration as adding the Earth's velocity to the unit vector.
+/// The series itself (dpsi and deps) comes from the library, which was checked against Meeus example 22.a.
+static void referenceApparent(long double ra, long double dec, long double jd, long double* ra_out, long double* dec_out,
+                              bool aberration = true)
+{
+    long double t = jd / 36525.0L;
+    double dpsi, deps;
+    nutationSeries((double)t, &dpsi, &deps);
+    long double mean = rad((84381.406L + t * (-46.836769L + t * (-0.0001831L + t * 0.00200340L))) / 3600.0L);
+    long double obliquity = mean + rad(deps / 3600.0L);
+    long double psi = rad(dpsi / 3600.0L);
+
+    long double x = cosl(rad(dec)) * cosl(rad(ra));
+    long double y = cosl(rad(dec)) * sinl(rad(ra));
+    long double z = sinl(rad(dec));
+    long double a;
+
+    a = cosl(mean) * y + sinl(mean) * z;
+    z = -sinl(mean) * y + cosl(mean) * z;
+    y = a;
+
+    a = cosl(psi) * x - sinl(psi) * y;
+    y = sinl(psi) * x + cosl(psi) * y;
+    x = a;
+
+    a = cosl(obliquity) * y - sinl(obliquity) * z;
+    z = sinl(obliquity) * y + cosl(obliquity) * z;
+    y = a;
+
+    // the Earth's velocity over c, perpendicular to the Sun's direction in the ecliptic, with the eccentricity term
+    long double M = rad(357.52911L + t * (35999.05029L - t * 0.0001537L));
+    long double C = (1.914602L - t * (0.004817L + t * 0.000014L)) * sinl(M) + (0.019993L - t * 0.000101L) * sinl(2.0L * M) + 0.000289L * sinl(3.0L * M);
+    long double sun = rad(280.46646L + t * (36000.76983L + t * 0.0003032L) + C);
+    long double perihelion = rad(102.93735L + t * (1.71946L + t * 0.00046L));
+    long double e = 0.016708634L - t * (0.000042037L + t * 0.0000001267L);
+    long double kappa = rad(20.49552L / 3600.0L);
+    long double along = kappa * (cosl(sun) - e * cosl(perihelion));
+    if(aberration)
+    {
+        x += kappa * (sinl(sun) - e * sinl(perihelion));
+        y += -along * cosl(obliquity);
+        z += -along * sinl(obliquity);
+    }
+
+    *ra_out = wrapDegrees(deg(atan2l(y, x)));
+    *dec_out = deg(atan2l(z, sqrtl(x * x + y * y)));
+}
+
+static void referenceRaDec(long double alt, long double az, long double latitude, long double LST, long double* ra, long double* dec)
+{
+    long double a = rad(alt);
+    long double A = rad(az) + 3.14159265358979323846264338327950288L;
+    long double l = rad(latitude);
+    long double x = sinl(a) * cosl(l) - cosl(a) * cosl(A) * sinl(l);
+    long double y = sinl(A) * cosl(a);
+    long double z = sinl(a) * sinl(l) + cosl(a) * cosl(A) * cosl(l);
+    long double h = atan2l(y, fabsl(x));
+    *dec = deg(atan2l(z, sqrtl(x * x + y * y)));
+    *ra = wrapDegrees(LST - 360.0L + deg(h));
+}
+
+
+/// the difference between two angles in arc-seconds, allowing for the wrap at 360
+static double arcsec(long double a, long double b)
+{
+    long double d = fabsl(a - b);
+    d = fmodl(d, 360.0L);
+    if(d > 180.0L)
+    {
+        d = 360.0L - d;
+    }
+    return (double)(d * 3600.0L);
+}
+
+/// the largest error of a position against a reference, with azimuth and right ascention scaled to great-circle distance
+template<class Math> static double positionError(const BasicPosition<Math>& p, long double ra, long double dec, long double alt, long double az)
+{
+    double e = arcsec((double)p.getAlt(), alt);
+    e = std::max(e, arcsec((double)p.getAz(), az) * (double)cosl(rad(alt)));
+    e = std::max(e, arcsec((double)p.getRA(), ra) * (double)cosl(rad(dec)));
+    e = std::max(e, arcsec((double)p.getDec(), dec));
+    return e;
+}
+
+
+/**
+ * The inputs every function is run on
+ */
+struct Inputs
+{
+    double ra[INPUTS];
+    double dec[INPUTS];
+    double alt[INPUTS];
+    double az[INPUTS];
+    double seconds[INPUTS];
+    int Y[INPUTS], M[INPUTS], D[INPUTS], h[INPUTS], m[INPUTS], s[INPUTS];
+
+    Inputs()
+    {
+        srand(2024);
+        for(int i = 0; i < INPUTS; i++)
+        {
+            ra[i] = 360.0 * rand() / ((double)RAND_MAX + 1.0);
+            dec[i] = -89.0 + 178.0 * rand() / (double)RAND_MAX;
+            alt[i] = 1.0 + 88.0 * rand() / (double)RAND_MAX;
+            az[i] = 360.0 * rand() / ((double)RAND_MAX + 1.0);
+            seconds[i] = 3600.0 * rand() / (double)RAND_MAX;
+            Y[i] = 1990 + rand() % 60;
+            M[i] = 1 + rand() % 12;
+            D[i] = 1 + rand() % 28;
+            h[i] = rand() % 24;
+            m[i] = rand() % 60;
+            s[i] = rand() % 60;
+        }
+    }
+};
+
+static Inputs inputs;
+
+/// written to by every benchmark so the compiler cannot drop the calls
+static volatile double sink;
+
+
+/**
+ * Times `op(i)` in blocks and prints one line of results
+ *
+ * @param name the function being timed
+ * @param tier the trig backend
+ * @param op the operation, called with an input index
+ * @param error the largest error against the reference, in arc-seconds
+ * @param targets the amount of targets one call of `op` works on, so batches are reported per target
+ * @param block calls per timed block
+ * @param samples amount of timed blocks
+ */
+template<class Op> static void report(const char* name, const char* tier, Op op, double error,
+                                      int targets = 1, int block = BLOCK, int samples = SAMPLES)
+{
+    std::vector<double> per_target(samples);
+    double total = 0.0;
+
+    // warm the caches and branch predictors
+    for(int i = 0; i < INPUTS / targets; i++)
+    {
+        op(i);
+    }
+
+    int input = 0;
+    for(int sample = 0; sample < samples; sample++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int i = 0; i < block; i++)
+        {
+            op(input);
+            input = (input + 1) % INPUTS;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        per_target[sample] = ns / ((double)block * targets);
+        total += ns;
+    }
+
+    std::sort(per_target.begin(), per_target.end());
+    double throughput = (double)samples * block * targets / total * 1000.0;
+
+    printf("%-32s %-7s %10.2f %9.1f %9.1f %9.1f %14.3g\n", name, tier, throughput,
+           per_target[samples / 2], per_target[samples * 9 / 10], per_target[samples * 99 / 100], error);
+}
+
+
+/**
+ * Runs every AstroCalcs and Position benchmark with one trig backend
+ */
+template<class Math> static void benchmarkTier(const char* tier)
+{
+    BasicAstroCalcs<Math> astro(LONGITUDE, LATITUDE);
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+    long double LST = referenceLST(2024, 6, 15, 10, 30, 0, LONGITUDE);
+    long double jd = referenceJD(2024, 6, 15, 10, 30, 0);
+    double error;
+
+    // positions for the functions that work on an existing target
+    std::vector<BasicPosition<Math> > positions(INPUTS);
+    for(int i = 0; i < INPUTS; i++)
+    {
+        positions[i] = BasicPosition<Math>(inputs.ra[i], inputs.dec[i], LATITUDE, astro.getLST());
+    }
+
+    // updateTime
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        astro.updateTime(inputs.Y[i], inputs.M[i], inputs.D[i], inputs.h[i], inputs.m[i], inputs.s[i]);
+        long double reference = referenceLST(inputs.Y[i], inputs.M[i], inputs.D[i], inputs.h[i], inputs.m[i], inputs.s[i], LONGITUDE);
+        error = std::max(error, arcsec((double)astro.getLST(), reference));
+    }
+    report("AstroCalcs::updateTime", tier, [&](int i) {
+        astro.updateTime(inputs.Y[i], inputs.M[i], inputs.D[i], inputs.h[i], inputs.m[i], inputs.s[i]);
+        sink = (double)astro.getLST();
+    }, error);
+
+    // lst on its own, for the date left by the last updateTime
+    report("AstroCalcs::lst", tier, [&](int) {
+        AstroCalcsBenchmark::lst(astro);
+        sink = (double)astro.getLST();
+    }, error);
+
+    // advance, checked against updateTime after a minute of 10ms steps from each date
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i += 64)
+    {
+        astro.updateTime(inputs.Y[i], inputs.M[i], inputs.D[i], inputs.h[i], inputs.m[i], 0);
+        for(int step = 0; step < 6000; step++)
+        {
+            astro.advance(0.01);
+        }
+        long double reference = referenceLST(inputs.Y[i], inputs.M[i], inputs.D[i], inputs.h[i], inputs.m[i] + 1, 0, LONGITUDE);
+        error = std::max(error, arcsec((double)astro.getLST(), reference));
+    }
+    report("AstroCalcs::advance", tier, [&](int i) {
+        astro.advance(inputs.seconds[i] * 1e-4);
+        sink = (double)astro.getLST();
+    }, error);
+
+    // long runs of small steps (a 1 kHz and a 100 Hz loop for just under ten minutes), checked against updateTime at the end
+    error = 0.0;
+    for(int rate = 1000; rate >= 100; rate /= 10)
+    {
+        astro.updateTime(2024, 6, 15, 10, 30, 0);
+        for(long step = 0; step < 599L * rate; step++)
+        {
+            astro.advance(1.0 / rate);
+        }
+        long double reference = referenceLST(2024, 6, 15, 10, 39, 59, LONGITUDE);
+        error = std::max(error, arcsec((double)astro.getLST(), reference));
+    }
+    report("AstroCalcs::advance small steps", tier, [&](int) {
+        astro.advance(0.001);
+        sink = (double)astro.getLST();
+    }, error);
+
+    // handing the time to another instance, as a binary snapshot and as the older text
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+    astro.advance(12.345);
+    BasicAstroCalcs<Math> copy(0.0, 0.0);
+    uint8_t snapshot[ASTROCALCS_SNAPSHOT_SIZE];
+    astro.serialize(snapshot, sizeof(snapshot));
+    copy.deserialize(snapshot, sizeof(snapshot));
+    error = arcsec((double)copy.getLST(), (double)astro.getLST());
+    report("AstroCalcs::serialize", tier, [&](int) {
+        sink = astro.serialize(snapshot, sizeof(snapshot));
+    }, error);
+    report("AstroCalcs::deserialize", tier, [&](int) {
+        sink = copy.deserialize(snapshot, sizeof(snapshot));
+    }, error);
+
+    copy.updateTimeManual(astro.timeVars());
+    error = arcsec((double)copy.getLST(), (double)astro.getLST());
+    report("AstroCalcs::timeVars", tier, [&](int) {
+        sink = astro.timeVars().length();
+    }, error);
+    String text = astro.timeVars();
+    report("AstroCalcs::updateTimeManual", tier, [&](int) {
+        copy.updateTimeManual(text);
+        sink = (double)copy.getLST();
+    }, error);
+
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+
+    // calcPosJ2000
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec, alt, az;
+        astro.calcPosJ2000(inputs.ra[i], inputs.dec[i]);
+        referencePrecess(inputs.ra[i], inputs.dec[i], 2024, &ra, &dec);
+        referenceApparent(ra, dec, jd, &ra, &dec);
+        referenceAltAz(ra, dec, LATITUDE, LST, &alt, &az);
+        error = std::max(error, positionError(astro.curr_pos, ra, dec, alt, az));
+    }
+    report("AstroCalcs::calcPosJ2000", tier, [&](int i) {
+        astro.calcPosJ2000(inputs.ra[i], inputs.dec[i]);
+        sink = (double)astro.curr_pos.getAlt();
+    }, error);
+
+    // the same, when only the apparent ra/dec is read (a mount that takes equatorial coordinates), so no alt/az is worked out
+    report("AstroCalcs::calcPosJ2000 ra/dec", tier, [&](int i) {
+        astro.calcPosJ2000(inputs.ra[i], inputs.dec[i]);
+        sink = (double)astro.curr_pos.getRA();
+    }, error);
+
+    // precess_curr_pos
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec, alt, az;
+        astro.curr_pos = positions[i];
+        BasicPosition<Math> p = astro.precess_curr_pos();
+        referencePrecess(inputs.ra[i], inputs.dec[i], 2024, &ra, &dec);
+        referenceAltAz(ra, dec, LATITUDE, LST, &alt, &az);
+        error = std::max(error, positionError(p, ra, dec, alt, az));
+    }
+    report("AstroCalcs::precess_curr_pos", tier, [&](int i) {
+        astro.curr_pos = positions[i];
+        sink = (double)astro.precess_curr_pos().getAlt();
+    }, error);
+
+    // calcPosJ2000 with the IAU 2006 matrix
+    astro.setPrecessionModel(PRECESSION_IAU2006);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec, alt, az;
+        astro.calcPosJ2000(inputs.ra[i], inputs.dec[i]);
+        referencePrecessIau2006(inputs.ra[i], inputs.dec[i], jd, &ra, &dec);
+        referenceApparent(ra, dec, jd, &ra, &dec);
+        referenceAltAz(ra, dec, LATITUDE, LST, &alt, &az);
+        error = std::max(error, positionError(astro.curr_pos, ra, dec, alt, az));
+    }
+    report("AstroCalcs::calcPosJ2000 iau2006", tier, [&](int i) {
+        astro.calcPosJ2000(inputs.ra[i], inputs.dec[i]);
+        sink = (double)astro.curr_pos.getAlt();
+    }, error);
+
+    // the same precession and nutation as one matrix straight to the horizon, against the true place (no aberration)
+    BasicFrame<Math> frame(LATITUDE);
+    frame.update(astro.getPrecession(), &astro.getNutation());
+    frame.setLST((double)astro.getLST());
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec, alt, az;
+        typename Math::Scalar frame_alt, frame_az;
+        frame.applyRaDec(typename Math::Scalar(inputs.ra[i]), typename Math::Scalar(inputs.dec[i]), &frame_alt, &frame_az);
+        referencePrecessIau2006(inputs.ra[i], inputs.dec[i], jd, &ra, &dec);
+        referenceApparent(ra, dec, jd, &ra, &dec, false);
+        referenceAltAz(ra, dec, LATITUDE, LST, &alt, &az);
+        error = std::max(error, arcsec((double)frame_alt, alt));
+        error = std::max(error, arcsec((double)frame_az, az) * (double)cosl(rad(alt)));
+    }
+    report("Frame::applyRaDec", tier, [&](int i) {
+        typename Math::Scalar frame_alt, frame_az;
+        frame.applyRaDec(typename Math::Scalar(inputs.ra[i]), typename Math::Scalar(inputs.dec[i]), &frame_alt, &frame_az);
+        sink = (double)frame_alt;
+    }, error);
+    report("Frame::setLST", tier, [&](int i) {
+        frame.setLST(inputs.az[i]);
+        sink = (double)frame.matrix[0][0];
+    }, 0.0);
+    astro.setPrecessionModel(PRECESSION_GILMORE);
+
+    // setAltAz
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec;
+        astro.setAltAz(inputs.alt[i], inputs.az[i]);
+        referenceRaDec(inputs.alt[i], inputs.az[i], LATITUDE, LST, &ra, &dec);
+        error = std::max(error, arcsec((double)astro.getRA(), ra) * (double)cosl(rad(dec)));
+        error = std::max(error, arcsec((double)astro.getDec(), dec));
+    }
+    report("AstroCalcs::setAltAz", tier, [&](int i) {
+        astro.setAltAz(inputs.alt[i], inputs.az[i]);
+        sink = (double)astro.getRA();
+    }, error);
+
+    // refract, checked against the formula over the altitudes the table covers (below them it is held)
+    BasicRefraction<Math> standard;
+    astro.setRefraction(&standard);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        astro.curr_pos = positions[i];
+        long double alt = (double)positions[i].getAlt();
+        if(alt < REFRACTION_LOWEST)
+        {
+            continue;
+        }
+        long double refracted = alt + (1.02L / tanl(rad(alt + 10.3L / (alt + 5.11L))) + 0.0019279L) / 60.0L;
+        AstroCalcsBenchmark::refract(astro);
+        error = std::max(error, arcsec((double)astro.curr_pos.getAlt(), refracted));
+    }
+    report("AstroCalcs::refract", tier, [&](int i) {
+        astro.curr_pos = positions[i];
+        AstroCalcsBenchmark::refract(astro);
+        sink = (double)astro.curr_pos.getAlt();
+    }, error);
+    astro.setRefraction(NULL);
+
+    // the formula the tables are built from, for comparison
+    report("refraction()", tier, [&](int i) {
+        sink = (double)refraction<Math>(typename Math::Scalar(inputs.alt[i]));
+    }, 0.0);
+
+    // the other way, in different weather, checked by iterating the formula
+    BasicRefraction<Math> tables;
+    tables.setWeather(850.0, -5.0);
+    long double weather = (850.0L / 1010.0L) * (283.0L / 268.0L);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double h = inputs.alt[i];
+        for(int k = 0; k < 50; k++)
+        {
+            h = inputs.alt[i] - weather * (1.02L / tanl(rad(h + 10.3L / (h + 5.11L))) + 0.0019279L) / 60.0L;
+        }
+        error = std::max(error, arcsec((double)tables.toTrue(typename Math::Scalar(inputs.alt[i])), h));
+    }
+    report("Refraction::toTrue", tier, [&](int i) {
+        sink = (double)tables.toTrue(typename Math::Scalar(inputs.alt[i]));
+    }, error);
+    report("Refraction::setWeather", tier, [&](int i) {
+        sink = tables.setWeather(850.0 + (i & 1), -5.0);
+    }, error, 1, 4, 200);
+
+    // Position::altAz
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az;
+        BasicPosition<Math> p = positions[i];
+        p.altAz();
+        referenceAltAz((double)p.getRA(), (double)p.getDec(), LATITUDE, (double)p.getLST(), &alt, &az);
+        error = std::max(error, positionError(p, (double)p.getRA(), (double)p.getDec(), alt, az));
+    }
+    report("Position::altAz", tier, [&](int i) {
+        positions[i].altAz();
+        sink = (double)positions[i].getAlt();
+    }, error);
+
+    // Position::updateLST
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az;
+        BasicPosition<Math> p = positions[i];
+        p.updateLST(inputs.az[i]);
+        referenceAltAz((double)p.getRA(), (double)p.getDec(), LATITUDE, inputs.az[i], &alt, &az);
+        error = std::max(error, positionError(p, (double)p.getRA(), (double)p.getDec(), alt, az));
+    }
+    report("Position::updateLST", tier, [&](int i) {
+        positions[i].updateLST(inputs.az[i]);
+        sink = (double)positions[i].getAlt();
+    }, error);
+
+    // Position::increment
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az;
+        BasicPosition<Math> p = positions[i];
+        long double reference_LST = wrapDegrees((double)p.getLST() + inputs.seconds[i] * (360.98564736629L / 86400.0L));
+        p.increment(inputs.seconds[i]);
+        referenceAltAz((double)p.getRA(), (double)p.getDec(), LATITUDE, reference_LST, &alt, &az);
+        error = std::max(error, positionError(p, (double)p.getRA(), (double)p.getDec(), alt, az));
+    }
+    report("Position::increment", tier, [&](int i) {
+        positions[i].increment(inputs.seconds[i]);
+        sink = (double)positions[i].getAlt();
+    }, error);
+
+    // Position::track, a night of samples a minute apart, reported per sample
+    const int samples = 240;
+    std::vector<BasicPosition<Math> > track(samples);
+    error = 0.0;
+    for(int i = 0; i < 64; i++)
+    {
+        positions[i].track(typename Math::Scalar(0.0), typename Math::Scalar(60.0), samples, &track[0]);
+        for(int k = 0; k < samples; k++)
+        {
+            long double alt, az;
+            referenceAltAz((double)positions[i].getRA(), (double)positions[i].getDec(), LATITUDE, (double)positions[i].getLST() + k * 60.0L * SIDEREAL_RATE, &alt, &az);
+            error = std::max(error, positionError(track[k], (double)positions[i].getRA(), (double)positions[i].getDec(), alt, az));
+        }
+    }
+    report("Position::track", tier, [&](int i) {
+        positions[i].track(typename Math::Scalar(0.0), typename Math::Scalar(60.0), samples, &track[0]);
+        sink = (double)track[samples - 1].getAlt();
+    }, error, samples, 1, 500);
+
+    // Trajectory::advance, one servo tick of a millisecond, over ten seconds so a few windows are fitted, and over an hour
+    // for the first few targets, so a tick that is not exact in the scalar type would show up as drift.
+    // The fits are checked against the tier's own Position, so the tolerance has to allow for its error.
+    typename Math::Scalar tolerance = typename Math::Scalar(std::max(1.0, 2.0 * error) / 3600.0);
+    error = 0.0;
+    for(int i = 0; i < 64; i++)
+    {
+        BasicTrajectory<Math> trajectory(typename Math::Scalar(TRAJECTORY_WINDOW), tolerance);
+        trajectory.start(positions[i]);
+        long ticks = (i < 8) ? 3600000L : 10000L;
+        for(long tick = 1; tick <= ticks; tick++)
+        {
+            trajectory.advance(0.001);
+            if(tick % 97 == 0)
+            {
+                long double alt, az;
+                referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, (double)positions[i].getLST() + tick * 0.001L * SIDEREAL_RATE, &alt, &az);
+                error = std::max(error, arcsec((double)trajectory.alt, alt));
+                error = std::max(error, arcsec((double)trajectory.az, az) * (double)cosl(rad(alt)));
+            }
+        }
+    }
+    BasicTrajectory<Math> trajectory(typename Math::Scalar(TRAJECTORY_WINDOW), tolerance);
+    trajectory.start(positions[0]);
+    report("Trajectory::advance", tier, [&](int) {
+        trajectory.advance(0.001);
+        sink = (double)trajectory.az;
+    }, error);
+
+    // TrackedSet::advance, a 10ms tick over the whole set, reported per target tracked. Checked over ten minutes against
+    // where each target is at the tick, with the same tolerance as the trajectory.
+    BasicTrackedSet<Math> tracked(INPUTS, typename Math::Scalar(LATITUDE), tolerance);
+    for(int i = 0; i < INPUTS; i++)
+    {
+        tracked.add(inputs.ra[i], inputs.dec[i]);
+    }
+    tracked.updateLST(astro.getLST());
+    error = 0.0;
+    long refreshed = 0;
+    for(int tick = 1; tick <= 60000; tick++)
+    {
+        refreshed += tracked.advance(0.01);
+        if(tick % 5000 == 0)
+        {
+            for(int i = 0; i < INPUTS; i++)
+            {
+                long double alt, az;
+                referenceAltAz((double)tracked.get(i).getRA(), inputs.dec[i], LATITUDE, (double)astro.getLST() + tick * 0.01L * SIDEREAL_RATE, &alt, &az);
+                error = std::max(error, positionError(tracked.get(i), (double)tracked.get(i).getRA(), inputs.dec[i], alt, az));
+            }
+        }
+    }
+    printf("%-32s %-7s %9.2f%% of the targets worked out per tick\n", "TrackedSet", tier, 100.0 * refreshed / (60000.0 * INPUTS));
+    report("TrackedSet::advance", tier, [&](int) {
+        sink = tracked.advance(0.01);
+    }, error, INPUTS, 1, 1000);
+}
+
+
+/**
+ * What the CrossingEvents benchmark checks each event against
+ */
+struct CrossingCheck
+{
+    /// @brief the local sidereal time at its clock's 0
+    double LST;
+
+    /// @brief the altitude the targets rise and set through
+    double altitude;
+
+    /// @brief the largest error, in arc-seconds
+    double error;
+
+    /// @brief the amount of events
+    long count;
+};
+
+
+/**
+ * Puts the time of an event back into the reference altitude (for rising and setting) or hour angle (for transits)
+ */
+static void checkCrossing(void* context, int index, uint8_t event, double time)
+{
+    CrossingCheck* check = (CrossingCheck*)context;
+    long double LST = check->LST + time * (long double)SIDEREAL_RATE;
+    long double alt, az;
+    referenceAltAz(inputs.ra[index], inputs.dec[index], LATITUDE, LST, &alt, &az);
+    if(event == CROSSING_TRANSIT)
+    {
+        long double ha = fmodl(LST - inputs.ra[index] + 540.0L, 360.0L) - 180.0L;
+        check->error = std::max(check->error, (double)fabsl(ha) * 3600.0);
+    }
+    else
+    {
+        check->error = std::max(check->error, (double)fabsl(alt - check->altitude) * 3600.0);
+    }
+    check->count++;
+}
+
+
+/**
+ * Runs the PositionBatch benchmarks, reported per target
+ */
+static void benchmarkBatch()
+{
+    PositionBatch batch(INPUTS, LATITUDE);
+    for(int i = 0; i < INPUTS; i++)
+    {
+        batch.add(inputs.ra[i], inputs.dec[i]);
+    }
+
+    double error = 0.0;
+    batch.updateLST(123.0);
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az;
+        referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, 123.0L, &alt, &az);
+        error = std::max(error, positionError(batch.get(i), inputs.ra[i], inputs.dec[i], alt, az));
+    }
+
+    // one call converts the whole batch, so the results are per target
+    report("PositionBatch::updateLST", AltAzKernels::name(), [&](int i) {
+        batch.updateLST(inputs.az[i]);
+        sink = (double)batch.alt[0];
+    }, error, INPUTS, 1, 500);
+
+    // a night of samples a minute apart for every target, reported per sample
+    const int samples = 240;
+    std::vector<double> track_alt((size_t)INPUTS * samples);
+    std::vector<double> track_az((size_t)INPUTS * samples);
+    batch.updateLST(123.0);
+    batch.track(0.0, 60.0, samples, &track_alt[0], &track_az[0]);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i += 16)
+    {
+        for(int k = 0; k < samples; k++)
+        {
+            long double alt, az;
+            referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, 123.0L + k * 60.0L * SIDEREAL_RATE, &alt, &az);
+            error = std::max(error, arcsec(track_alt[i * samples + k], alt));
+            error = std::max(error, arcsec(track_az[i * samples + k], az) * (double)cosl(rad(alt)));
+        }
+    }
+    report("PositionBatch::track", AltAzKernels::name(), [&](int) {
+        batch.track(0.0, 60.0, samples, &track_alt[0], &track_az[0]);
+        sink = track_alt[0];
+    }, error, INPUTS * samples, 1, 20);
+
+    // precess the whole batch with the matrix from AstroCalcs, going back to the J2000 coordinates each time
+    AstroCalcs astro(LONGITUDE, LATITUDE);
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+    astro.setPrecessionModel(PRECESSION_IAU2006);
+    long double jd = referenceJD(2024, 6, 15, 10, 30, 0);
+    long double LST = referenceLST(2024, 6, 15, 10, 30, 0, LONGITUDE);
+
+    batch.updateLST(astro.getLST());
+    batch.precess(astro.getPrecession());
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double ra, dec, alt, az;
+        referencePrecessIau2006(inputs.ra[i], inputs.dec[i], jd, &ra, &dec);
+        referenceAltAz(ra, dec, LATITUDE, LST, &alt, &az);
+        error = std::max(error, positionError(batch.get(i), ra, dec, alt, az));
+    }
+
+    report("PositionBatch::precess", AltAzKernels::name(), [&](int i) {
+        (void)i;
+        for(int j = 0; j < INPUTS; j++)
+        {
+            batch.set(j, inputs.ra[j], inputs.dec[j]);
+        }
+        batch.precess(astro.getPrecession());
+        sink = (double)batch.alt[0];
+    }, error, INPUTS, 1, 200);
+
+    // rise/transit/set with refraction, checked by putting the times back into the reference altitude
+    static double rise[INPUTS], transit[INPUTS], set[INPUTS];
+    static uint8_t kind[INPUTS];
+    for(int i = 0; i < INPUTS; i++)
+    {
+        batch.set(i, inputs.ra[i], inputs.dec[i]);
+    }
+    batch.updateLST(123.0);
+    batch.riseSet(rise, transit, set, kind);
+    long double horizon = RiseSet::horizon(0.0, 6);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az, highest;
+        referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, 123.0L + transit[i] * SIDEREAL_RATE, &highest, &az);
+        error = std::max(error, (double)fabsl(highest - (90.0L - fabsl(inputs.dec[i] - LATITUDE))) * 3600.0);
+        if(kind[i] == RISESET_RISES_AND_SETS)
+        {
+            referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, 123.0L + rise[i] * SIDEREAL_RATE, &alt, &az);
+            error = std::max(error, (double)fabsl(alt - horizon) * 3600.0);
+            referenceAltAz(inputs.ra[i], inputs.dec[i], LATITUDE, 123.0L + set[i] * SIDEREAL_RATE, &alt, &az);
+            error = std::max(error, (double)fabsl(alt - horizon) * 3600.0);
+        }
+    }
+
+    report("PositionBatch::riseSet", "exact", [&](int i) {
+        (void)i;
+        batch.riseSet(rise, transit, set, kind);
+        sink = rise[0];
+    }, error, INPUTS, 1, 500);
+
+    // the same catalog on a 1s tick, reported per tick for the whole catalog, to set against polling it with
+    // PositionBatch::updateLST. Checked over a day by putting each event's time back into the reference
+    CrossingEvents crossings(INPUTS, LATITUDE);
+    CrossingCheck check = {123.0, 10.0, 0.0, 0};
+    for(int i = 0; i < INPUTS; i++)
+    {
+        crossings.add(inputs.ra[i], inputs.dec[i], check.altitude, CROSSING_RISE | CROSSING_TRANSIT | CROSSING_SET);
+    }
+    crossings.setCallback(checkCrossing, &check);
+    crossings.reset(check.LST);
+    for(int tick = 0; tick < 86400; tick++)
+    {
+        crossings.advance(1.0);
+    }
+    printf("%-32s %-7s %9.2f events per target per day\n", "CrossingEvents", "exact", check.count / (double)INPUTS);
+    error = check.error;
+    crossings.setCallback(NULL, NULL);
+    report("CrossingEvents::advance", "exact", [&](int) {
+        sink = crossings.advance(1.0);
+    }, error, 1, 1, 20000);
+}
+
+
+/**
+ * Runs the SiteBatch benchmarks, reported per site, against one AstroCalcs per site
+ */
+static void benchmarkSites()
+{
+    SiteBatch sites(INPUTS);
+    for(int i = 0; i < INPUTS; i++)
+    {
+        // the azimuth and altitude inputs are spread over the right ranges for a longitude and latitude
+        sites.add(inputs.az[i] - 180.0, inputs.dec[i]);
+    }
+
+    AstroCalcs astro(LONGITUDE, LATITUDE);
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+    sites.altAz(inputs.ra[0], inputs.dec[0], astro.getGMST());
+    double error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double alt, az;
+        long double LST = referenceLST(2024, 6, 15, 10, 30, 0, sites.longitude[i]);
+        referenceAltAz(inputs.ra[0], inputs.dec[0], sites.latitude[i], LST, &alt, &az);
+        error = std::max(error, positionError(sites.get(i), inputs.ra[0], inputs.dec[0], alt, az));
+    }
+
+    // one time update, then every site for a different target each call
+    report("SiteBatch::altAz", AltAzKernels::name(), [&](int i) {
+        sites.altAz(inputs.ra[i], inputs.dec[i], astro.getGMST());
+        sink = sites.alt[0];
+    }, error, INPUTS, 1, 500);
+
+    // what it replaces: an AstroCalcs per site, each updating its own time
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        AstroCalcs site(sites.longitude[i], sites.latitude[i]);
+        site.updateTime(2024, 6, 15, 10, 30, 0);
+        site.setRADEC(inputs.ra[0], inputs.dec[0]);
+        long double alt, az;
+        long double LST = referenceLST(2024, 6, 15, 10, 30, 0, sites.longitude[i]);
+        referenceAltAz(inputs.ra[0], inputs.dec[0], sites.latitude[i], LST, &alt, &az);
+        error = std::max(error, positionError(site.curr_pos, inputs.ra[0], inputs.dec[0], alt, az));
+    }
+
+    report("AstroCalcs per site", "exact", [&](int i) {
+        AstroCalcs site(sites.longitude[i], sites.latitude[i]);
+        site.updateTime(2024, 6, 15, 10, 30, 0);
+        site.setRADEC(inputs.ra[i], inputs.dec[i]);
+        sink = site.curr_pos.getAlt();
+    }, error);
+}
+
+
+/**
+ * Runs the SkyIndex benchmarks against a full scan with `Position`. The error is the furthest (in arc-seconds) that a target
+ * the two disagree on is from the edge of the query, so anything but rounding on the edge shows up.
+ */
+static void benchmarkIndex()
+{
+    std::vector<double> ra(CATALOG), dec(CATALOG);
+    SkyIndex index(CATALOG);
+    for(int i = 0; i < CATALOG; i++)
+    {
+        ra[i] = 360.0 * rand() / ((double)RAND_MAX + 1.0);
+        dec[i] = degrees(asin(-1.0 + 2.0 * rand() / (double)RAND_MAX));
+        index.add(ra[i], dec[i]);
+    }
+    index.build();
+
+    std::vector<int> found(CATALOG);
+    std::vector<char> hit(CATALOG);
+
+    // every target above 30 degrees, checked against the altitude of each target from Position
+    double error = 0.0;
+    for(int q = 0; q < 16; q++)
+    {
+        double LST = inputs.az[q];
+        std::fill(hit.begin(), hit.end(), 0);
+        int n = index.above(LST, LATITUDE, 30.0, found.data(), CATALOG);
+        for(int j = 0; j < n; j++)
+        {
+            hit[found[j]] = 1;
+        }
+        for(int i = 0; i < CATALOG; i++)
+        {
+            Position p(ra[i], dec[i], LATITUDE, LST);
+            if((p.getAlt() >= 30.0) != (hit[i] != 0))
+            {
+                error = std::max(error, fabs(p.getAlt() - 30.0) * 3600.0);
+            }
+        }
+    }
+
+    report("SkyIndex::above 30", "exact", [&](int i) {
+        sink = index.above(inputs.az[i], LATITUDE, 30.0, found.data(), CATALOG);
+    }, error, 1, 1, 200);
+
+    report("Position scan above 30", "exact", [&](int i) {
+        int n = 0;
+        for(int j = 0; j < CATALOG; j++)
+        {
+            Position p(ra[j], dec[j], LATITUDE, inputs.az[i]);
+            if(p.getAlt() >= 30.0)
+            {
+                found[n++] = j;
+            }
+        }
+        sink = n;
+    }, 0.0, 1, 1, 20);
+
+    // every target within 2 degrees of a point, checked against the angle to each target
+    error = 0.0;
+    for(int q = 0; q < 256; q++)
+    {
+        std::fill(hit.begin(), hit.end(), 0);
+        int n = index.cone(inputs.ra[q], inputs.dec[q], 2.0, found.data(), CATALOG);
+        for(int j = 0; j < n; j++)
+        {
+            hit[found[j]] = 1;
+        }
+        for(int i = 0; i < CATALOG; i++)
+        {
+            long double c = sinl(rad(dec[i])) * sinl(rad(inputs.dec[q]))
+                          + cosl(rad(dec[i])) * cosl(rad(inputs.dec[q])) * cosl(rad(ra[i] - inputs.ra[q]));
+            long double distance = deg(acosl(std::min(1.0L, c)));
+            if((distance <= 2.0L) != (hit[i] != 0))
+            {
+                error = std::max(error, (double)fabsl(distance - 2.0L) * 3600.0);
+            }
+        }
+    }
+
+    report("SkyIndex::cone 2", "exact", [&](int i) {
+        sink = index.cone(inputs.ra[i], inputs.dec[i], 2.0, found.data(), CATALOG);
+    }, error, 1, 16, 2000);
+}
+
+
+/**
+ * Runs the Catalog benchmarks: opening a catalog in place, and converting it straight from its columns
+ */
+static void benchmarkCatalog()
+{
+    std::vector<double> ra(CATALOG), dec(CATALOG);
+    std::vector<float> mag(CATALOG);
+    std::vector<uint32_t> id(CATALOG);
+    for(int i = 0; i < CATALOG; i++)
+    {
+        ra[i] = inputs.ra[i % INPUTS];
+        dec[i] = inputs.dec[i % INPUTS];
+        mag[i] = 6.0f;
+        id[i] = (uint32_t)i;
+    }
+    std::vector<double> buffer((Catalog::bytes(CATALOG) + 7) / 8);
+    Catalog::write(buffer.data(), Catalog::bytes(CATALOG), ra.data(), dec.data(), mag.data(), id.data(), CATALOG, 2000.0);
+
+    // open only reads the header, so this is per catalog of CATALOG targets
+    Catalog catalog;
+    report("Catalog::open 100k", "exact", [&](int) {
+        sink = catalog.open(buffer.data(), Catalog::bytes(CATALOG));
+    }, 0.0);
+
+    std::vector<double> ha(CATALOG), alt(CATALOG), az(CATALOG);
+    double sin_l = sin(radians(LATITUDE)), cos_l = cos(radians(LATITUDE));
+    AltAzKernels::altAz(catalog.ra, catalog.z, catalog.cosDec, 123.0, sin_l, cos_l, ha.data(), alt.data(), az.data(), CATALOG);
+    double error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double reference_alt, reference_az;
+        referenceAltAz(ra[i], dec[i], LATITUDE, 123.0L, &reference_alt, &reference_az);
+        error = std::max(error, arcsec(alt[i], reference_alt));
+        error = std::max(error, arcsec(az[i], reference_az) * (double)cosl(rad(reference_alt)));
+    }
+
+    report("AltAzKernels::altAz on Catalog", AltAzKernels::name(), [&](int i) {
+        AltAzKernels::altAz(catalog.ra, catalog.z, catalog.cosDec, inputs.az[i], sin_l, cos_l, ha.data(), alt.data(), az.data(), CATALOG);
+        sink = alt[0];
+    }, error, CATALOG, 1, 50);
+
+    // J2000 straight to the horizon with precession and nutation, one matrix a time step, against the true place
+    AstroCalcs astro(LONGITUDE, LATITUDE);
+    astro.setPrecessionModel(PRECESSION_IAU2006);
+    astro.updateTime(2024, 6, 15, 10, 30, 0);
+    long double jd = referenceJD(2024, 6, 15, 10, 30, 0);
+    long double LST = referenceLST(2024, 6, 15, 10, 30, 0, LONGITUDE);
+    Frame frame(LATITUDE);
+    frame.update(astro.getPrecession(), &astro.getNutation());
+    frame.setLST(astro.getLST());
+    frame.altAz(catalog.x, catalog.y, catalog.z, alt.data(), az.data(), CATALOG);
+    error = 0.0;
+    for(int i = 0; i < INPUTS; i++)
+    {
+        long double reference_ra, reference_dec, reference_alt, reference_az;
+        referencePrecessIau2006(ra[i], dec[i], jd, &reference_ra, &reference_dec);
+        referenceApparent(reference_ra, reference_dec, jd, &reference_ra, &reference_dec, false);
+        referenceAltAz(reference_ra, reference_dec, LATITUDE, LST, &reference_alt, &reference_az);
+        error = std::max(error, arcsec(alt[i], reference_alt));
+        error = std::max(error, arcsec(az[i], reference_az) * (double)cosl(rad(reference_alt)));
+    }
+
+    report("Frame::altAz on Catalog", AltAzKernels::name(), [&](int i) {
+        frame.setLST(inputs.az[i]);
+        frame.altAz(catalog.x, catalog.y, catalog.z, alt.data(), az.data(), CATALOG);
+        sink = alt[0];
+    }, error, CATALOG, 1, 50);
+}
+
+
+int main()
+{
+    printf("%-32s %-7s %10s %9s %9s %9s %14s\n", "function", "tier", "M/s", "p50 ns", "p90 ns", "p99 ns", "max error (\")");
+    benchmarkTier<ExactMath>("exact");
+    benchmarkTier<ArcsecMath>("arcsec");
+    benchmarkTier<ArcminMath>("arcmin");
+    benchmarkTier<FloatMath>("float");
+    benchmarkTier<FixedMath>("fixed");
+    benchmarkBatch();
+    benchmarkSites();
+    benchmarkIndex();
+    benchmarkCatalog();
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Host tool that turns a text catalog into the binary format read by `Catalog`.
+//
+// Build from the root of the library:
+//
+//     g++ -O2 -std=gnu++11 -Iextras/host -Isrc extras/catalog/make_catalog.cpp src/Catalog.cpp -o make_catalog
+//
+// The input has one target per line, `ra dec magnitude id` (ra and dec in degrees), and lines starting with # are skipped.
+//
+//     ./make_catalog stars.txt stars.acat              a file for Catalog::openFile()
+//     ./make_catalog stars.txt stars.h STARS           a header with `const uint8_t STARS[]` for Catalog::open() from flash
+//
+// An epoch other than J2000 can be given with --epoch 2024.5 before the file names.
+
+#include "Arduino.h"
+#include "Catalog.h"
+
+#include <vector>
+
+
+/**
+ * Writes the catalog as a C array, aligned so the double columns can be used in place
+ *
+ * @param out the file to write to
+ * @param name the name of the array
+ * @param data the catalog
+ * @param size the length of the catalog in bytes
+ */
+static void writeHeader(FILE* out, const char* name, const uint8_t* data, unsigned long size)
+{
+    fprintf(out, "// made by extras/catalog/make_catalog, open with Catalog::open(%s, sizeof(%s))\n", name, name);
+    fprintf(out, "#include \"Arduino.h\"\n\n");
+    fprintf(out, "alignas(8) static const uint8_t %s[%lu] PROGMEM = {", name, size);
+    for(unsigned long i = 0; i < size; i++)
+    {
+        fprintf(out, "%s0x%02x,", (i % 16 == 0) ? "\n    " : " ", data[i]);
+    }
+    fprintf(out, "\n};\n");
+}
+
+
+int main(int argc, char** argv)
+{
+    double epoch = 2000.0;
+    int arg = 1;
+    if(argc > 2 && strcmp(argv[1], "--epoch") == 0)
+    {
+        epoch = atof(argv[2]);
+        arg = 3;
+    }
+    if(argc - arg != 2 && argc - arg != 3)
+    {
+        fprintf(stderr, "usage: %s [--epoch year] input.txt output.acat\n"
+                        "       %s [--epoch year] input.txt output.h ARRAY_NAME\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[arg], "r");
+    if(!in)
+    {
+        fprintf(stderr, "cannot read %s\n", argv[arg]);
+        return 1;
+    }
+
+    std::vector<double> ra, dec;
+    std::vector<float> mag;
+    std::vector<uint32_t> id;
+    char line[256];
+    int number = 0;
+    while(fgets(line, sizeof(line), in))
+    {
+        number++;
+        double r, d;
+        float m;
+        unsigned long i;
+        if(line[0] == '#' || line[0] == '\n')
+        {
+            continue;
+        }
+        if(sscanf(line, "%lf %lf %f %lu", &r, &d, &m, &i) != 4)
+        {
+            fprintf(stderr, "%s:%d: expected `ra dec magnitude id`\n", argv[arg], number);
+            fclose(in);
+            return 1;
+        }
+        ra.push_back(r);
+        dec.push_back(d);
+        mag.push_back(m);
+        id.push_back((uint32_t)i);
+    }
+    fclose(in);
+
+    int n = (int)ra.size();
+    unsigned long size = Catalog::bytes(n);
+
+    // doubles, so the buffer is 8-byte aligned
+    std::vector<double> buffer((size + 7) / 8);
+    Catalog::write(buffer.data(), size, ra.data(), dec.data(), mag.data(), id.data(), n, epoch);
+
+    FILE* out = fopen(argv[arg + 1], "wb");
+    if(!out)
+    {
+        fprintf(stderr, "cannot write %s\n", argv[arg + 1]);
+        return 1;
+    }
+    if(argc - arg == 3)
+    {
+        writeHeader(out, argv[arg + 2], (const uint8_t*)buffer.data(), size);
+    }
+    else
+    {
+        fwrite(buffer.data(), 1, size, out);
+    }
+    fclose(out);
+
+    fprintf(stderr, "%d targets, %lu bytes\n", n, size);
+    return 0;
+}
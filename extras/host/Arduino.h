@@ -0,0 +1,194 @@
+/**
+ * @file Arduino.h
+ * @brief The parts of the Arduino core that AstroCalcs uses, for building the library on a workstation
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Put extras/host before src on the include path (`-Iextras/host -Isrc`) and this file stands in for the real Arduino.h.
+// Only what the library needs is here: PI, radians(), degrees(), PROGMEM, micros(), millis(), a String that behaves like Arduino's,
+// and a Print with a Serial that writes to stdout.
+
+#ifndef ARDUINO_H
+
+#define ARDUINO_H 1
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+
+// there is no separate flash on a workstation, so tables are read like any other memory
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+/**
+ * @returns microseconds since the program started
+ */
+inline unsigned long micros()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @returns milliseconds since the program started
+ */
+inline unsigned long millis()
+{
+    return micros() / 1000UL;
+}
+
+/**
+ * A copy of the Arduino String API that the library uses, on top of std::string.
+ *
+ * Numbers are formatted the way Arduino formats them, so `String(1.23456)` is `"1.23"`.
+ */
+class String
+{
+    public:
+        String() {}
+        String(const char* s) : _s(s ? s : "") {}
+        String(const std::string& s) : _s(s) {}
+        String(char c) : _s(1, c) {}
+        String(int v) : _s(std::to_string(v)) {}
+        String(unsigned int v) : _s(std::to_string(v)) {}
+        String(long v) : _s(std::to_string(v)) {}
+        String(unsigned long v) : _s(std::to_string(v)) {}
+
+        String(double v, unsigned int decimals = 2)
+        {
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, v);
+            _s = buffer;
+        }
+
+        String(float v, unsigned int decimals = 2)
+        {
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, (double)v);
+            _s = buffer;
+        }
+
+        String operator+(const String& other) const { return String(_s + other._s); }
+        String operator+(const char* other) const { return String(_s + other); }
+        friend String operator+(const char* a, const String& b) { return String(std::string(a) + b._s); }
+        String& operator+=(const String& other) { _s += other._s; return *this; }
+        String& operator+=(char c) { _s += c; return *this; }
+        bool operator==(const String& other) const { return _s == other._s; }
+        bool operator!=(const String& other) const { return _s != other._s; }
+        char operator[](unsigned int i) const { return _s[i]; }
+
+        int indexOf(const char* s, unsigned int from = 0) const
+        {
+            size_t i = _s.find(s, from);
+            return (i == std::string::npos) ? -1 : (int)i;
+        }
+
+        int indexOf(char c, unsigned int from = 0) const
+        {
+            size_t i = _s.find(c, from);
+            return (i == std::string::npos) ? -1 : (int)i;
+        }
+
+        String substring(unsigned int from) const
+        {
+            return (from >= _s.size()) ? String() : String(_s.substr(from));
+        }
+
+        String substring(unsigned int from, unsigned int to) const
+        {
+            if(from > to)
+            {
+                unsigned int t = from;
+                from = to;
+                to = t;
+            }
+            if(from >= _s.size())
+            {
+                return String();
+            }
+            return String(_s.substr(from, to - from));
+        }
+
+        long toInt() const { return atol(_s.c_str()); }
+        float toFloat() const { return (float)atof(_s.c_str()); }
+        double toDouble() const { return atof(_s.c_str()); }
+        unsigned int length() const { return (unsigned int)_s.size(); }
+        unsigned char reserve(unsigned int size) { _s.reserve(size); return 1; }
+        const char* c_str() const { return _s.c_str(); }
+
+    private:
+        std::string _s;
+};
+
+/**
+ * The part of Arduino's Print that the library uses. Like Arduino's, it writes through `write(uint8_t)`.
+ */
+class Print
+{
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+
+        size_t print(const char* s)
+        {
+            size_t n = 0;
+            while(*s)
+            {
+                n += write((uint8_t)*s++);
+            }
+            return n;
+        }
+
+        size_t print(const String& s) { return print(s.c_str()); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int v) { return print((long)v); }
+        size_t print(unsigned int v) { return print((unsigned long)v); }
+        size_t print(long v) { return print(String(v)); }
+        size_t print(unsigned long v) { return print(String(v)); }
+        size_t print(double v, int decimals = 2) { return print(String(v, (unsigned int)decimals)); }
+        size_t println() { return write('\r') + write('\n'); }
+        template<class T> size_t println(T v) { return print(v) + println(); }
+};
+
+/**
+ * A Serial that writes to stdout
+ */
+class HostSerial : public Print
+{
+    public:
+        void begin(unsigned long) {}
+        size_t write(uint8_t c) { return putchar(c) == EOF ? 0 : 1; }
+};
+
+static HostSerial Serial;
+
+#endif
@@ -0,0 +1,575 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Host tool that converts a stream of timestamped targets with a pool of threads.
+//
+// Build from the root of the library:
+//
+//     g++ -O2 -std=gnu++11 -pthread -Iextras/host -Isrc extras/pipeline/pipeline.cpp src/*.cpp -o astrocalcs_pipeline
+//
+// Each record is a timestamp (Unix seconds, UTC, fractions allowed) and a target:
+//
+//     ./astrocalcs_pipeline --longitude 172.5 --latitude -43.5 targets.csv out.csv
+//         reads `timestamp,ra,dec` (J2000) and writes `timestamp,ra,dec,alt,az` (of date) with calcPosJ2000()
+//     ./astrocalcs_pipeline --altaz ... encoders.csv out.csv
+//         reads `timestamp,alt,az` and writes `timestamp,ra,dec` with setAltAz()
+//
+// `-` reads stdin or writes stdout. With --binary the records are native doubles instead of text: 3 per input record,
+// and 5 (or 3 with --altaz) per output record. Lines that do not start with a number (headers, comments) are skipped.
+//
+// One thread reads the input into batches of whole lines (or records) without looking inside them, --threads workers (all
+// cores by default) parse, convert and format them, and one thread writes the text out in the order it was read, so the
+// only serial work is copying bytes. There is a fixed pool of batches, so a slow writer holds up the reader instead of
+// using more memory. The records per second are reported on stderr at the end.
+
+#include "Arduino.h"
+#include "AstroCalcs.h"
+
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// records (or lines) per batch, so the queues are not locked per record
+#define PIPELINE_BATCH 4096
+
+// bytes of input per batch, at most. A batch ends at the last whole line that fits.
+#define PIPELINE_INPUT_BYTES (PIPELINE_BATCH * 64)
+
+// bytes of output per record, at most. A record whose text would be longer (from a wild input value) is left out.
+#define PIPELINE_RECORD_BYTES 128
+
+// batches in flight per worker, so every worker has the next batch waiting while the writer catches up
+#define PIPELINE_BATCHES_PER_WORKER 4
+
+/**
+ * A block of records that goes through the pipeline together
+ */
+struct Batch
+{
+    /// @brief where the batch is in the input, so the writer can put them back in order
+    long sequence;
+
+    /// @brief amount of records the worker converted
+    int count;
+
+    /// @brief bytes in `input`
+    size_t inputLength;
+
+    /// @brief bytes in `output`
+    size_t outputLength;
+
+    /// @brief the raw input: whole lines, or whole binary records. One more byte for a terminator after the last line.
+    char input[PIPELINE_INPUT_BYTES + 1];
+
+    /// @brief the output as it is written, text or binary
+    char output[PIPELINE_BATCH * PIPELINE_RECORD_BYTES];
+};
+
+
+/**
+ * A first in, first out queue with a fixed capacity, where `push()` waits while it is full and `pop()` waits while it is empty
+ */
+template<class T> class BoundedQueue
+{
+    public:
+        BoundedQueue(int capacity) : _items(capacity), _head(0), _count(0), _closed(false) {}
+
+        /**
+         * @param item the item to add, waiting for room if the queue is full
+         */
+        void push(T item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [&] { return _count < (int)_items.size(); });
+            _items[(_head + _count) % _items.size()] = item;
+            _count++;
+            _notEmpty.notify_one();
+        }
+
+        /**
+         * @param item where the item will be set, waiting for one if the queue is empty
+         * @returns false once the queue is closed and empty
+         */
+        bool pop(T* item)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notEmpty.wait(lock, [&] { return _count > 0 || _closed; });
+            if(_count == 0)
+            {
+                return false;
+            }
+            *item = _items[_head];
+            _head = (_head + 1) % _items.size();
+            _count--;
+            _notFull.notify_one();
+            return true;
+        }
+
+        /**
+         * No more items will be pushed, so every `pop()` returns false once the queue is empty
+         */
+        void close()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _closed = true;
+            _notEmpty.notify_all();
+        }
+
+    private:
+        std::vector<T> _items;
+        int _head;
+        int _count;
+        bool _closed;
+        std::mutex _mutex;
+        std::condition_variable _notEmpty;
+        std::condition_variable _notFull;
+};
+
+
+/**
+ * The batches a worker has finished, held until the writer gets to them
+ */
+class Reorder
+{
+    public:
+        Reorder(int slots) : _slots(slots, (Batch*)0), _closed(false) {}
+
+        /**
+         * @param batch a finished batch. Its sequence is never more than the number of batches ahead of the writer.
+         */
+        void put(Batch* batch)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _slots[batch->sequence % _slots.size()] = batch;
+            _ready.notify_all();
+        }
+
+        /**
+         * @param sequence the batch the writer needs next
+         * @returns the batch, or 0 once there are no more
+         */
+        Batch* take(long sequence)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            Batch** slot = &_slots[sequence % _slots.size()];
+            _ready.wait(lock, [&] { return (*slot && (*slot)->sequence == sequence) || (_closed && sequence >= _end); });
+            Batch* batch = *slot;
+            if(!batch || batch->sequence != sequence)
+            {
+                return 0;
+            }
+            *slot = 0;
+            return batch;
+        }
+
+        /**
+         * @param end the amount of batches the reader made
+         */
+        void close(long end)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _closed = true;
+            _end = end;
+            _ready.notify_all();
+        }
+
+    private:
+        std::vector<Batch*> _slots;
+        bool _closed;
+        long _end;
+        std::mutex _mutex;
+        std::condition_variable _ready;
+};
+
+
+/**
+ * Everything the command line sets
+ */
+struct Options
+{
+    double longitude = 0.0;
+    double latitude = 0.0;
+    int threads = 0;
+    bool altaz = false;
+    bool binary = false;
+    const char* input = "-";
+    const char* output = "-";
+};
+
+
+/**
+ * Reads the input into batches of whole lines (or binary records), carrying a part line over to the next batch
+ */
+class Reader
+{
+    public:
+        Reader(FILE* in, const Options& options) : _in(in), _options(options), _carry(PIPELINE_INPUT_BYTES), _carried(0),
+                                                   _end(false) {}
+
+        /**
+         * Reads up to `PIPELINE_BATCH` lines (or records), and at most `PIPELINE_INPUT_BYTES`
+         *
+         * @param batch where the input will be copied
+         * @returns acts in place on the batch, setting its input length, which is 0 at the end of the input
+         */
+        void read(Batch* batch)
+        {
+            memcpy(batch->input, &_carry[0], _carried);
+            size_t length = _carried;
+            size_t want = this->_options.binary ? PIPELINE_BATCH * 3 * sizeof(double) : PIPELINE_INPUT_BYTES;
+            while(!_end && length < want)
+            {
+                size_t got = fread(batch->input + length, 1, want - length, _in);
+                length += got;
+                if(got == 0)
+                {
+                    _end = true;
+                }
+            }
+
+            size_t cut = this->_options.binary ? length - length % (3 * sizeof(double)) : this->lines(batch->input, length);
+            _carried = length - cut;
+            memcpy(&_carry[0], batch->input + cut, _carried);
+            batch->inputLength = cut;
+        }
+
+    private:
+        /**
+         * @param text the input read so far
+         * @param length the bytes in it
+         * @returns the length of the first `PIPELINE_BATCH` whole lines, or of all of them
+         */
+        size_t lines(const char* text, size_t length)
+        {
+            size_t cut = 0;
+            for(int line = 0; line < PIPELINE_BATCH; line++)
+            {
+                const char* newline = (const char*)memchr(text + cut, '\n', length - cut);
+                if(!newline)
+                {
+                    break;
+                }
+                cut = (size_t)(newline - text) + 1;
+            }
+
+            // the last line of a file needs no newline, and a line longer than a batch is cut where the batch is full
+            if(cut == 0 && (_end || length == PIPELINE_INPUT_BYTES))
+            {
+                return length;
+            }
+            return cut;
+        }
+
+        FILE* _in;
+        const Options& _options;
+        std::vector<char> _carry;
+        size_t _carried;
+        bool _end;
+};
+
+
+/**
+ * Parses one line of text
+ *
+ * @param line the line, ending in a null
+ * @param record where the timestamp and two coordinates will be set
+ * @returns false if the line does not hold three numbers (a header, a comment)
+ */
+static bool parseLine(const char* line, double* record)
+{
+    char* end;
+    record[0] = strtod(line, &end);
+    if(end == line || *end != ',')
+    {
+        return false;
+    }
+    const char* next = end + 1;
+    record[1] = strtod(next, &end);
+    if(end == next || *end != ',')
+    {
+        return false;
+    }
+    next = end + 1;
+    record[2] = strtod(next, &end);
+    return end != next;
+}
+
+
+/**
+ * Converts batches until the work queue is closed: parses each record, converts it and formats the output, so all of the
+ * text work is split between the workers. Each worker has its own `AstroCalcs`, and only calls `updateTime()` when the
+ * whole second changes; the fraction of a second is put on with `advance()`.
+ *
+ * @param options the command line
+ * @param work the batches to convert
+ * @param done where the converted batches go
+ */
+static void worker(const Options& options, BoundedQueue<Batch*>* work, Reorder* done)
+{
+    AstroCalcs astro(options.longitude, options.latitude);
+    long long second = -1;
+    double fraction = 0.0;
+    int fields = options.altaz ? 3 : 5;
+
+    Batch* batch;
+    while(work->pop(&batch))
+    {
+        batch->count = 0;
+        batch->outputLength = 0;
+        batch->input[batch->inputLength] = '\0';
+        size_t at = 0;
+        while(at < batch->inputLength)
+        {
+            double record[3];
+            if(options.binary)
+            {
+                memcpy(record, batch->input + at, sizeof(record));
+                at += sizeof(record);
+            }
+            else
+            {
+                // one line at a time, ended with a null so strtod cannot run on into the next line
+                char* line = batch->input + at;
+                char* newline = (char*)memchr(line, '\n', batch->inputLength - at);
+                at = newline ? (size_t)(newline - batch->input) + 1 : batch->inputLength;
+                if(newline)
+                {
+                    *newline = '\0';
+                }
+                if(!parseLine(line, record))
+                {
+                    continue;
+                }
+            }
+
+            long long whole = (long long)floor(record[0]);
+            if(whole != second)
+            {
+                time_t t = (time_t)whole;
+                struct tm utc;
+                gmtime_r(&t, &utc);
+                astro.updateTime(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec);
+                second = whole;
+                fraction = 0.0;
+            }
+            double f = record[0] - (double)whole;
+            if(f != fraction)
+            {
+                astro.advance(f - fraction);
+                fraction = f;
+            }
+
+            double result[5];
+            result[0] = record[0];
+            if(options.altaz)
+            {
+                astro.setAltAz(record[1], record[2]);
+                result[1] = astro.getRA();
+                result[2] = astro.getDec();
+            }
+            else
+            {
+                astro.calcPosJ2000(record[1], record[2]);
+                result[1] = astro.curr_pos.getRA();
+                result[2] = astro.curr_pos.getDec();
+                result[3] = astro.curr_pos.getAlt();
+                result[4] = astro.curr_pos.getAz();
+            }
+
+            char* text = batch->output + batch->outputLength;
+            int length;
+            if(options.binary)
+            {
+                length = (int)(fields * sizeof(double));
+                memcpy(text, result, length);
+            }
+            else if(options.altaz)
+            {
+                length = snprintf(text, PIPELINE_RECORD_BYTES, "%.3f,%.8f,%.8f\n", result[0], result[1], result[2]);
+            }
+            else
+            {
+                length = snprintf(text, PIPELINE_RECORD_BYTES, "%.3f,%.8f,%.8f,%.8f,%.8f\n", result[0], result[1], result[2],
+                                  result[3], result[4]);
+            }
+            if(length < 0 || length >= PIPELINE_RECORD_BYTES)
+            {
+                continue;
+            }
+            batch->outputLength += length;
+            batch->count++;
+        }
+        done->put(batch);
+    }
+}
+
+
+/**
+ * Reads the command line
+ *
+ * @param argc the amount of arguments
+ * @param argv the arguments
+ * @param options where the options will be set
+ * @returns false if the command line is wrong
+ */
+static bool parse(int argc, char** argv, Options* options)
+{
+    int files = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--longitude") == 0 && i + 1 < argc)
+        {
+            options->longitude = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--latitude") == 0 && i + 1 < argc)
+        {
+            options->latitude = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            options->threads = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--altaz") == 0)
+        {
+            options->altaz = true;
+        }
+        else if(strcmp(argv[i], "--binary") == 0)
+        {
+            options->binary = true;
+        }
+        else if(files == 0)
+        {
+            options->input = argv[i];
+            files++;
+        }
+        else if(files == 1)
+        {
+            options->output = argv[i];
+            files++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if(options->threads <= 0)
+    {
+        options->threads = (int)std::thread::hardware_concurrency();
+    }
+    if(options->threads <= 0)
+    {
+        options->threads = 1;
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if(!parse(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--longitude deg] [--latitude deg] [--threads n] [--altaz] [--binary] [input|-] [output|-]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = (strcmp(options.input, "-") == 0) ? stdin : fopen(options.input, options.binary ? "rb" : "r");
+    FILE* out = (strcmp(options.output, "-") == 0) ? stdout : fopen(options.output, options.binary ? "wb" : "w");
+    if(!in || !out)
+    {
+        fprintf(stderr, "cannot open %s\n", !in ? options.input : options.output);
+        return 1;
+    }
+    static char inBuffer[1 << 20], outBuffer[1 << 20];
+    setvbuf(in, inBuffer, _IOFBF, sizeof(inBuffer));
+    setvbuf(out, outBuffer, _IOFBF, sizeof(outBuffer));
+
+    // every batch there will ever be, which is all the memory the pipeline uses however long the stream is
+    int slots = options.threads * PIPELINE_BATCHES_PER_WORKER;
+    std::vector<Batch> batches(slots);
+    BoundedQueue<Batch*> spare(slots);
+    BoundedQueue<Batch*> work(slots);
+    Reorder done(slots);
+    for(int i = 0; i < slots; i++)
+    {
+        spare.push(&batches[i]);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < options.threads; i++)
+    {
+        workers.push_back(std::thread(worker, std::cref(options), &work, &done));
+    }
+
+    long records = 0;
+    std::thread writer([&] {
+        for(long sequence = 0; ; sequence++)
+        {
+            Batch* batch = done.take(sequence);
+            if(!batch)
+            {
+                return;
+            }
+            fwrite(batch->output, 1, batch->outputLength, out);
+            records += batch->count;
+            spare.push(batch);
+        }
+    });
+
+    // the reader: a batch can only be read once the writer has given one back
+    Reader reader(in, options);
+    long sequence = 0;
+    while(true)
+    {
+        Batch* batch = 0;
+        spare.pop(&batch);
+        reader.read(batch);
+        if(batch->inputLength == 0)
+        {
+            break;
+        }
+        batch->sequence = sequence++;
+        work.push(batch);
+    }
+
+    work.close();
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    done.close(sequence);
+    writer.join();
+    fflush(out);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%ld records in %.3f s, %.0f records/s with %d threads\n", records, seconds, records / seconds, options.threads);
+
+    if(in != stdin)
+    {
+        fclose(in);
+    }
+    if(out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
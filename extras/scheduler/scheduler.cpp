@@ -0,0 +1,713 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Host tool that plans a night of observations for a list of targets.
+//
+// Build from the root of the library:
+//
+//     g++ -O2 -std=gnu++11 -pthread -Iextras/host -Isrc extras/scheduler/scheduler.cpp src/*.cpp -o astrocalcs_scheduler
+//
+// The input has one target per line, `ra dec [priority [minutes [id]]]` (J2000, in degrees), and lines starting with #
+// are skipped. The priority defaults to 1 and the exposure to one time step. --random n makes up n targets instead.
+//
+//     ./astrocalcs_scheduler --longitude 172.5 --latitude -43.5 --start 2024-06-15T08:00:00 --hours 10 targets.txt plan.csv
+//
+// First the altitude, azimuth and airmass of every target at every time step (--step minutes apart, 5 by default) are
+// worked out into targets x steps matrices. Each step has one `Frame` matrix from J2000 to the horizon, so a target costs
+// a matrix-vector product and two arctangents, and the matrices are split into tiles of steps by targets that a
+// work-stealing pool of --threads workers (all cores by default) runs through. Each worker starts on its own run of tiles,
+// and one that runs out takes tiles from the far end of another's, so uneven tiles do not leave cores idle.
+//
+// Then a greedy allocator walks through the night. At each point it takes, of the targets not yet observed that stay
+// above --min-altitude (30 degrees) and under --max-airmass (2) from the end of the slew to the end of the exposure, the
+// one with the highest priority over airmass, and the shortest slew between equals. A slew takes the larger of the
+// azimuth and altitude moves over --slew degrees a second (2), plus --settle seconds (30). When nothing can be observed it
+// waits for the next step.
+//
+// The plan is written as CSV, one observation per line, and the times taken are reported on stderr. Altitudes are true
+// (airless) ones, as refraction does not matter to a limit of a few tens of degrees.
+
+#include "Arduino.h"
+#include "AstroCalcs.h"
+#include "Frame.h"
+
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// targets per tile, so a tile's rows fit in the L1 cache and there are enough tiles to share out
+#define SCHEDULER_TILE 1024
+
+
+/**
+ * A pool of threads that runs numbered tasks, where each worker has its own queue and takes from the others' when it is empty
+ */
+class WorkStealingPool
+{
+    public:
+        /**
+         * @param threads the amount of workers
+         */
+        WorkStealingPool(int threads) : _queues(threads), _task(0), _active(0), _generation(0), _stop(false)
+        {
+            for(int i = 0; i < threads; i++)
+            {
+                _queues[i].reset(new Queue());
+            }
+            for(int i = 0; i < threads; i++)
+            {
+                _threads.push_back(std::thread(&WorkStealingPool::loop, this, i));
+            }
+        }
+
+        ~WorkStealingPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _stop = true;
+                _start.notify_all();
+            }
+            for(size_t i = 0; i < _threads.size(); i++)
+            {
+                _threads[i].join();
+            }
+        }
+
+        /**
+         * Runs `task(0)` to `task(tasks - 1)` on the workers, and waits for all of them
+         *
+         * @param tasks the amount of tasks
+         * @param task the work, which can be called on any worker in any order
+         */
+        void run(int tasks, const std::function<void(int)>& task)
+        {
+            if(tasks <= 0)
+            {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            _task = &task;
+
+            // each worker gets a run of neighbouring tasks, which tend to share cache lines
+            int workers = (int)_queues.size();
+            for(int w = 0; w < workers; w++)
+            {
+                std::unique_lock<std::mutex> queue(_queues[w]->mutex);
+                for(int i = (int)((long)tasks * w / workers); i < (int)((long)tasks * (w + 1) / workers); i++)
+                {
+                    _queues[w]->tasks.push_back(i);
+                }
+            }
+
+            // every worker has to have finished with `task` before it goes out of scope, not just every task
+            _active = workers;
+            _generation++;
+            _start.notify_all();
+            _finished.wait(lock, [&] { return _active == 0; });
+            _task = 0;
+        }
+
+        /**
+         * @returns the amount of workers
+         */
+        int size()
+        {
+            return (int)_threads.size();
+        }
+
+    private:
+        /**
+         * A worker's tasks. The worker takes from the back, and the others steal from the front.
+         */
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<int> tasks;
+        };
+
+        /**
+         * @param worker the worker looking for work
+         * @param task where the task will be set
+         * @returns false if every queue is empty
+         */
+        bool next(int worker, int* task)
+        {
+            int workers = (int)_queues.size();
+            for(int k = 0; k < workers; k++)
+            {
+                Queue& queue = *_queues[(worker + k) % workers];
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                if(!queue.tasks.empty())
+                {
+                    if(k == 0)
+                    {
+                        *task = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    }
+                    else
+                    {
+                        *task = queue.tasks.front();
+                        queue.tasks.pop_front();
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Runs tasks each time `run()` hands some out, until the pool is destroyed
+         *
+         * @param worker the worker's number
+         */
+        void loop(int worker)
+        {
+            long seen = 0;
+            while(true)
+            {
+                const std::function<void(int)>* task;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _start.wait(lock, [&] { return _stop || _generation != seen; });
+                    if(_stop)
+                    {
+                        return;
+                    }
+                    seen = _generation;
+                    task = _task;
+                }
+
+                int i;
+                while(next(worker, &i))
+                {
+                    (*task)(i);
+                }
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                if(--_active == 0)
+                {
+                    _finished.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue> > _queues;
+        std::vector<std::thread> _threads;
+        const std::function<void(int)>* _task;
+        int _active;
+        long _generation;
+        bool _stop;
+        std::mutex _mutex;
+        std::condition_variable _start;
+        std::condition_variable _finished;
+};
+
+
+/**
+ * Everything the command line sets
+ */
+struct Options
+{
+    double longitude = 0.0;
+    double latitude = 0.0;
+    int threads = 0;
+    int random = 0;
+    time_t start = 0;
+    double hours = 10.0;
+    double step = 5.0;
+    double minAltitude = 30.0;
+    double maxAirmass = 2.0;
+    double slew = 2.0;
+    double settle = 30.0;
+    const char* input = 0;
+    const char* output = "-";
+};
+
+
+/**
+ * The targets, a column each
+ */
+struct Targets
+{
+    std::vector<double> ra, dec, x, y, z, priority, seconds;
+    std::vector<long> id;
+
+    /**
+     * @returns the amount of targets
+     */
+    int size() const
+    {
+        return (int)ra.size();
+    }
+
+    /**
+     * @param r the J2000 right ascention
+     * @param d the J2000 declination
+     * @param p the priority
+     * @param s the exposure, in seconds
+     * @param i the ID
+     */
+    void add(double r, double d, double p, double s, long i)
+    {
+        ra.push_back(r);
+        dec.push_back(d);
+        x.push_back(cos(radians(d)) * cos(radians(r)));
+        y.push_back(cos(radians(d)) * sin(radians(r)));
+        z.push_back(sin(radians(d)));
+        priority.push_back(p);
+        seconds.push_back(s);
+        id.push_back(i);
+    }
+};
+
+
+/**
+ * The altitude, azimuth and airmass of every target at every step, held step by step
+ */
+struct Grid
+{
+    /// @brief the amount of targets
+    int targets;
+
+    /// @brief the amount of time steps, with the first at the start of the night and the last at the end
+    int steps;
+
+    std::vector<float> alt, az, airmass;
+
+    /// @brief for each step and target, how many steps in a row from there it is observable (stops at 65535)
+    std::vector<uint16_t> run;
+};
+
+
+/**
+ * The airmass at an altitude, with Kasten and Young's formula, which holds down to the horizon
+ *
+ * @param alt the true altitude, in degrees
+ * @returns the airmass, or infinity below the horizon
+ */
+static float airmass(double alt)
+{
+    if(alt <= 0.0)
+    {
+        return HUGE_VALF;
+    }
+    return (float)(1.0 / (sin(radians(alt)) + 0.50572 * pow(alt + 6.07995, -1.6364)));
+}
+
+
+/**
+ * Fills the grid, one tile of a step by up to `SCHEDULER_TILE` targets per task, then works out the runs one block of
+ * targets per task
+ *
+ * @param pool the workers
+ * @param frames the rotation to the horizon at each step
+ * @param targets the targets
+ * @param options the command line
+ * @param grid where the matrices will be set
+ */
+static void fillGrid(WorkStealingPool& pool, const std::vector<Frame>& frames, const Targets& targets, const Options& options,
+                     Grid* grid)
+{
+    int n = targets.size();
+    int steps = (int)frames.size();
+    int blocks = (n + SCHEDULER_TILE - 1) / SCHEDULER_TILE;
+    grid->targets = n;
+    grid->steps = steps;
+    grid->alt.resize((size_t)n * steps);
+    grid->az.resize((size_t)n * steps);
+    grid->airmass.resize((size_t)n * steps);
+    grid->run.resize((size_t)n * steps);
+
+    pool.run(steps * blocks, [&](int task) {
+        int k = task / blocks;
+        int first = (task % blocks) * SCHEDULER_TILE;
+        int count = std::min(SCHEDULER_TILE, n - first);
+        double alt[SCHEDULER_TILE], az[SCHEDULER_TILE];
+        frames[k].altAz(&targets.x[first], &targets.y[first], &targets.z[first], alt, az, count);
+
+        size_t row = (size_t)k * n + first;
+        for(int i = 0; i < count; i++)
+        {
+            grid->alt[row + i] = (float)alt[i];
+            grid->az[row + i] = (float)az[i];
+            grid->airmass[row + i] = airmass(alt[i]);
+        }
+    });
+
+    // the runs go back from the end of the night, so they are done a block of targets at a time across every step
+    pool.run(blocks, [&](int block) {
+        int first = block * SCHEDULER_TILE;
+        int last = std::min(n, first + SCHEDULER_TILE);
+        std::vector<uint16_t> run(last - first, 0);
+        for(int k = steps - 1; k >= 0; k--)
+        {
+            size_t row = (size_t)k * n;
+            for(int i = first; i < last; i++)
+            {
+                bool observable = grid->alt[row + i] >= options.minAltitude && grid->airmass[row + i] <= options.maxAirmass;
+                uint16_t& r = run[i - first];
+                r = observable ? (uint16_t)std::min(65535, r + 1) : 0;
+                grid->run[row + i] = r;
+            }
+        }
+    });
+}
+
+
+/**
+ * One planned observation
+ */
+struct Observation
+{
+    int target;
+    double start;
+    double slew;
+};
+
+
+/**
+ * @param alt the altitude the telescope is at
+ * @param az the azimuth the telescope is at
+ * @param to_alt the altitude to go to
+ * @param to_az the azimuth to go to
+ * @param options the command line
+ * @returns the seconds to get there and settle
+ */
+static double slewTime(double alt, double az, double to_alt, double to_az, const Options& options)
+{
+    double turn = fabs(to_az - az);
+    if(turn > 180.0)
+    {
+        turn = 360.0 - turn;
+    }
+    return std::max(turn, fabs(to_alt - alt)) / options.slew + options.settle;
+}
+
+
+/**
+ * Plans the night greedily from the grid
+ *
+ * @param grid the altitude, azimuth, airmass and runs
+ * @param targets the targets
+ * @param options the command line
+ * @returns the observations, in the order they happen
+ */
+static std::vector<Observation> allocate(const Grid& grid, const Targets& targets, const Options& options)
+{
+    std::vector<Observation> plan;
+    std::vector<bool> done(targets.size(), false);
+    double step = options.step * 60.0;
+    double night = (grid.steps - 1) * step;
+    double t = 0.0;
+    double alt = 0.0, az = 0.0;
+    bool pointed = false;
+
+    while(t < night)
+    {
+        int k = (int)(t / step);
+        size_t row = (size_t)k * grid.targets;
+        int best = -1;
+        double best_score = 0.0, best_slew = 0.0;
+        for(int i = 0; i < grid.targets; i++)
+        {
+            if(done[i] || grid.run[row + i] == 0)
+            {
+                continue;
+            }
+            double slew = pointed ? slewTime(alt, az, grid.alt[row + i], grid.az[row + i], options) : 0.0;
+            double begin = t + slew;
+            double end = begin + targets.seconds[i];
+
+            // every step from the one the exposure starts in to the one after it ends has to be observable
+            int first = (int)(begin / step);
+            int last = (int)ceil(end / step);
+            if(last >= grid.steps || grid.run[(size_t)first * grid.targets + i] < last - first + 1)
+            {
+                continue;
+            }
+
+            double score = targets.priority[i] / grid.airmass[(size_t)first * grid.targets + i];
+            if(best < 0 || score > best_score || (score == best_score && slew < best_slew))
+            {
+                best = i;
+                best_score = score;
+                best_slew = slew;
+            }
+        }
+
+        if(best < 0)
+        {
+            t = (k + 1) * step;
+            continue;
+        }
+
+        Observation o = {best, t + best_slew, best_slew};
+        plan.push_back(o);
+        done[best] = true;
+        t = o.start + targets.seconds[best];
+
+        // the telescope ends up where the target is at the end of the exposure, to the nearest step
+        int end = std::min(grid.steps - 1, (int)(t / step + 0.5));
+        alt = grid.alt[(size_t)end * grid.targets + best];
+        az = grid.az[(size_t)end * grid.targets + best];
+        pointed = true;
+    }
+    return plan;
+}
+
+
+/**
+ * Reads the targets from a text file
+ *
+ * @param path the file, or `-` for stdin
+ * @param options the command line
+ * @param targets where the targets will be added
+ * @returns false if the file cannot be read
+ */
+static bool readTargets(const char* path, const Options& options, Targets* targets)
+{
+    FILE* in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if(!in)
+    {
+        return false;
+    }
+    char line[512];
+    while(fgets(line, sizeof(line), in))
+    {
+        if(line[0] == '#')
+        {
+            continue;
+        }
+        double ra, dec, priority = 1.0, minutes = options.step;
+        long id = targets->size();
+        if(sscanf(line, "%lf %lf %lf %lf %ld", &ra, &dec, &priority, &minutes, &id) >= 2)
+        {
+            targets->add(ra, dec, priority, minutes * 60.0, id);
+        }
+    }
+    if(in != stdin)
+    {
+        fclose(in);
+    }
+    return true;
+}
+
+
+/**
+ * Makes up targets spread evenly over the sky, with priorities from 1 to 5 and exposures of 5 to 30 minutes
+ *
+ * @param n the amount of targets
+ * @param targets where the targets will be added
+ */
+static void randomTargets(int n, Targets* targets)
+{
+    uint32_t seed = 12345;
+    for(int i = 0; i < n; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        double ra = 360.0 * (seed >> 8) / 16777216.0;
+        seed = seed * 1664525u + 1013904223u;
+        double dec = degrees(asin(2.0 * (seed >> 8) / 16777216.0 - 1.0));
+        seed = seed * 1664525u + 1013904223u;
+        double priority = 1 + (seed >> 8) % 5;
+        seed = seed * 1664525u + 1013904223u;
+        double minutes = 5 * (1 + (seed >> 8) % 6);
+        targets->add(ra, dec, priority, minutes * 60.0, i);
+    }
+}
+
+
+/**
+ * Reads the command line
+ *
+ * @param argc the amount of arguments
+ * @param argv the arguments
+ * @param options where the options will be set
+ * @returns false if the command line is wrong
+ */
+static bool parse(int argc, char** argv, Options* options)
+{
+    int files = 0;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--longitude") == 0 && i + 1 < argc)
+        {
+            options->longitude = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--latitude") == 0 && i + 1 < argc)
+        {
+            options->latitude = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            options->threads = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--random") == 0 && i + 1 < argc)
+        {
+            options->random = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--start") == 0 && i + 1 < argc)
+        {
+            struct tm utc = {};
+            if(sscanf(argv[++i], "%d-%d-%dT%d:%d:%d", &utc.tm_year, &utc.tm_mon, &utc.tm_mday, &utc.tm_hour, &utc.tm_min, &utc.tm_sec) < 5)
+            {
+                return false;
+            }
+            utc.tm_year -= 1900;
+            utc.tm_mon -= 1;
+            options->start = timegm(&utc);
+        }
+        else if(strcmp(argv[i], "--hours") == 0 && i + 1 < argc)
+        {
+            options->hours = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--step") == 0 && i + 1 < argc)
+        {
+            options->step = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--min-altitude") == 0 && i + 1 < argc)
+        {
+            options->minAltitude = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--max-airmass") == 0 && i + 1 < argc)
+        {
+            options->maxAirmass = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--slew") == 0 && i + 1 < argc)
+        {
+            options->slew = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--settle") == 0 && i + 1 < argc)
+        {
+            options->settle = atof(argv[++i]);
+        }
+        else if(files == 0 && options->random == 0)
+        {
+            options->input = argv[i];
+            files++;
+        }
+        else if(files <= 1)
+        {
+            options->output = argv[i];
+            files = 2;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if(options->threads <= 0)
+    {
+        options->threads = (int)std::thread::hardware_concurrency();
+    }
+    if(options->threads <= 0)
+    {
+        options->threads = 1;
+    }
+    if(options->start == 0)
+    {
+        options->start = time(0);
+    }
+    return (options->input || options->random > 0) && options->step > 0.0 && options->hours > 0.0 && options->slew > 0.0;
+}
+
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if(!parse(argc, argv, &options))
+    {
+        fprintf(stderr, "usage: %s [--longitude deg] [--latitude deg] [--start YYYY-MM-DDTHH:MM:SS] [--hours h] [--step minutes]\n"
+                        "       [--min-altitude deg] [--max-airmass x] [--slew deg/s] [--settle s] [--threads n]\n"
+                        "       (targets.txt | - | --random n) [plan.csv|-]\n", argv[0]);
+        return 1;
+    }
+
+    Targets targets;
+    if(options.random > 0)
+    {
+        randomTargets(options.random, &targets);
+    }
+    else if(!readTargets(options.input, options, &targets))
+    {
+        fprintf(stderr, "cannot read %s\n", options.input);
+        return 1;
+    }
+    FILE* out = (strcmp(options.output, "-") == 0) ? stdout : fopen(options.output, "w");
+    if(!out)
+    {
+        fprintf(stderr, "cannot open %s\n", options.output);
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // the epoch only needs working out once for the night, and each step is that turned on by the Earth's rotation
+    struct tm utc;
+    gmtime_r(&options.start, &utc);
+    AstroCalcs astro(options.longitude, options.latitude);
+    astro.setPrecessionModel(PRECESSION_IAU2006);
+    astro.updateTime(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec);
+    int steps = (int)(options.hours * 60.0 / options.step) + 1;
+    std::vector<Frame> frames(steps, Frame(options.latitude));
+    frames[0].update(astro.getPrecession(), &astro.getNutation());
+    for(int k = 0; k < steps; k++)
+    {
+        frames[k] = frames[0];
+        frames[k].setLST(astro.getLST() + SECONDS_TO_LST(k * options.step * 60.0));
+    }
+
+    WorkStealingPool pool(options.threads);
+    Grid grid;
+    fillGrid(pool, frames, targets, options, &grid);
+    std::chrono::steady_clock::time_point gridded = std::chrono::steady_clock::now();
+
+    std::vector<Observation> plan = allocate(grid, targets, options);
+    std::chrono::steady_clock::time_point planned = std::chrono::steady_clock::now();
+
+    double step = options.step * 60.0;
+    double observing = 0.0;
+    fprintf(out, "utc,minutes,id,priority,alt,az,airmass,slew,exposure\n");
+    for(size_t j = 0; j < plan.size(); j++)
+    {
+        const Observation& o = plan[j];
+        time_t when = options.start + (time_t)o.start;
+        struct tm t;
+        gmtime_r(&when, &t);
+        size_t cell = (size_t)(int)(o.start / step) * grid.targets + o.target;
+        fprintf(out, "%04d-%02d-%02dT%02d:%02d:%02d,%.1f,%ld,%g,%.2f,%.2f,%.3f,%.0f,%.0f\n",
+                t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, o.start / 60.0, targets.id[o.target],
+                targets.priority[o.target], grid.alt[cell], grid.az[cell], grid.airmass[cell], o.slew, targets.seconds[o.target]);
+        observing += targets.seconds[o.target];
+    }
+    if(out != stdout)
+    {
+        fclose(out);
+    }
+
+    fprintf(stderr, "%d targets x %d steps: grid %.1f ms, plan %.1f ms with %d threads; %d observations, %.0f%% of the night exposing\n",
+            targets.size(), steps, std::chrono::duration<double, std::milli>(gridded - start).count(),
+            std::chrono::duration<double, std::milli>(planned - gridded).count(), pool.size(), (int)plan.size(),
+            100.0 * observing / (options.hours * 3600.0));
+    return 0;
+}
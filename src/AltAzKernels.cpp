@@ -0,0 +1,816 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "AltAzKernels.h"
+#include "Position.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ALTAZKERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define ALTAZKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+
+typedef void (*AltAzFunction)(const double*, const double*, const double*, double, double, double, double*, double*, double*, int);
+typedef void (*RaDecFunction)(const double*, const double*, double, double, double, double*, double*, double*, double*, int);
+typedef void (*SitesFunction)(double, double, double, double, const double*, const double*, const double*, double*, double*, double*, int);
+typedef void (*TrackFunction)(const double*, const double*, const double*, double, double, double, double, double*, double*, int, int);
+typedef void (*FrameFunction)(const double*, const double*, const double*, const double*, double*, double*, int);
+
+
+// scalar code, used on boards without a vector unit and for the tail of every batch
+
+
+static void altAzScalar(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                        double* ha, double* alt, double* az, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        double hour_angle = LST - ra[i];
+        if(hour_angle < 0.0)
+        {
+            hour_angle += 360.0;
+        }
+
+        double h = radians(hour_angle);
+        double sin_h = sin(h);
+        double cos_h = cos(h);
+
+        double x = cos_h * cosDec[i] * sinLat - sinDec[i] * cosLat;
+        double y = sin_h * cosDec[i];
+        double z = sinLat * sinDec[i] + cos_h * cosDec[i] * cosLat;
+
+        double azimuth = degrees(PI + atan2(y, x));
+        if(azimuth >= 360.0)
+        {
+            azimuth -= 360.0;
+        }
+
+        ha[i] = hour_angle;
+        az[i] = azimuth;
+        alt[i] = degrees(atan2(z, sqrt(x * x + y * y)));
+    }
+}
+
+
+static void raDecScalar(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                        double* ra, double* dec, double* sinDec, double* cosDec, int n)
+{
+    double t = radians(LST);
+
+    for(int i = 0; i < n; i++)
+    {
+        double altitude = radians(alt[i]);
+        double azimuth = PI + radians(az[i]);
+        if(azimuth > 2*PI)
+        {
+            azimuth = azimuth - 2*PI;
+        }
+
+        double x = sin(altitude) * cosLat - cos(altitude) * cos(azimuth) * sinLat;
+        double y = sin(azimuth) * cos(altitude);
+        double sin_d = sin(altitude) * sinLat + cos(altitude) * cos(azimuth) * cosLat;
+        double cos_d = sqrt(x * x + y * y);
+        double d = atan2(sin_d, cos_d);
+        double h = atan2(y, fabs(x));
+
+        double r = degrees(t - (PI*2 - h));
+        r -= 360.0 * floor(r / 360.0);
+        if(r >= 360.0)
+        {
+            r -= 360.0;
+        }
+
+        ra[i] = r;
+        dec[i] = degrees(d);
+        sinDec[i] = sin_d;
+        cosDec[i] = cos_d;
+    }
+}
+
+
+static void sitesScalar(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                        const double* cosLat, double* ha, double* alt, double* az, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        double hour_angle = GMST + longitude[i] - ra;
+        hour_angle -= 360.0 * floor(hour_angle / 360.0);
+        if(hour_angle >= 360.0)
+        {
+            hour_angle -= 360.0;
+        }
+
+        double h = radians(hour_angle);
+        double sin_h = sin(h);
+        double cos_h = cos(h);
+
+        double x = cos_h * cosDec * sinLat[i] - sinDec * cosLat[i];
+        double y = sin_h * cosDec;
+        double z = sinLat[i] * sinDec + cos_h * cosDec * cosLat[i];
+
+        double azimuth = degrees(PI + atan2(y, x));
+        if(azimuth >= 360.0)
+        {
+            azimuth -= 360.0;
+        }
+
+        ha[i] = hour_angle;
+        az[i] = azimuth;
+        alt[i] = degrees(atan2(z, sqrt(x * x + y * y)));
+    }
+}
+
+
+/// `Position::track()` for one target, turning the sine and cosine of the hour angle on by the step
+static void trackTargetScalar(double ra, double sinDec, double cosDec, double LST, double turn, double sinLat, double cosLat,
+                              double* alt, double* az, int count)
+{
+    double a = cosDec * sinLat;
+    double b = sinDec * cosLat;
+    double c = sinLat * sinDec;
+    double e = cosDec * cosLat;
+    double sin_turn = sin(radians(turn));
+    double cos_turn = cos(radians(turn));
+
+    double sin_h = 0.0;
+    double cos_h = 1.0;
+    for(int k = 0; k < count; k++)
+    {
+        if(k % POSITION_TRACK_RESEED == 0)
+        {
+            double h = radians(LST - ra + k * turn);
+            sin_h = sin(h);
+            cos_h = cos(h);
+        }
+        else
+        {
+            double turned = sin_h * cos_turn + cos_h * sin_turn;
+            cos_h = cos_h * cos_turn - sin_h * sin_turn;
+            sin_h = turned;
+        }
+
+        double x = cos_h * a - b;
+        double y = sin_h * cosDec;
+        double z = c + cos_h * e;
+
+        double azimuth = degrees(PI + atan2(y, x));
+        if(azimuth >= 360.0)
+        {
+            azimuth -= 360.0;
+        }
+
+        az[k] = azimuth;
+        alt[k] = degrees(atan2(z, sqrt(x * x + y * y)));
+    }
+}
+
+
+static void frameScalar(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        double a = x[i];
+        double b = y[i];
+        double c = z[i];
+        double south = matrix[0] * a + matrix[1] * b + matrix[2] * c;
+        double west = matrix[3] * a + matrix[4] * b + matrix[5] * c;
+        double up = matrix[6] * a + matrix[7] * b + matrix[8] * c;
+
+        double azimuth = degrees(PI + atan2(west, south));
+        if(azimuth >= 360.0)
+        {
+            azimuth -= 360.0;
+        }
+
+        az[i] = azimuth;
+        alt[i] = degrees(atan2(up, sqrt(south * south + west * west)));
+    }
+}
+
+
+#if !defined(ALTAZKERNELS_X86) && !defined(ALTAZKERNELS_NEON)
+
+static void trackScalar(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                        double sinLat, double cosLat, double* alt, double* az, int count, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        trackTargetScalar(ra[i], sinDec[i], cosDec[i], LST, turn, sinLat, cosLat, alt + (long)i * count, az + (long)i * count, count);
+    }
+}
+
+#endif
+
+
+#if defined(ALTAZKERNELS_X86) || defined(ALTAZKERNELS_NEON)
+
+// The vector maths below is written once with GCC/Clang vector extensions and is instantiated for each instruction set.
+// Every helper is forced inline into a kernel that has the right target attribute, so vectors never actually cross a
+// function boundary and the ABI warnings about returning them do not apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+/// a vector of `N` doubles
+template<int N> struct VectorOf
+{
+    typedef double Double __attribute__((vector_size(N * 8)));
+    typedef long long Mask __attribute__((vector_size(N * 8)));
+};
+
+// adding then subtracting 1.5 * 2^52 rounds a double to the nearest integer without a branch or a libm call
+#define ROUND_MAGIC 6755399441055744.0
+
+template<typename V, typename M> KERNEL_INLINE V select(const M& mask, const V& a, const V& b)
+{
+    return (V)(((M)a & mask) | ((M)b & ~mask));
+}
+
+/// every lane set to `x` (subtracting zero keeps the sign of -0.0, adding it would not)
+template<typename V> KERNEL_INLINE V splat(double x)
+{
+    return x - V{};
+}
+
+template<typename V, typename M> KERNEL_INLINE V vabs(const V& x)
+{
+    return (V)((M)x & ~(M)splat<V>(-0.0));
+}
+
+/// the sign bit of `s` applied to `x`
+template<typename V, typename M> KERNEL_INLINE V vcopysign(const V& x, const V& s)
+{
+    M sign = (M)splat<V>(-0.0);
+    return (V)(((M)x & ~sign) | ((M)s & sign));
+}
+
+template<typename V> KERNEL_INLINE V vround(const V& x)
+{
+    return (x + ROUND_MAGIC) - ROUND_MAGIC;
+}
+
+template<typename V> KERNEL_INLINE V polynomial(const V& x, const double* c, int n)
+{
+    V y = splat<V>(c[0]);
+    for(int i = 1; i < n; i++)
+    {
+        y = y * x + c[i];
+    }
+    return y;
+}
+
+/// a polynomial with a leading coefficient of one
+template<typename V> KERNEL_INLINE V polynomial1(const V& x, const double* c, int n)
+{
+    V y = x + c[0];
+    for(int i = 1; i < n; i++)
+    {
+        y = y * x + c[i];
+    }
+    return y;
+}
+
+static const double SIN_COEFFICIENTS[] = {
+    1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+    -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1
+};
+static const double COS_COEFFICIENTS[] = {
+    -1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+    2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2
+};
+
+/// sine and cosine of `x` radians, reduced by quadrant to [-pi/4, pi/4]
+template<typename V, typename M> KERNEL_INLINE void vsincos(const V& x, V* s, V* c)
+{
+    V biased = x * (2.0 / PI) + ROUND_MAGIC;
+    V q = biased - ROUND_MAGIC;
+    M quadrant = (M)biased;
+
+    // pi/2 split into three parts so the reduction stays exact
+    V r = ((x - q * 1.57079625129699707031E0) - q * 7.54978941586159635335E-8) - q * 5.39030285815811905290E-15;
+    V z = r * r;
+
+    V sin_r = r + r * z * polynomial(z, SIN_COEFFICIENTS, 6);
+    V cos_r = 1.0 - 0.5 * z + z * z * polynomial(z, COS_COEFFICIENTS, 6);
+
+    M swap = (quadrant & 1) != 0;
+    V sin_x = select(swap, cos_r, sin_r);
+    V cos_x = select(swap, sin_r, cos_r);
+
+    M sin_negative = (quadrant & 2) != 0;
+    M cos_negative = ((quadrant + 1) & 2) != 0;
+    *s = select(sin_negative, -sin_x, sin_x);
+    *c = select(cos_negative, -cos_x, cos_x);
+}
+
+#define MOREBITS 6.123233995736765886130E-17
+
+static const double ATAN_P[] = {
+    -8.750608600031904122785E-1, -1.615753718733365076637E1, -7.500855792314704667340E1,
+    -1.228866684490136173410E2, -6.485021904942025371773E1
+};
+static const double ATAN_Q[] = {
+    2.485846490142306297962E1, 1.650270098316988542046E2, 4.328810604912902668951E2,
+    4.853903996359136964868E2, 1.945506571482613964425E2
+};
+
+/// arctangent of `y / x` in (-pi, pi], the same as libm's atan2
+template<typename V, typename M> KERNEL_INLINE V vatan2(const V& y, const V& x)
+{
+    V ax = vabs<V, M>(x);
+    V ay = vabs<V, M>(y);
+
+    // work on the ratio in [0, 1] so it never divides by zero
+    M steep = (M)(ay > ax);
+    V numerator = select(steep, ax, ay);
+    V denominator = select(steep, ay, ax);
+    M zero = (M)(denominator == 0.0);
+    V t = numerator / select(zero, splat<V>(1.0), denominator);
+
+    // reduce [0.66, 1] to [-0.2, 0] around pi/4
+    M upper = (M)(t > 0.66);
+    V offset = select(upper, splat<V>(PI / 4.0), splat<V>(0.0));
+    V extra = select(upper, splat<V>(0.5 * MOREBITS), splat<V>(0.0));
+    t = select(upper, (t - 1.0) / (t + 1.0), t);
+
+    V z = t * t;
+    V a = offset + (t + t * (z * polynomial(z, ATAN_P, 5) / polynomial1(z, ATAN_Q, 5)) + extra);
+
+    a = select(steep, (PI / 2.0) - a, a);
+    a = select((M)(x < 0.0), PI - a, a);
+    return vcopysign<V, M>(a, y);
+}
+
+template<typename V> KERNEL_INLINE V load(const double* p)
+{
+    V v;
+    __builtin_memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template<typename V> KERNEL_INLINE void store(double* p, const V& v)
+{
+    __builtin_memcpy(p, &v, sizeof(V));
+}
+
+/// one block of `Position::altAz()`
+template<typename V, typename M, V (*vsqrt)(V)> KERNEL_INLINE void altAzBlock(const double* ra, const double* sinDec, const double* cosDec,
+                                                                            double LST, double sinLat, double cosLat,
+                                                                            double* ha, double* alt, double* az)
+{
+    V hour_angle = LST - load<V>(ra);
+    hour_angle = select((M)(hour_angle < 0.0), hour_angle + 360.0, hour_angle);
+
+    V sin_h, cos_h;
+    vsincos<V, M>(hour_angle * (PI / 180.0), &sin_h, &cos_h);
+
+    V sin_d = load<V>(sinDec);
+    V cos_d = load<V>(cosDec);
+
+    V x = cos_h * cos_d * sinLat - sin_d * cosLat;
+    V y = sin_h * cos_d;
+    V z = sinLat * sin_d + cos_h * cos_d * cosLat;
+
+    V azimuth = (PI + vatan2<V, M>(y, x)) * (180.0 / PI);
+    azimuth = select((M)(azimuth >= 360.0), azimuth - 360.0, azimuth);
+    V altitude = vatan2<V, M>(z, vsqrt(x * x + y * y)) * (180.0 / PI);
+
+    store(ha, hour_angle);
+    store(az, azimuth);
+    store(alt, altitude);
+}
+
+/// one block of `Position::altAz()` for one target from many sites
+template<typename V, typename M, V (*vsqrt)(V)> KERNEL_INLINE void sitesBlock(double ra, double sinDec, double cosDec, double GMST,
+                                                                            const double* longitude, const double* sinLat,
+                                                                            const double* cosLat, double* ha, double* alt, double* az)
+{
+    // the longitudes can be anywhere in [-180, 360], so this is a full reduction rather than one fix-up
+    V hour_angle = (GMST - ra) + load<V>(longitude);
+    hour_angle = hour_angle - 360.0 * vround(hour_angle * (1.0 / 360.0));
+    hour_angle = select((M)(hour_angle < 0.0), hour_angle + 360.0, hour_angle);
+
+    V sin_h, cos_h;
+    vsincos<V, M>(hour_angle * (PI / 180.0), &sin_h, &cos_h);
+
+    V sin_l = load<V>(sinLat);
+    V cos_l = load<V>(cosLat);
+
+    V x = cos_h * cosDec * sin_l - sinDec * cos_l;
+    V y = sin_h * cosDec;
+    V z = sin_l * sinDec + cos_h * cosDec * cos_l;
+
+    V azimuth = (PI + vatan2<V, M>(y, x)) * (180.0 / PI);
+    azimuth = select((M)(azimuth >= 360.0), azimuth - 360.0, azimuth);
+    V altitude = vatan2<V, M>(z, vsqrt(x * x + y * y)) * (180.0 / PI);
+
+    store(ha, hour_angle);
+    store(az, azimuth);
+    store(alt, altitude);
+}
+
+/// one block of `AstroCalcs::setAltAz()`
+template<typename V, typename M, V (*vsqrt)(V)> KERNEL_INLINE void raDecBlock(const double* alt, const double* az, double LST,
+                                                                            double sinLat, double cosLat,
+                                                                            double* ra, double* dec, double* sinDec, double* cosDec)
+{
+    V altitude = load<V>(alt) * (PI / 180.0);
+    V azimuth = load<V>(az) * (PI / 180.0) + PI;
+    azimuth = select((M)(azimuth > 2.0 * PI), azimuth - 2.0 * PI, azimuth);
+
+    V sin_alt, cos_alt, sin_az, cos_az;
+    vsincos<V, M>(altitude, &sin_alt, &cos_alt);
+    vsincos<V, M>(azimuth, &sin_az, &cos_az);
+
+    V x = sin_alt * cosLat - cos_alt * cos_az * sinLat;
+    V y = sin_az * cos_alt;
+    V sin_d = sin_alt * sinLat + cos_alt * cos_az * cosLat;
+    V cos_d = vsqrt(x * x + y * y);
+    V d = vatan2<V, M>(sin_d, cos_d);
+    V h = vatan2<V, M>(y, vabs<V, M>(x));
+
+    V r = (LST * (PI / 180.0) - (2.0 * PI - h)) * (180.0 / PI);
+    r = r - 360.0 * vround(r * (1.0 / 360.0));
+    r = select((M)(r < 0.0), r + 360.0, r);
+    r = select((M)(r >= 360.0), r - 360.0, r);
+
+    store(ra, r);
+    store(dec, d * (180.0 / PI));
+    store(sinDec, sin_d);
+    store(cosDec, cos_d);
+}
+
+/// one block of `BasicFrame::altAz()`, a matrix times each unit vector
+template<typename V, typename M, V (*vsqrt)(V)> KERNEL_INLINE void frameBlock(const double* matrix, const double* x, const double* y,
+                                                                            const double* z, double* alt, double* az)
+{
+    V a = load<V>(x);
+    V b = load<V>(y);
+    V c = load<V>(z);
+
+    V south = matrix[0] * a + matrix[1] * b + matrix[2] * c;
+    V west = matrix[3] * a + matrix[4] * b + matrix[5] * c;
+    V up = matrix[6] * a + matrix[7] * b + matrix[8] * c;
+
+    V azimuth = (PI + vatan2<V, M>(west, south)) * (180.0 / PI);
+    azimuth = select((M)(azimuth >= 360.0), azimuth - 360.0, azimuth);
+    V altitude = vatan2<V, M>(up, vsqrt(south * south + west * west)) * (180.0 / PI);
+
+    store(az, azimuth);
+    store(alt, altitude);
+}
+
+/// `Position::track()` for one target, with each lane a sample and the lanes turned on by a whole vector of steps at a time
+template<typename V, typename M, V (*vsqrt)(V), int N> KERNEL_INLINE void trackTarget(double ra, double sinDec, double cosDec, double LST,
+                                                                                    double turn, double sinLat, double cosLat,
+                                                                                    double* alt, double* az, int count)
+{
+    double a = cosDec * sinLat;
+    double b = sinDec * cosLat;
+    double c = sinLat * sinDec;
+    double e = cosDec * cosLat;
+    double sin_turn = sin(radians(N * turn));
+    double cos_turn = cos(radians(N * turn));
+
+    double offsets[N];
+    for(int j = 0; j < N; j++)
+    {
+        offsets[j] = j;
+    }
+    V lanes = load<V>(offsets);
+
+    V sin_h = splat<V>(0.0);
+    V cos_h = splat<V>(1.0);
+    int k = 0;
+    for(; k + N <= count; k += N)
+    {
+        // at least every POSITION_TRACK_RESEED samples, even if it is not a multiple of N
+        if(k % POSITION_TRACK_RESEED < N)
+        {
+            // reduced to a turn first, as a night of samples can add up to many
+            V h = (LST - ra) + ((double)k + lanes) * turn;
+            h = h - 360.0 * vround(h * (1.0 / 360.0));
+            vsincos<V, M>(h * (PI / 180.0), &sin_h, &cos_h);
+        }
+        else
+        {
+            V turned = sin_h * cos_turn + cos_h * sin_turn;
+            cos_h = cos_h * cos_turn - sin_h * sin_turn;
+            sin_h = turned;
+        }
+
+        V x = cos_h * a - b;
+        V y = sin_h * cosDec;
+        V z = c + cos_h * e;
+
+        V azimuth = (PI + vatan2<V, M>(y, x)) * (180.0 / PI);
+        azimuth = select((M)(azimuth >= 360.0), azimuth - 360.0, azimuth);
+        V altitude = vatan2<V, M>(z, vsqrt(x * x + y * y)) * (180.0 / PI);
+
+        store(az + k, azimuth);
+        store(alt + k, altitude);
+    }
+    trackTargetScalar(ra, sinDec, cosDec, LST + k * turn, turn, sinLat, cosLat, alt + k, az + k, count - k);
+}
+
+#endif
+
+
+#if defined(ALTAZKERNELS_X86)
+
+typedef VectorOf<2>::Double Double2;
+typedef VectorOf<2>::Mask Mask2;
+typedef VectorOf<4>::Double Double4;
+typedef VectorOf<4>::Mask Mask4;
+
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+static inline __attribute__((always_inline)) Double2 sqrtSse2(Double2 x)
+{
+    return (Double2)_mm_sqrt_pd((__m128d)x);
+}
+
+// not forced inline: it is called from generic helpers that only become AVX2 code once they are inlined into the kernel
+static inline TARGET_AVX2 Double4 sqrtAvx2(Double4 x)
+{
+    return (Double4)_mm256_sqrt_pd((__m256d)x);
+}
+
+static void altAzSse2(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                      double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        altAzBlock<Double2, Mask2, sqrtSse2>(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i);
+    }
+    altAzScalar(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i, n - i);
+}
+
+static TARGET_AVX2 void altAzAvx2(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                                  double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        altAzBlock<Double4, Mask4, sqrtAvx2>(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i);
+    }
+    altAzScalar(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i, n - i);
+}
+
+static void raDecSse2(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                      double* ra, double* dec, double* sinDec, double* cosDec, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        raDecBlock<Double2, Mask2, sqrtSse2>(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i);
+    }
+    raDecScalar(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i, n - i);
+}
+
+static TARGET_AVX2 void raDecAvx2(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                                  double* ra, double* dec, double* sinDec, double* cosDec, int n)
+{
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        raDecBlock<Double4, Mask4, sqrtAvx2>(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i);
+    }
+    raDecScalar(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i, n - i);
+}
+
+static void sitesSse2(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                      const double* cosLat, double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        sitesBlock<Double2, Mask2, sqrtSse2>(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i);
+    }
+    sitesScalar(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i, n - i);
+}
+
+static TARGET_AVX2 void sitesAvx2(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                                  const double* cosLat, double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        sitesBlock<Double4, Mask4, sqrtAvx2>(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i);
+    }
+    sitesScalar(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i, n - i);
+}
+
+static void trackSse2(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                      double sinLat, double cosLat, double* alt, double* az, int count, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        trackTarget<Double2, Mask2, sqrtSse2, 2>(ra[i], sinDec[i], cosDec[i], LST, turn, sinLat, cosLat,
+                                                 alt + (long)i * count, az + (long)i * count, count);
+    }
+}
+
+static TARGET_AVX2 void trackAvx2(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                                  double sinLat, double cosLat, double* alt, double* az, int count, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        trackTarget<Double4, Mask4, sqrtAvx2, 4>(ra[i], sinDec[i], cosDec[i], LST, turn, sinLat, cosLat,
+                                                 alt + (long)i * count, az + (long)i * count, count);
+    }
+}
+
+static void frameSse2(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        frameBlock<Double2, Mask2, sqrtSse2>(matrix, x + i, y + i, z + i, alt + i, az + i);
+    }
+    frameScalar(matrix, x + i, y + i, z + i, alt + i, az + i, n - i);
+}
+
+static TARGET_AVX2 void frameAvx2(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        frameBlock<Double4, Mask4, sqrtAvx2>(matrix, x + i, y + i, z + i, alt + i, az + i);
+    }
+    frameScalar(matrix, x + i, y + i, z + i, alt + i, az + i, n - i);
+}
+
+static bool hasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#elif defined(ALTAZKERNELS_NEON)
+
+typedef VectorOf<2>::Double Double2;
+typedef VectorOf<2>::Mask Mask2;
+
+static inline __attribute__((always_inline)) Double2 sqrtNeon(Double2 x)
+{
+    return (Double2)vsqrtq_f64((float64x2_t)x);
+}
+
+static void altAzNeon(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                      double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        altAzBlock<Double2, Mask2, sqrtNeon>(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i);
+    }
+    altAzScalar(ra + i, sinDec + i, cosDec + i, LST, sinLat, cosLat, ha + i, alt + i, az + i, n - i);
+}
+
+static void raDecNeon(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                      double* ra, double* dec, double* sinDec, double* cosDec, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        raDecBlock<Double2, Mask2, sqrtNeon>(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i);
+    }
+    raDecScalar(alt + i, az + i, LST, sinLat, cosLat, ra + i, dec + i, sinDec + i, cosDec + i, n - i);
+}
+
+static void sitesNeon(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                      const double* cosLat, double* ha, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        sitesBlock<Double2, Mask2, sqrtNeon>(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i);
+    }
+    sitesScalar(ra, sinDec, cosDec, GMST, longitude + i, sinLat + i, cosLat + i, ha + i, alt + i, az + i, n - i);
+}
+
+static void trackNeon(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                      double sinLat, double cosLat, double* alt, double* az, int count, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        trackTarget<Double2, Mask2, sqrtNeon, 2>(ra[i], sinDec[i], cosDec[i], LST, turn, sinLat, cosLat,
+                                                 alt + (long)i * count, az + (long)i * count, count);
+    }
+}
+
+static void frameNeon(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n)
+{
+    int i = 0;
+    for(; i + 2 <= n; i += 2)
+    {
+        frameBlock<Double2, Mask2, sqrtNeon>(matrix, x + i, y + i, z + i, alt + i, az + i);
+    }
+    frameScalar(matrix, x + i, y + i, z + i, alt + i, az + i, n - i);
+}
+
+#endif
+
+
+// runtime dispatch, decided on the first call
+
+
+/**
+ * The kernels for the instruction set in use
+ */
+struct Kernels
+{
+    AltAzFunction altAz;
+    RaDecFunction raDec;
+    SitesFunction sites;
+    TrackFunction track;
+    FrameFunction frame;
+    const char* name;
+};
+
+static Kernels chooseKernels()
+{
+#if defined(ALTAZKERNELS_X86)
+    if(hasAvx2())
+    {
+        Kernels avx2 = {altAzAvx2, raDecAvx2, sitesAvx2, trackAvx2, frameAvx2, "avx2"};
+        return avx2;
+    }
+    Kernels sse2 = {altAzSse2, raDecSse2, sitesSse2, trackSse2, frameSse2, "sse2"};
+    return sse2;
+#elif defined(ALTAZKERNELS_NEON)
+    Kernels neon = {altAzNeon, raDecNeon, sitesNeon, trackNeon, frameNeon, "neon"};
+    return neon;
+#else
+    Kernels scalar = {altAzScalar, raDecScalar, sitesScalar, trackScalar, frameScalar, "scalar"};
+    return scalar;
+#endif
+}
+
+/**
+ * @returns the kernels, chosen once by a function-local static, which C++11 makes safe when several threads call first
+ */
+static const Kernels& kernels()
+{
+    static const Kernels chosen = chooseKernels();
+    return chosen;
+}
+
+
+void AltAzKernels::altAz(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                         double* ha, double* alt, double* az, int n)
+{
+    kernels().altAz(ra, sinDec, cosDec, LST, sinLat, cosLat, ha, alt, az, n);
+}
+
+
+void AltAzKernels::raDec(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                         double* ra, double* dec, double* sinDec, double* cosDec, int n)
+{
+    kernels().raDec(alt, az, LST, sinLat, cosLat, ra, dec, sinDec, cosDec, n);
+}
+
+
+void AltAzKernels::sites(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                         const double* cosLat, double* ha, double* alt, double* az, int n)
+{
+    kernels().sites(ra, sinDec, cosDec, GMST, longitude, sinLat, cosLat, ha, alt, az, n);
+}
+
+
+void AltAzKernels::track(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                         double sinLat, double cosLat, double* alt, double* az, int count, int n)
+{
+    kernels().track(ra, sinDec, cosDec, LST, turn, sinLat, cosLat, alt, az, count, n);
+}
+
+
+void AltAzKernels::frame(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n)
+{
+    kernels().frame(matrix, x, y, z, alt, az, n);
+}
+
+
+const char* AltAzKernels::name()
+{
+    return kernels().name;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file AltAzKernels.h
+ * @brief Vectorised ra/dec to alt/az kernels with runtime CPU dispatch
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef ALTAZKERNELS_H
+
+#define ALTAZKERNELS_H 1
+#include "Arduino.h"
+
+/// the largest difference (in degrees) between the vector kernels and the scalar `Position::altAz()` /
+/// `AstroCalcs::setAltAz()` path
+#define ALTAZKERNELS_TOLERANCE 1e-9
+
+/**
+ * AltAzKernels Class
+ *
+ * The inner loops of `PositionBatch`, written so that 2 (SSE2, NEON) or 4 (AVX2) targets are worked on per instruction.
+ *
+ * The sine, cosine and arctangent are vector polynomials (the Cephes approximations), and every branch of the scalar
+ * code (the azimuth fix-up, the `limit()` loops) is replaced by a select, so whole blocks of targets go through the same
+ * instructions.
+ * Like the scalar path, altitudes and declinations come from `atan2` of the unit vector instead of `asin`.
+ * The instruction set is picked once, the first time a kernel is called from any thread. Boards without a vector unit
+ * (AVR, Cortex-M) use the scalar libm code, which is also used for the last few targets that do not fill a whole vector.
+ *
+ * Results agree with the scalar path to within `ALTAZKERNELS_TOLERANCE` degrees.
+ */
+class AltAzKernels
+{
+    public:
+        /**
+         * Calculates the hour angle, altitude and azimuth of many targets.
+         *
+         * @see Position::altAz()
+         *
+         * @param ra the right ascention of each target, in [0, 360)
+         * @param sinDec the sine of each declination
+         * @param cosDec the cosine of each declination
+         * @param LST the local sidereal time, in [0, 360)
+         * @param sinLat the sine of the observer's latitude
+         * @param cosLat the cosine of the observer's latitude
+         * @param ha where the hour angles will be set
+         * @param alt where the altitudes will be set
+         * @param az where the azimuths will be set
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        static void altAz(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                          double* ha, double* alt, double* az, int n);
+
+        /**
+         * Calculates the right ascention and declination of many altitude/azimuth pairs.
+         *
+         * @see AstroCalcs::setAltAz()
+         *
+         * @param alt the altitude of each target
+         * @param az the azimuth of each target
+         * @param LST the local sidereal time
+         * @param sinLat the sine of the observer's latitude
+         * @param cosLat the cosine of the observer's latitude
+         * @param ra where the right ascentions will be set, in [0, 360)
+         * @param dec where the declinations will be set
+         * @param sinDec where the sine of each declination will be set
+         * @param cosDec where the cosine of each declination will be set
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        static void raDec(const double* alt, const double* az, double LST, double sinLat, double cosLat,
+                          double* ra, double* dec, double* sinDec, double* cosDec, int n);
+
+        /**
+         * Calculates the hour angle, altitude and azimuth of one target from many sites.
+         *
+         * @see SiteBatch::altAz()
+         *
+         * @param ra the right ascention of the target
+         * @param sinDec the sine of the target's declination
+         * @param cosDec the cosine of the target's declination
+         * @param GMST the Greenwich mean sidereal time, in [0, 360)
+         * @param longitude the longitude of each site, east positive, in [-180, 360]
+         * @param sinLat the sine of each site's latitude
+         * @param cosLat the cosine of each site's latitude
+         * @param ha where the hour angles will be set
+         * @param alt where the altitudes will be set
+         * @param az where the azimuths will be set
+         * @param n the amount of sites
+         * @returns acts in place on the output arrays
+         */
+        static void sites(double ra, double sinDec, double cosDec, double GMST, const double* longitude, const double* sinLat,
+                          const double* cosLat, double* ha, double* alt, double* az, int n);
+
+        /**
+         * Calculates the altitude and azimuth of many targets at `count` times, each `turn` degrees of LST after the last.
+         *
+         * The samples of one target are worked on a vector at a time, and the sine and cosine of their hour angles are turned
+         * on by a whole vector of steps with the angle-addition recurrence, so between the fresh starts (every
+         * `POSITION_TRACK_RESEED` samples, as in `Position::track()`) a sample costs no sine or cosine. Agrees with
+         * `altAz()` at each time to within `ALTAZKERNELS_TOLERANCE`.
+         *
+         * @see Position::track()
+         *
+         * @param ra the right ascention of each target, in [0, 360)
+         * @param sinDec the sine of each declination
+         * @param cosDec the cosine of each declination
+         * @param LST the local sidereal time of the first sample, in [0, 360)
+         * @param turn the LST between samples, in degrees
+         * @param sinLat the sine of the observer's latitude
+         * @param cosLat the cosine of the observer's latitude
+         * @param alt where the altitudes will be set, `count` for each target one after the other
+         * @param az where the azimuths will be set, in the same order as `alt`
+         * @param count the amount of samples of each target
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        static void track(const double* ra, const double* sinDec, const double* cosDec, double LST, double turn,
+                          double sinLat, double cosLat, double* alt, double* az, int count, int n);
+
+        /**
+         * Calculates the altitude and azimuth of many unit vectors with one rotation matrix, which takes them straight from
+         * their frame (such as J2000) to the horizon, so a target costs a matrix-vector product and two arctangents.
+         *
+         * @see BasicFrame::altAz()
+         *
+         * @param matrix the rotation, 9 doubles row by row, whose rows give the south, west and up components
+         * @param x the x component (towards ra 0, dec 0) of each unit vector
+         * @param y the y component (towards ra 90, dec 0) of each unit vector
+         * @param z the z component (towards the pole) of each unit vector
+         * @param alt where the altitudes will be set
+         * @param az where the azimuths will be set
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        static void frame(const double* matrix, const double* x, const double* y, const double* z, double* alt, double* az, int n);
+
+        /**
+         * @returns the name of the instruction set the kernels are using (`"avx2"`, `"sse2"`, `"neon"` or `"scalar"`)
+         */
+        static const char* name();
+};
+
+#endif
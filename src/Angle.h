@@ -0,0 +1,395 @@
+/**
+ * @file Angle.h
+ * @brief A 32-bit binary angle, which wraps at a full turn for free
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef ANGLE_H
+
+#define ANGLE_H 1
+#include "Arduino.h"
+#include "Fixed.h"
+
+/// a full turn (360 degrees, 24 hours) in the raw units of an `Angle`, as a double
+#define ANGLE_TURN 4294967296.0
+
+/**
+ * Angle Class
+ *
+ * An angle held as a binary angle measurement (BAM): a full turn is 2^32, so one unit is 8.4e-8 degrees (0.0003").
+ * Adding and subtracting are plain unsigned integer arithmetic, and the wrap at 360 degrees is the integer overflow,
+ * so there are no loops or branches to keep an angle in [0, 360).
+ *
+ * Sine and cosine come from a quarter-wave table of 512 steps with linear interpolation, good to 1.2e-6 (0.25").
+ * The table is in flash (`PROGMEM`) on AVR.
+ *
+ * The getters are templates on the scalar type (`double`, `float` or `Fixed`), so each kind of board only does the
+ * arithmetic it is fast at: `a.getDegrees()` is a double, `a.getDegrees<Fixed>()` is integer shifts.
+ */
+class Angle
+{
+    public:
+        /// @brief the angle in units of 1/2^32 of a turn
+        uint32_t raw;
+
+        /**
+         * Constructor
+         *
+         * sets the angle to zero
+         */
+        Angle() : raw(0) {}
+
+        /**
+         * Makes an angle from its raw value
+         *
+         * @param raw the angle in units of 1/2^32 of a turn
+         * @returns the angle
+         */
+        static Angle fromRaw(uint32_t raw)
+        {
+            Angle a;
+            a.raw = raw;
+            return a;
+        }
+
+        /**
+         * Makes an angle from degrees. Any value is allowed, and is wrapped to a turn.
+         *
+         * @param degrees the angle in degrees
+         * @returns the angle
+         */
+        static Angle fromDegrees(double degrees)
+        {
+            return fromTurns(degrees / 360.0);
+        }
+
+        /**
+         * Makes an angle from fixed point degrees, with integer arithmetic only.
+         *
+         * @param degrees the angle in degrees
+         * @returns the angle
+         */
+        static Angle fromDegrees(Fixed degrees)
+        {
+            return fromFixed(degrees, unitWhole(360.0), unitFraction(360.0));
+        }
+
+        /**
+         * Makes an angle from hours (of right ascention or hour angle). Any value is allowed, and is wrapped to a turn.
+         *
+         * @param hours the angle in hours
+         * @returns the angle
+         */
+        static Angle fromHours(double hours)
+        {
+            return fromTurns(hours / 24.0);
+        }
+
+        /**
+         * Makes an angle from fixed point hours, with integer arithmetic only.
+         *
+         * @param hours the angle in hours
+         * @returns the angle
+         */
+        static Angle fromHours(Fixed hours)
+        {
+            return fromFixed(hours, unitWhole(24.0), unitFraction(24.0));
+        }
+
+        /**
+         * Makes an angle from radians. Any value is allowed, and is wrapped to a turn.
+         *
+         * @param radians the angle in radians
+         * @returns the angle
+         */
+        static Angle fromRadians(double radians)
+        {
+            return fromTurns(radians / TWO_PI);
+        }
+
+        /**
+         * Makes an angle from fixed point radians, with integer arithmetic only.
+         *
+         * @param radians the angle in radians
+         * @returns the angle
+         */
+        static Angle fromRadians(Fixed radians)
+        {
+            return fromFixed(radians, unitWhole(TWO_PI), unitFraction(TWO_PI));
+        }
+
+        /**
+         * @tparam T the scalar type to return (`double`, `float` or `Fixed`)
+         * @returns the angle in degrees, in [0, 360)
+         */
+        template<class T = double> T getDegrees() const
+        {
+            return T(this->raw * (360.0 / ANGLE_TURN));
+        }
+
+        /**
+         * @tparam T the scalar type to return (`double`, `float` or `Fixed`)
+         * @returns the angle in degrees, in [-180, 180), for declinations, altitudes and differences
+         */
+        template<class T = double> T getSignedDegrees() const
+        {
+            return T((int32_t)this->raw * (360.0 / ANGLE_TURN));
+        }
+
+        /**
+         * @tparam T the scalar type to return (`double`, `float` or `Fixed`)
+         * @returns the angle in hours, in [0, 24)
+         */
+        template<class T = double> T getHours() const
+        {
+            return T(this->raw * (24.0 / ANGLE_TURN));
+        }
+
+        /**
+         * @returns the angle in radians, in [0, 2 pi)
+         */
+        double getRadians() const
+        {
+            return this->raw * (TWO_PI / ANGLE_TURN);
+        }
+
+        /**
+         * Splits the angle into hours:minutes:seconds. Hours and minutes come straight from the integer, with no rounding.
+         *
+         * @see dms() for degrees:minutes:seconds
+         *
+         * @param h an integer pointer where the hours will be set, in [0, 24)
+         * @param m an integer pointer where the minutes will be set
+         * @param s a double pointer where the seconds will be set
+         * @returns acts in place on the pointers
+         */
+        void hms(int* h, int* m, double* s) const
+        {
+            uint64_t x = (uint64_t)this->raw * 24;
+            *h = (int)(x >> 32);
+            x = (x & 0xFFFFFFFFULL) * 60;
+            *m = (int)(x >> 32);
+            *s = (double)(x & 0xFFFFFFFFULL) * (60.0 / ANGLE_TURN);
+        }
+
+        /**
+         * Splits the angle into degrees:minutes:seconds, in [-180, 180). Like `Position::decDMS()`, a negative angle has
+         * the degrees, minutes and seconds all negative.
+         *
+         * @see hms() for hours:minutes:seconds
+         *
+         * @param d an integer pointer where the degrees will be set
+         * @param m an integer pointer where the minutes will be set
+         * @param s a double pointer where the seconds will be set
+         * @returns acts in place on the pointers
+         */
+        void dms(int* d, int* m, double* s) const
+        {
+            int32_t a = (int32_t)this->raw;
+            int sign = (a < 0) ? -1 : 1;
+            uint64_t x = (uint64_t)((a < 0) ? -(int64_t)a : (int64_t)a) * 360;
+            *d = sign * (int)(x >> 32);
+            x = (x & 0xFFFFFFFFULL) * 60;
+            *m = sign * (int)(x >> 32);
+            *s = sign * (double)(x & 0xFFFFFFFFULL) * (60.0 / ANGLE_TURN);
+        }
+
+        /**
+         * Looks up the sine and cosine of the angle in the table
+         *
+         * @param s a pointer where the sine will be set
+         * @param c a pointer where the cosine will be set
+         * @returns acts in place on the pointers
+         */
+        void sincos(double* s, double* c) const
+        {
+            int32_t sin_q30, cos_q30;
+            lookup(&sin_q30, &cos_q30);
+            *s = sin_q30 * (1.0 / 1073741824.0);
+            *c = cos_q30 * (1.0 / 1073741824.0);
+        }
+
+        /**
+         * Looks up the sine and cosine of the angle in the table
+         *
+         * @param s a pointer where the sine will be set
+         * @param c a pointer where the cosine will be set
+         * @returns acts in place on the pointers
+         */
+        void sincos(float* s, float* c) const
+        {
+            int32_t sin_q30, cos_q30;
+            lookup(&sin_q30, &cos_q30);
+            *s = sin_q30 * (1.0f / 1073741824.0f);
+            *c = cos_q30 * (1.0f / 1073741824.0f);
+        }
+
+        /**
+         * Looks up the sine and cosine of the angle in the table, with integer arithmetic only
+         *
+         * @param s a pointer where the sine will be set
+         * @param c a pointer where the cosine will be set
+         * @returns acts in place on the pointers
+         */
+        void sincos(Fixed* s, Fixed* c) const
+        {
+            int32_t sin_q30, cos_q30;
+            lookup(&sin_q30, &cos_q30);
+            *s = Fixed::fromRaw((sin_q30 + (1L << 13)) >> 14);
+            *c = Fixed::fromRaw((cos_q30 + (1L << 13)) >> 14);
+        }
+
+        /**
+         * @returns the sine of the angle, from the table
+         */
+        double sin() const
+        {
+            double s, c;
+            sincos(&s, &c);
+            return s;
+        }
+
+        /**
+         * @returns the cosine of the angle, from the table
+         */
+        double cos() const
+        {
+            double s, c;
+            sincos(&s, &c);
+            return c;
+        }
+
+        Angle operator-() const { return fromRaw(0U - this->raw); }
+
+        friend Angle operator+(Angle a, Angle b) { return fromRaw(a.raw + b.raw); }
+        friend Angle operator-(Angle a, Angle b) { return fromRaw(a.raw - b.raw); }
+
+        Angle& operator+=(Angle b) { this->raw += b.raw; return *this; }
+        Angle& operator-=(Angle b) { this->raw -= b.raw; return *this; }
+
+        friend bool operator==(Angle a, Angle b) { return a.raw == b.raw; }
+        friend bool operator!=(Angle a, Angle b) { return a.raw != b.raw; }
+
+    private:
+        /**
+         * Makes an angle from a fraction of a turn, dropping the whole turns
+         *
+         * @param turns the angle in turns
+         * @returns the angle
+         */
+        static Angle fromTurns(double turns)
+        {
+            // through a signed 64-bit integer, so negative angles and whole turns wrap instead of being undefined
+            return fromRaw((uint32_t)(int64_t)(turns * ANGLE_TURN + (turns < 0.0 ? -0.5 : 0.5)));
+        }
+
+        /**
+         * @param units the units in a turn (360 for degrees)
+         * @returns the whole part of the raw units of an angle per `Fixed` raw unit, 2^16 / `units`, for `fromFixed()`
+         */
+        static constexpr uint32_t unitWhole(double units)
+        {
+            return (uint32_t)(65536.0 / units);
+        }
+
+        /**
+         * @param units the units in a turn (360 for degrees)
+         * @returns the fraction part of 2^16 / `units` in Q0.32, rounded, for `fromFixed()`
+         */
+        static constexpr uint32_t unitFraction(double units)
+        {
+            return (uint32_t)((65536.0 / units - (double)unitWhole(units)) * 4294967296.0 + 0.5);
+        }
+
+        /**
+         * Makes an angle from a fixed point number by multiplying by 2^16 / units, the whole part as an integer and the
+         * fraction in Q0.32 like `fixedScale()`, so there is no 64-bit division (`__divdi3` on AVR). Values past a turn
+         * wrap like any other angle.
+         *
+         * @param x the angle in some units
+         * @param whole from `unitWhole()`
+         * @param fraction from `unitFraction()`
+         * @returns the angle, rounded to nearest
+         */
+        static Angle fromFixed(Fixed x, uint32_t whole, uint32_t fraction)
+        {
+            int64_t part = ((int64_t)x.raw * fraction + ((int64_t)1 << 31)) >> 32;
+            return fromRaw((uint32_t)x.raw * whole + (uint32_t)part);
+        }
+
+        /**
+         * Scales raw units to a fixed point number of whole `units` per turn. This is a multiply by a small integer and a
+         * shift, so it is exact to the rounding.
+         *
+         * @param x the raw angle, signed or not
+         * @param units the units in a turn (360 for degrees)
+         * @returns x * units / 2^32 as a `Fixed`, rounded to nearest
+         */
+        static Fixed toFixed(int64_t x, int32_t units)
+        {
+            return Fixed::fromRaw((int32_t)((x * units + 32768) >> 16));
+        }
+
+        /**
+         * Sine and cosine as Q1.30 integers, from the quarter-wave table
+         *
+         * @param s a pointer where the sine will be set
+         * @param c a pointer where the cosine will be set
+         * @returns acts in place on the pointers
+         */
+        void lookup(int32_t* s, int32_t* c) const;
+};
+
+/// the float version, without going through double on boards with a single precision FPU
+template<> inline float Angle::getDegrees<float>() const
+{
+    return (float)this->raw * (float)(360.0 / ANGLE_TURN);
+}
+
+/// the fixed point version, with integer arithmetic only
+template<> inline Fixed Angle::getDegrees<Fixed>() const
+{
+    return toFixed(this->raw, 360);
+}
+
+/// the float version, without going through double on boards with a single precision FPU
+template<> inline float Angle::getSignedDegrees<float>() const
+{
+    return (float)(int32_t)this->raw * (float)(360.0 / ANGLE_TURN);
+}
+
+/// the fixed point version, with integer arithmetic only
+template<> inline Fixed Angle::getSignedDegrees<Fixed>() const
+{
+    return toFixed((int32_t)this->raw, 360);
+}
+
+/// the float version, without going through double on boards with a single precision FPU
+template<> inline float Angle::getHours<float>() const
+{
+    return (float)this->raw * (float)(24.0 / ANGLE_TURN);
+}
+
+/// the fixed point version, with integer arithmetic only
+template<> inline Fixed Angle::getHours<Fixed>() const
+{
+    return toFixed(this->raw, 24);
+}
+
+#endif
@@ -19,146 +19,152 @@
 #include "Position.h"
 
 
-AstroCalcs::AstroCalcs(double longitude, double latitude)
+template<class Math>
+BasicAstroCalcs<Math>::BasicAstroCalcs(Scalar longitude, Scalar latitude)
 {
     _latitude = latitude;
     _longitude = longitude;
 
-    this->curr_pos = Position(0.0, 0.0, latitude, 0.0);
+    _LST = Scalar(0.0);
+    _diff = Scalar(0.0);
+    _Y = 2000;
+    _day = 0;
+    _ms = 0;
+    _syncLST = Scalar(0.0);
+    _elapsedMs = 0;
+    _elapsedRest = 0.0;
+    _apparent = true;
+    _refraction = NULL;
+
+    this->curr_pos = BasicPosition<Math>(Scalar(0.0), Scalar(0.0), latitude, Scalar(0.0));
 }
 
 
-/*void AstroCalcs::jdify()
+/**
+ * Moves whole days out of the milliseconds and into the days, so the milliseconds are in [0, 86400000)
+ * @param day a pointer to the whole days
+ * @param ms a pointer to the milliseconds
+ * @returns acts in place on the pointers
+ */
+static void normaliseDay(long* day, long* ms)
 {
-  int A = floor(_Y/100);
-  int B = floor(A/4);
-  int C = floor(2-A+B);
-  int E = floor(365.25*(_Y+4716)) - 2451545;
-  int F = floor(30.6001*(_M+1));
-  _JD = double(C) + double(_D) + double(E) + double(F) -1524.5 + double(_h)/24.0 + double(_m)/1440.0 + double(_s)/86400.0;
+    *day += *ms / MS_PER_DAY;
+    *ms %= MS_PER_DAY;
+    if(*ms < 0)
+    {
+        *ms += MS_PER_DAY;
+        *day -= 1;
+    }
 }
 
 
-void AstroCalcs::bigt()
+template<class Math>
+void BasicAstroCalcs<Math>::jdify()
 {
-  _t = ((_JD/* - 2451545.0*//*) / 36525.0);
+    // _M is already 13 or 14 for January and February, which julianDay() leaves as they are
+    _day = julianDay(_Y, _M, _D, _h, _m, _s);
+    _ms = julianMilliseconds(_h, _m, _s);
 }
 
 
-double AstroCalcs::gmst()
+/*void AstroCalcs::bigt()
 {
-  double thetazero = 280.46061837 + 360.98564736629 * (_JD/* - 2451545.0*//*) + 0.000387933 * (_t*_t) - (_t*_t*_t) / 38710000.0;
-  while(thetazero > 360){
-    thetazero -= 360.0;
-  }
-  while(thetazero < 0){
-    thetazero += 360.0;
-  }
-  return thetazero;
+  _t = ((_JD/* - 2451545.0*//*) / 36525.0);
 }*/
 
 
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::gmst()
+{
+    return Scalar(gmstDegrees(_day, _ms));
+}
+
 
-void AstroCalcs::lst()
+template<class Math>
+void BasicAstroCalcs<Math>::lst()
 {
-    int A = floor(_Y/100);
-    int B = floor(A/4);
-    int C = floor(2-A+B);
-    int E = floor(365.25*(_Y+4716)) - 2451545;
-    int F = floor(30.6001*(_M+1));
-    double jd = double(C) + double(_D) + double(E) + double(F) -1524.5 + double(_h)/24.0 + double(_m)/1440.0 + double(_s)/86400.0;
+    ASTROCALCS_PROFILE_SCOPE(PROFILE_LST);
 
-    double t = ((jd/* - 2451545.0*/) / 36525.0);
-    double thetazero = 280.46061837 + 360.98564736629 * (jd/* - 2451545.0*/) + 0.000387933 * (t*t) - (t*t*t) / 38710000.0;
-    while(thetazero > 360){
-        thetazero -= 360.0;
-    }
-    while(thetazero < 0){
-        thetazero += 360.0;
-    }
+    jdify();
+    Scalar thetazero = gmst();
 
-	double gmstdeg = _h * 15 + _m * 15 / 60 + _s * 15 / 3600;
-    //jdify();
-    //bigt();
-	//double g = gmst();
-	double d = gmstdeg - thetazero;
-	double L = thetazero + _longitude;
+	Scalar gmstdeg = Scalar(_h * 15 + _m * 15 / 60 + _s * 15 / 3600);
+	Scalar d = gmstdeg - thetazero;
 
-    while(L > 360.0)
-    {
-        L -= 360.0;
-    }
-    while(L < 0.0)
-    {
-        L += 360.0;
-    }
-    _LST = L;
+    _LST = wrapDegrees(thetazero + _longitude);
     _diff = d;
+
+    _syncLST = _LST;
+    _elapsedMs = 0;
+    _elapsedRest = 0.0;
+
+    updateEpoch();
 }
 
 
-void AstroCalcs::precess()
+template<class Math>
+void BasicAstroCalcs<Math>::updateEpoch()
 {
-    // some time based variables
-    double T = ((double)_Y - 2000.0) / 100.0;
-    double M = 307.0 * T;
-    double N = 134.0 * T;
-    double S = 2004.0 * T;
+    double jd = julianDate(_day, _ms);
+    _precession.update(_Y, jd);
+    if(_apparent)
+    {
+        _nutation.update(jd);
+    }
+}
 
-    // convert to seconds
-    double ra_seconds = (3600.0 * curr_pos.ra)/15.0;
-    double dec_seconds = 3600.0 * curr_pos.dec;
 
-    // precess
-    double precessed_ra_seconds = ra_seconds + M + N * sin(curr_pos.ra * PI/180.0)*tan(curr_pos.dec * PI/180.0);
-    double precessed_dec_seconds = dec_seconds + S * cos(curr_pos.ra * PI/180.0);
+template<class Math>
+void BasicAstroCalcs<Math>::precess()
+{
+    ASTROCALCS_PROFILE_SCOPE(PROFILE_PRECESS);
 
-    // convert back to decimal
-    double ra_decimal = (precessed_ra_seconds / 3600.0) * 15.0;
-    double dec_decimal = precessed_dec_seconds / 3600.0;
+    Scalar ra, dec;
+    this->_precession.apply(this->curr_pos.getRA(), this->curr_pos.getDec(), &ra, &dec);
+    if(_apparent)
+    {
+        this->_nutation.apply(ra, dec, &ra, &dec);
+    }
 
-    this->curr_pos = Position(ra_decimal, dec_decimal, this->_latitude, this->_LST);
+    // one construction works out the alt/az for the current LST
+    this->curr_pos = BasicPosition<Math>(ra, dec, this->_latitude, this->_LST);
+    if(_refraction)
+    {
+        refract();
+    }
 }
 
-Position AstroCalcs::precess_curr_pos()
+template<class Math>
+BasicPosition<Math> BasicAstroCalcs<Math>::precess_curr_pos()
 {
-    // some time based variables
-    double T = ((double)_Y - 2000.0) / 100.0;
-    double M = 307.0 * T;
-    double N = 134.0 * T;
-    double S = 2004.0 * T;
-
-    // convert to seconds
-    double ra_seconds = (3600.0 * curr_pos.ra)/15.0;
-    double dec_seconds = 3600.0 * curr_pos.dec;
+    Scalar ra, dec;
+    this->_precession.apply(this->curr_pos.getRA(), this->curr_pos.getDec(), &ra, &dec);
 
-    // precess
-    double precessed_ra_seconds = ra_seconds + M + N * sin(curr_pos.ra * PI/180.0)*tan(curr_pos.dec * PI/180.0);
-    double precessed_dec_seconds = dec_seconds + S * cos(curr_pos.ra * PI/180.0);
+    return BasicPosition<Math>(ra, dec, this->_latitude, this->curr_pos.getLST());
+}
 
-    // convert back to decimal
-    double ra_decimal = (precessed_ra_seconds / 3600.0) * 15.0;
-    double dec_decimal = precessed_dec_seconds / 3600.0;
 
-    Position p = Position(ra_decimal, dec_decimal, this->_latitude, this->curr_pos.LST);
-    
-    return p;
+template<class Math>
+void BasicAstroCalcs<Math>::refract()
+{
+    // the position adds the refraction when its altitude is next read, so nothing is worked out here
+    this->curr_pos.setRefraction(this->_refraction);
 }
 
 
-void AstroCalcs::refract()
+template<class Math>
+void BasicAstroCalcs<Math>::updatePosition()
 {
-	//1.02cot(h+10.3/(h+5.11))
-	double R = 1.02 * (1 / tan(radians(this->curr_pos.alt + 10.3 / (this->curr_pos.alt + 5.11))));
-	this->curr_pos.alt = this->curr_pos.alt + (R / 3600.0);
-    this->setAltAz(this->curr_pos.alt, this->curr_pos.az);
+    // the refraction tables stay attached to the position, which adds them to the new altitude when it is read
+    this->curr_pos.updateLST(this->_LST);
 }
 
 
 //public functions
 
 
-void AstroCalcs::updateTime(int Y, int M, int D, int h, int m, int s)
+template<class Math>
+void BasicAstroCalcs<Math>::updateTime(int Y, int M, int D, int h, int m, int s)
 {
     if (M <= 2){
         M = M + 12;
@@ -172,56 +178,332 @@ void AstroCalcs::updateTime(int Y, int M, int D, int h, int m, int s)
     _s = s;
     lst();
 
-    this->curr_pos.updateLST(this->_LST);
+    updatePosition();
 }
 
 
-String AstroCalcs::timeVars()
-{
-    return String(_Y)+"|"+String(_M)+"|"+String(_D)+"|"+ String(_h)+"|"+ String(_m)+"|"+ String(_s)+"|"+ String(_LST)+"|"+ String(_diff)/*+"|"+ String(_JD)+"|"+String(_t)*/;
-}
-
-
-void AstroCalcs::updateTimeManual(String s)
-{
-    int j = 0;
-    int i = s.indexOf("|", j);
-    _Y = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _M = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _D = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _h = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _m = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _s = s.substring(j, i).toInt();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _LST = s.substring(j, i).toFloat();
-    j = i+1;
-    i = s.indexOf("|", j);
-    _diff = s.substring(j, i).toFloat();
-    //j = i+1;
-    //i = s.indexOf("|", j);
-    //_JD = s.substring(j, i).toFloat();
-    //j = i+1;
-    //i = s.indexOf("|", j);
-    //_t = s.substring(j, i).toFloat();
+template<class Math>
+void BasicAstroCalcs<Math>::advance(double seconds)
+{
+    addElapsed(seconds);
 
-    this->curr_pos.updateLST(this->_LST);
+    if(labs(_elapsedMs) >= (long)(ASTROCALCS_RESYNC_SECONDS * 1000.0))
+    {
+        // recalculate from the Julian date, carrying the clock part of _diff along with it
+        Scalar gmstdeg = _diff + gmst() + Scalar(elapsed() * (15.0 / 3600.0));
+
+        // the whole milliseconds go into the date, and the remainder is kept for the next call
+        _ms += _elapsedMs;
+        _elapsedMs = 0;
+        normaliseDay(&_day, &_ms);
+
+        Scalar thetazero = gmst();
+
+        _LST = wrapDegrees(thetazero + _longitude);
+        _diff = gmstdeg - thetazero;
+        _syncLST = _LST;
+
+        updateEpoch();
+    }
+
+    _LST = wrapDegrees(_syncLST + secondsToLST(Scalar(elapsed())));
+
+    updatePosition();
 }
 
 
-void AstroCalcs::calcPosJ2000(double ra, double dec)
+template<class Math>
+void BasicAstroCalcs<Math>::addElapsed(double seconds)
 {
-    this->curr_pos = Position(ra, dec, this->_latitude, this->_LST);
+    double rest = _elapsedRest + seconds;
+    long ms = (long)floor(rest * 1000.0);
+    _elapsedMs += ms;
+    _elapsedRest = rest - (double)ms * 0.001;
+}
+
+
+template<class Math>
+double BasicAstroCalcs<Math>::elapsed()
+{
+    return (double)_elapsedMs * 0.001 + _elapsedRest;
+}
+
+
+template<class Math>
+void BasicAstroCalcs<Math>::resync()
+{
+    _syncLST = _LST;
+    _elapsedMs = 0;
+    _elapsedRest = 0.0;
+    updateEpoch();
+
+    updatePosition();
+}
+
+
+// the snapshot written by serialize(), every field little-endian:
+//
+//     0   "AS"                   2 bytes
+//     2   version                uint8
+//     3   precession model       uint8
+//     4   Y, M, D, h, m, s       int16 each, as held (January and February count as months 13 and 14 of the year before)
+//     16  days from J2000        int32
+//     20  milliseconds into day  int32
+//     24  LST, diff, LST at the last resync, seconds since it, longitude, latitude   IEEE double each
+//     72  CRC-32 of bytes 0-71   uint32
+
+/**
+ * Writes an unsigned integer little-endian
+ * @param p where to write it
+ * @param x the integer
+ * @param bytes the amount of bytes to write
+ * @returns acts in place on the buffer
+ */
+static void writeBytes(uint8_t* p, uint32_t x, int bytes)
+{
+    for(int i = 0; i < bytes; i++)
+    {
+        p[i] = (uint8_t)(x >> (8 * i));
+    }
+}
+
+
+/**
+ * @param p where to read from
+ * @param bytes the amount of bytes to read
+ * @returns the little-endian unsigned integer at p
+ */
+static uint32_t readBytes(const uint8_t* p, int bytes)
+{
+    uint32_t x = 0;
+    for(int i = 0; i < bytes; i++)
+    {
+        x |= (uint32_t)p[i] << (8 * i);
+    }
+    return x;
+}
+
+
+/**
+ * Writes a number as a little-endian IEEE double. AVR's 32-bit double is widened exactly, so every board writes the same bytes.
+ * @param p where to write it
+ * @param x the number
+ * @returns acts in place on the buffer
+ */
+static void writeDouble(uint8_t* p, double x)
+{
+    uint64_t bits = 0;
+    if(sizeof(double) == 8)
+    {
+        memcpy(&bits, &x, sizeof(double));
+    }
+    else
+    {
+        uint32_t f = 0;
+        memcpy(&f, &x, sizeof(f));
+        uint64_t sign = (uint64_t)(f >> 31) << 63;
+        int exponent = (int)((f >> 23) & 0xFF);
+        uint64_t mantissa = f & 0x7FFFFFUL;
+
+        if(exponent == 0xFF)
+        {
+            bits = sign | 0x7FF0000000000000ULL | (mantissa << 29);
+        }
+        else if(exponent == 0 && mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // a subnormal float is a normal double, so its leading one is shifted up into the hidden bit
+            if(exponent == 0)
+            {
+                exponent = 1;
+                while(!(mantissa & 0x800000UL))
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                mantissa &= 0x7FFFFFUL;
+            }
+            bits = sign | ((uint64_t)(exponent + 1023 - 127) << 52) | (mantissa << 29);
+        }
+    }
+    writeBytes(p, (uint32_t)bits, 4);
+    writeBytes(p + 4, (uint32_t)(bits >> 32), 4);
+}
+
+
+/**
+ * @param p where to read from
+ * @returns the little-endian IEEE double at p, rounded to the board's double
+ */
+static double readDouble(const uint8_t* p)
+{
+    uint64_t bits = (uint64_t)readBytes(p, 4) | ((uint64_t)readBytes(p + 4, 4) << 32);
+    if(sizeof(double) == 8)
+    {
+        double x;
+        memcpy(&x, &bits, sizeof(double));
+        return x;
+    }
+
+    double sign = (bits >> 63) ? -1.0 : 1.0;
+    int exponent = (int)((bits >> 52) & 0x7FF);
+    uint64_t mantissa = bits & 0xFFFFFFFFFFFFFULL;
+    if(exponent == 0x7FF)
+    {
+        return mantissa ? NAN : sign * INFINITY;
+    }
+    if(exponent == 0)
+    {
+        return sign * 0.0;
+    }
+    return sign * ldexp((double)(mantissa | (1ULL << 52)), exponent - 1075);
+}
+
+
+template<class Math>
+int BasicAstroCalcs<Math>::serialize(uint8_t* buffer, int size)
+{
+    if(size < ASTROCALCS_SNAPSHOT_SIZE)
+    {
+        return 0;
+    }
+
+    buffer[0] = 'A';
+    buffer[1] = 'S';
+    buffer[2] = ASTROCALCS_SNAPSHOT_VERSION;
+    buffer[3] = (uint8_t)_precession.getModel();
+    writeBytes(buffer + 4, (uint16_t)_Y, 2);
+    writeBytes(buffer + 6, (uint16_t)_M, 2);
+    writeBytes(buffer + 8, (uint16_t)_D, 2);
+    writeBytes(buffer + 10, (uint16_t)_h, 2);
+    writeBytes(buffer + 12, (uint16_t)_m, 2);
+    writeBytes(buffer + 14, (uint16_t)_s, 2);
+    writeBytes(buffer + 16, (uint32_t)_day, 4);
+    writeBytes(buffer + 20, (uint32_t)_ms, 4);
+    writeDouble(buffer + 24, (double)_LST);
+    writeDouble(buffer + 32, (double)_diff);
+    writeDouble(buffer + 40, (double)_syncLST);
+    writeDouble(buffer + 48, elapsed());
+    writeDouble(buffer + 56, (double)_longitude);
+    writeDouble(buffer + 64, (double)_latitude);
+    writeBytes(buffer + 72, crc32Bytes(buffer, 72), 4);
+    return ASTROCALCS_SNAPSHOT_SIZE;
+}
+
+
+template<class Math>
+bool BasicAstroCalcs<Math>::deserialize(const uint8_t* buffer, int size)
+{
+    if(size < ASTROCALCS_SNAPSHOT_SIZE || buffer[0] != 'A' || buffer[1] != 'S' || buffer[2] != ASTROCALCS_SNAPSHOT_VERSION)
+    {
+        return false;
+    }
+    if(readBytes(buffer + 72, 4) != crc32Bytes(buffer, 72))
+    {
+        return false;
+    }
+
+    _precession.setModel((PrecessionModel)buffer[3]);
+    _Y = (int16_t)readBytes(buffer + 4, 2);
+    _M = (int16_t)readBytes(buffer + 6, 2);
+    _D = (int16_t)readBytes(buffer + 8, 2);
+    _h = (int16_t)readBytes(buffer + 10, 2);
+    _m = (int16_t)readBytes(buffer + 12, 2);
+    _s = (int16_t)readBytes(buffer + 14, 2);
+    _day = (int32_t)readBytes(buffer + 16, 4);
+    _ms = (int32_t)readBytes(buffer + 20, 4);
+    _LST = Scalar(readDouble(buffer + 24));
+    _diff = Scalar(readDouble(buffer + 32));
+    _syncLST = Scalar(readDouble(buffer + 40));
+    _elapsedMs = 0;
+    _elapsedRest = 0.0;
+    addElapsed(readDouble(buffer + 48));
+    _longitude = Scalar(readDouble(buffer + 56));
+    _latitude = Scalar(readDouble(buffer + 64));
+
+    // the sync point comes from the snapshot, so advance() carries on exactly where the sender was
+    updateEpoch();
+    this->curr_pos.setLatitude(_latitude);
+    updatePosition();
+    return true;
+}
+
+
+template<class Math>
+String BasicAstroCalcs<Math>::timeVars()
+{
+    // one string grown in place, with enough places that a double LST comes back to well under a milli-arc-second
+    String s;
+    s.reserve(64);
+    s += String(_Y);
+    s += '|';
+    s += String(_M);
+    s += '|';
+    s += String(_D);
+    s += '|';
+    s += String(_h);
+    s += '|';
+    s += String(_m);
+    s += '|';
+    s += String(_s);
+    s += '|';
+    s += String((double)_LST, 9);
+    s += '|';
+    s += String((double)_diff, 9);
+    return s;
+}
+
+
+template<class Math>
+void BasicAstroCalcs<Math>::updateTimeManual(String s)
+{
+    // each field is read straight out of the string, so nothing is allocated. Every field but the last has to be followed
+    // by a '|' before stepping past it, so a short or malformed string never reads beyond its end, and changes nothing.
+    const char* p = s.c_str();
+    char* end;
+    long fields[6];
+    for(int i = 0; i < 6; i++)
+    {
+        fields[i] = strtol(p, &end, 10);
+        if(end == p || *end != '|')
+        {
+            return;
+        }
+        p = end + 1;
+    }
+    double LST = strtod(p, &end);
+    if(end == p || *end != '|')
+    {
+        return;
+    }
+    p = end + 1;
+    double diff = strtod(p, &end);
+    if(end == p)
+    {
+        return;
+    }
+
+    _Y = (int)fields[0];
+    _M = (int)fields[1];
+    _D = (int)fields[2];
+    _h = (int)fields[3];
+    _m = (int)fields[4];
+    _s = (int)fields[5];
+    _LST = Scalar(LST);
+    _diff = Scalar(diff);
+
+    jdify();
+    resync();
+}
+
+
+template<class Math>
+void BasicAstroCalcs<Math>::calcPosJ2000(Scalar ra, Scalar dec)
+{
+    this->curr_pos = BasicPosition<Math>(ra, dec, this->_latitude, this->_LST);
     precess();
     //refract();
     //curr_pos.altAz();
@@ -230,53 +512,143 @@ void AstroCalcs::calcPosJ2000(double ra, double dec)
 
 
 
-void AstroCalcs::setRADEC(double ra, double dec)
+template<class Math>
+void BasicAstroCalcs<Math>::setRADEC(Scalar ra, Scalar dec)
 {
-    this->curr_pos = Position(ra, dec, this->_latitude, this->_LST);
+    this->curr_pos = BasicPosition<Math>(ra, dec, this->_latitude, this->_LST);
+    if(_refraction)
+    {
+        refract();
+    }
 }
 
-void AstroCalcs::setAltAz(double alt, double az)
+template<class Math>
+void BasicAstroCalcs<Math>::setAltAz(Scalar alt, Scalar az)
 {
-    double altitude = radians(alt);
-	double azimuth = radians(az);
+    ASTROCALCS_PROFILE_SCOPE(PROFILE_SET_ALT_AZ);
 
-    azimuth = PI + azimuth;
-    if(azimuth > 2*PI){
-        azimuth = azimuth - 2*PI;
+    // a telescope is pointed where the target looks to be, so take the refraction off first
+    if(_refraction)
+    {
+        alt = this->_refraction->toTrue(alt);
     }
+    Scalar altitude = toRadians(alt);
+	Scalar azimuth = toRadians(az);
 
-	double l = radians(this->_latitude);
-	double t = radians(this->_LST);
+    // only the sine and cosine are used, so the half turn needs no wrapping
+    azimuth = Scalar(PI) + azimuth;
 
-	double d = asin(sin(altitude) * sin(l) + cos(altitude) * cos(azimuth) * cos(l));
-	double h = asin(sin(azimuth) * cos(altitude) / cos(d));
+	Scalar l = toRadians(this->_latitude);
 
-	double dec = degrees(d);
-	double ra = degrees(t - (PI*2 - h));
+    Scalar sin_alt, cos_alt, sin_az, cos_az, sin_l, cos_l;
+    Math::sincos(altitude, &sin_alt, &cos_alt);
+    Math::sincos(azimuth, &sin_az, &cos_az);
+    Math::sincos(l, &sin_l, &cos_l);
 
-    if(ra < 0.0){
-        ra = ra + 360.0;
-    }
+    // the target as a unit vector in the equatorial frame, so the declination and hour angle can come from atan2,
+    // which keeps its precision near the poles where asin does not. atan2(y, |x|) is asin(y / cos(d)).
+    Scalar x = sin_alt * cos_l - cos_alt * cos_az * sin_l;
+    Scalar y = sin_az * cos_alt;
+    Scalar z = sin_alt * sin_l + cos_alt * cos_az * cos_l;
 
-    this->curr_pos = Position(ra, dec, this->_latitude, this->_LST);
+	Scalar d = Math::atan2(z, hypotenuse(x, y));
+	Scalar h = Math::atan2(y, fabs(x));
+
+	Scalar dec = toDegrees(d);
+	Scalar ra = wrapDegrees(this->_LST + toDegrees(h));
+
+    this->curr_pos = BasicPosition<Math>(ra, dec, this->_latitude, this->_LST);
+    if(_refraction)
+    {
+        refract();
+    }
 }
 
 
-double AstroCalcs::getHA()
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::getHA()
 {
+    // only the hour angle, so the altitude (and its refraction) is left until it is asked for
     this->curr_pos.updateLST(this->_LST);
-    return this->curr_pos.ha;
+    return this->curr_pos.getHA();
 }
-double AstroCalcs::getRA()
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::getRA()
 {
-    return this->curr_pos.ra;
+    return this->curr_pos.getRA();
 }
-double AstroCalcs::getDec()
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::getDec()
 {
-    return this->curr_pos.dec;
+    return this->curr_pos.getDec();
 }
 
-double AstroCalcs::getLST()
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::getLST()
 {
     return _LST;
 }
+
+template<class Math>
+typename BasicAstroCalcs<Math>::Scalar BasicAstroCalcs<Math>::getGMST()
+{
+    return wrapDegrees(_LST - _longitude);
+}
+
+template<class Math>
+void BasicAstroCalcs<Math>::setPrecessionModel(PrecessionModel model)
+{
+    this->_precession.setModel(model);
+    this->_precession.update(this->_Y, julianDate(this->_day, this->_ms));
+}
+
+template<class Math>
+const BasicPrecession<Math>& BasicAstroCalcs<Math>::getPrecession()
+{
+    return this->_precession;
+}
+
+template<class Math>
+void BasicAstroCalcs<Math>::setApparent(bool apparent)
+{
+    this->_apparent = apparent;
+    updateEpoch();
+}
+
+template<class Math>
+const BasicNutation<Math>& BasicAstroCalcs<Math>::getNutation()
+{
+    return this->_nutation;
+}
+
+template<class Math>
+void BasicAstroCalcs<Math>::setRefraction(BasicRefraction<Math>* refraction)
+{
+    this->_refraction = refraction;
+    refract();
+}
+
+template<class Math>
+bool BasicAstroCalcs<Math>::setWeather(double pressure, double temperature)
+{
+    if(!this->_refraction || !this->_refraction->setWeather(pressure, temperature))
+    {
+        return false;
+    }
+    refract();
+    return true;
+}
+
+template<class Math>
+const BasicRefraction<Math>* BasicAstroCalcs<Math>::getRefraction()
+{
+    return this->_refraction;
+}
+
+
+// the trig backends the library is built with
+template class BasicAstroCalcs<ExactMath>;
+template class BasicAstroCalcs<ArcsecMath>;
+template class BasicAstroCalcs<ArcminMath>;
+template class BasicAstroCalcs<FloatMath>;
+template class BasicAstroCalcs<FixedMath>;
@@ -24,7 +24,23 @@
 
 #define ASTROCALCS_H 1
 #include "Arduino.h"
+#include "AstroMath.h"
+#include "AstroConstexpr.h"
 #include "Position.h"
+#include "Precession.h"
+#include "Nutation.h"
+#include "Refraction.h"
+
+/// how many seconds `advance()` can run from the sidereal rate before the LST is recalculated from the date
+#ifndef ASTROCALCS_RESYNC_SECONDS
+#define ASTROCALCS_RESYNC_SECONDS 600.0
+#endif
+
+/// the length in bytes of the snapshot written by `serialize()`
+#define ASTROCALCS_SNAPSHOT_SIZE 76
+
+/// the version of the snapshot layout written by `serialize()`, and the only one `deserialize()` reads
+#define ASTROCALCS_SNAPSHOT_VERSION 1
 
 
 /**
@@ -32,20 +48,26 @@
  * 
  * Many of the functions in this class were assisted by Mel Bartel's calculators that were used to make an amateur telescope.
  * @see Mel Bartels's calculators at https://www.bbastrodesigns.com/tm.html#myCalculators
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h.
+ *              Its `Scalar` is the type every angle is held and worked out in.
  */
-class AstroCalcs
+template<class Math> class BasicAstroCalcs
 {
     public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
         //double _JD;
         /// the current position
-        Position curr_pos;
+        BasicPosition<Math> curr_pos;
 
         /**
          * Astrocalcs constructor
          * @param longitude the longitude of the telescope
          * @param latitude the latitude of the telescope
          */
-        AstroCalcs(double longitude, double latitude);
+        BasicAstroCalcs(Scalar longitude, Scalar latitude);
 
         /**
          * updates the time in the library (also updating LST)
@@ -59,34 +81,91 @@ class AstroCalcs
          */
         void updateTime(int Y, int M, int D, int h, int m, int s);
 
+        /**
+         * Moves the time forward (or back) by some amount of seconds, updating the LST and the current position.
+         *
+         * Instead of recalculating the Julian date and GMST like `updateTime()`, this adds the elapsed time at the sidereal rate,
+         * which is only a few multiplies. Every `ASTROCALCS_RESYNC_SECONDS` the LST is recalculated in full from the
+         * Julian date, so any drift stays bounded. The year/month/day/hour/minute/second fields stay at the last `updateTime()`.
+         *
+         * The step is a `double` whatever the scalar type, and the time is added up as whole milliseconds and a remainder, so
+         * many small steps do not drift in float or fixed point (where 0.001 would be held 0.7% out).
+         *
+         * @see SECONDS_TO_LST
+         *
+         * @param seconds the amount of seconds since the last update, which can be a fraction of a second
+         * @returns acts in place on data in the class
+         */
+        void advance(double seconds);
+
 
         /**
          * Calculates the JNOW right ascention and declination given a J2000 right ascention and declination, factoring for precession and refraction.
          * 
+         * Nutation and annual aberration are applied after precession, giving the apparent place, unless `setApparent(false)`.
+         * With refraction tables attached by `setRefraction()` the altitude is then raised by the refraction.
+         * 
          * @param ra the J2000 right ascention
          * @param dec the J2000 declination
          * @returns acts in place on data in the class
          */
-        void calcPosJ2000(double ra, double dec);
+        void calcPosJ2000(Scalar ra, Scalar dec);
         
         /**
          * Returns the current LST
          * 
          * @returns the current LST as it is set in the library
          */
-        double getLST();
+        Scalar getLST();
+
+        /**
+         * Returns the current Greenwich mean sidereal time, which is the LST without the observer's longitude.
+         * Adding another site's longitude to it gives that site's LST, so one time update serves many sites.
+         *
+         * @see SiteBatch
+         *
+         * @returns the current GMST, in [0, 360)
+         */
+        Scalar getGMST();
+
+        /**
+         * Writes the time and observer state into a fixed-size binary snapshot, which `deserialize()` restores exactly on another
+         * board (or another Math backend) without working out the date or the sidereal time again.
+         *
+         * Every field has a fixed offset and is little-endian, with the angles as IEEE doubles whatever the board's `Scalar`,
+         * and the last four bytes are a CRC-32 of the rest. Nothing is allocated.
+         *
+         * @see ASTROCALCS_SNAPSHOT_SIZE
+         *
+         * @param buffer where the snapshot will be written
+         * @param size the length of the buffer in bytes
+         * @returns the length of the snapshot, or 0 if the buffer is shorter than `ASTROCALCS_SNAPSHOT_SIZE`
+         */
+        int serialize(uint8_t* buffer, int size);
+
+        /**
+         * Restores the time and observer state from a snapshot written by `serialize()`, and moves `curr_pos` to its LST.
+         * The state is left as it was if the snapshot is rejected.
+         *
+         * @param buffer the snapshot
+         * @param size the length of the snapshot in bytes
+         * @returns false if the snapshot is too short, is not a snapshot of this version or fails its checksum
+         */
+        bool deserialize(const uint8_t* buffer, int size);
 
         /**
          * Returns the current time-related variables as a string.
          * This can then be used to set up another instance of astrocalcs with these variables
          * to avoid recalculation of variables on boards with less power
          * 
+         * The text form of `serialize()`, kept for existing callers. The snapshot is smaller, exact and allocates nothing.
+         * 
          * @see lst()
          * @see bigt()
          * @see jdify()
          * @see updateTimeManual
          * 
-         * @returns a string formatted as `Year|Month|Day|hour|minute|second|LST|diff|JD|t`
+         * @returns a string formatted as `Year|Month|Day|hour|minute|second|LST|diff`
          */
         String timeVars();
 
@@ -94,10 +173,12 @@ class AstroCalcs
          * Sets the time-related variables from a formatted string.
          * 
          * The string is formatted as:
-         * `Year|Month|Day|hour|minute|second|LST|diff|JD|t`
+         * `Year|Month|Day|hour|minute|second|LST|diff`
          * 
-         * This can be generated from `timeVars()`
+         * This can be generated from `timeVars()`. It is read in place, without making any substrings.
+         * A string that is short or not in this form is ignored, leaving the time as it was.
          * @see timeVars()
+         * @see deserialize()
          * 
          * @param s the formatted string to extract the time variables from
          * @returns acts in place on data in the class
@@ -110,28 +191,28 @@ class AstroCalcs
          * @param dec the declination
          * @result sets the right ascention and declination of the AstroCalcs library
          */
-        void setRADEC(double ra, double dec);
+        void setRADEC(Scalar ra, Scalar dec);
 
         /**
          * returns the hour angle of the current target
          * 
          * @returns the hour angle of the current target
          */
-        double getHA();
+        Scalar getHA();
 
         /**
          * returns the right ascention
          * 
          * @returns the right ascention of the current target
          */
-        double getRA();
+        Scalar getRA();
 
         /**
          * returns the current declination
          * 
          * @returns the declination of the current target
          */
-        double getDec();
+        Scalar getDec();
         
         /**
          * Sets the altitude and the azimuth of the target, which is then converted to ra/dec
@@ -140,22 +221,93 @@ class AstroCalcs
          * @param az the azimuth
          * @returns sets the alt and az for the library, which then will convert into ra/dec internally
          */
-        void setAltAz(double alt, double az);
+        void setAltAz(Scalar alt, Scalar az);
 
         /**
          * Precess the current target position
          * 
          * @returns a new position that is precessed
          */
-        Position precess_curr_pos();
+        BasicPosition<Math> precess_curr_pos();
+
+        /**
+         * Chooses the precession model used by `calcPosJ2000()` and `precess_curr_pos()`.
+         * Takes effect straight away, and is kept through every `updateTime()`.
+         *
+         * @param model `PRECESSION_GILMORE` (the default) or `PRECESSION_IAU2006`
+         * @returns acts in place on data in the class
+         */
+        void setPrecessionModel(PrecessionModel model);
+
+        /**
+         * Returns the precession for the current time, so it can be applied to many targets
+         * (for example with `PositionBatch::precess()`) without working it out again.
+         *
+         * @returns the precession worked out at the last `updateTime()`
+         */
+        const BasicPrecession<Math>& getPrecession();
+
+        /**
+         * Chooses whether `calcPosJ2000()` corrects for nutation and annual aberration after precession (the default), giving the
+         * apparent place, or stops at the mean place of the date. Turning them off also skips working them out in `updateTime()`.
+         *
+         * @param apparent true for the apparent place, false for the mean place
+         * @returns acts in place on data in the class
+         */
+        void setApparent(bool apparent);
+
+        /**
+         * Returns the nutation and aberration for the current time, including the nutation in longitude and obliquity.
+         *
+         * @returns the nutation worked out at the last `updateTime()`, or at the last `setApparent(true)`
+         */
+        const BasicNutation<Math>& getNutation();
+
+        /**
+         * Chooses whether `curr_pos.getAlt()` is where the target looks to be through the air, raised by the refraction from
+         * `refraction`, or its true (airless) altitude, which is the default. The right ascention and declination are always
+         * the true ones.
+         *
+         * The tables belong to the caller and have to outlive their use here, so an `AstroCalcs` that never refracts does
+         * not carry them (or build them, which is about 150 sines and cosines). One set can be shared by many.
+         *
+         * While they are attached, `setAltAz()` takes the altitude a telescope is pointed at, and takes the refraction off
+         * before working out the right ascention and declination.
+         *
+         * @param refraction the refraction tables for the weather at the telescope, or NULL for the true altitude
+         * @returns acts in place on data in the class
+         */
+        void setRefraction(BasicRefraction<Math>* refraction);
+
+        /**
+         * Sets the weather on the attached refraction tables, which are only built again when it changes, so this can be
+         * called with every reading.
+         *
+         * @see BasicRefraction::setWeather()
+         *
+         * @param pressure the air pressure, in millibars (hPa), 1010 by default
+         * @param temperature the air temperature, in degrees Celsius, 10 by default
+         * @returns true if the weather changed and the tables were built again, false if it did not or none are attached
+         */
+        bool setWeather(double pressure, double temperature);
+
+        /**
+         * @returns the refraction tables attached with `setRefraction()`, or NULL
+         */
+        const BasicRefraction<Math>* getRefraction();
     
-    private:        
+    private:
+        /// lets the host benchmark (extras/benchmark) time the private stages on their own
+        friend struct AstroCalcsBenchmark;
+
         /**
          * Calculates and sets the Julian date from the date provided in the constructor
          * 
+         * The date is kept as whole days and milliseconds, so it does not lose precision in a `float`.
+         * 
          * @returns acts in place on variables in the class
          */
-        //void jdify();
+        void jdify();
 
         /**
          * Calculates the value of T for use in calculating the local sidereal time.
@@ -167,9 +319,11 @@ class AstroCalcs
         /**
          * Calculates the Greenwich Mean Sidereal Time using the Julian date and T
          * 
-         * @returns the GMST
+         * @see gmstDegrees(), which this calls, and which also works at compile time
+         * 
+         * @returns the GMST for the current `_day` and `_ms`
          */
-        //double gmst();
+        Scalar gmst();
 
         /**
          * Calculates the local sidereal time from the longitude and GMST
@@ -187,12 +341,47 @@ class AstroCalcs
         
 
         /**
-         * Corrects for refraction
+         * Works out everything that depends on the epoch (precession, and nutation and aberration if they are used) for the current date
+         *
+         * @returns acts in place on data in the class
+         */
+        void updateEpoch();
+
+        /**
+         * Attaches the refraction tables (or none) to the current position, which raises its altitude from them when it is
+         * next read
          * 
          * @returns acts in place on data
          */
         void refract();
 
+        /**
+         * Moves the current position to the current LST. The refraction tables stay attached to it.
+         *
+         * @returns acts in place on data in the class
+         */
+        void updatePosition();
+
+        /**
+         * Starts `advance()` again from the current LST and updates what depends on the time, after the state has been set directly
+         *
+         * @returns acts in place on data in the class
+         */
+        void resync();
+
+        /**
+         * Adds to the time `advance()` has moved on, carrying whole milliseconds out of the remainder
+         *
+         * @param seconds the amount of seconds
+         * @returns acts in place on data in the class
+         */
+        void addElapsed(double seconds);
+
+        /**
+         * @returns the seconds `advance()` has moved the time on since the last full calculation
+         */
+        double elapsed();
+
         /// @brief Year
         int _Y;
 
@@ -215,19 +404,58 @@ class AstroCalcs
         //double _t;
 
         /// @brief diff between local sidereal time and grenwich mean sidereal time
-        double _diff;
+        Scalar _diff;
 
         /// @brief Local sidereal time
-        double _LST;
+        Scalar _LST;
 
-        /// @brief Julian Date
-        //double _JD;
+        /// @brief whole days of the Julian Date (days from J2000) of the last full LST calculation
+        long _day;
+
+        /// @brief milliseconds into `_day`, in [0, 86400000)
+        long _ms;
+
+        /// @brief LST of the last full calculation, which `advance()` counts from
+        Scalar _syncLST;
+
+        /// @brief whole milliseconds `advance()` has moved the time on since the last full calculation
+        long _elapsedMs;
+
+        /// @brief seconds on top of `_elapsedMs`, in [0, 0.001)
+        double _elapsedRest;
+
+        /// @brief precession from J2000 to the current epoch, worked out when the time is updated
+        BasicPrecession<Math> _precession;
+
+        /// @brief nutation and aberration for the current epoch, worked out when the time is updated
+        BasicNutation<Math> _nutation;
+
+        /// @brief whether `calcPosJ2000()` gives the apparent place
+        bool _apparent;
+
+        /// @brief the caller's refraction tables, or NULL when `curr_pos.getAlt()` is not refracted
+        BasicRefraction<Math>* _refraction;
 
         /// @brief Longitude
-        double _longitude;
+        Scalar _longitude;
         
         /// @breif Latitude
-        double _latitude;
+        Scalar _latitude;
 };
 
+/// the library using the full precision C library trig functions
+typedef BasicAstroCalcs<ExactMath> AstroCalcs;
+
+/// the library using trig that is accurate to under an arc-second, for GOTO
+typedef BasicAstroCalcs<ArcsecMath> ArcsecAstroCalcs;
+
+/// the library using trig that is accurate to under an arc-minute, for display
+typedef BasicAstroCalcs<ArcminMath> ArcminAstroCalcs;
+
+/// the library in single precision, for boards with a `float` only FPU
+typedef BasicAstroCalcs<FloatMath> FloatAstroCalcs;
+
+/// the library in Q15.16 fixed point, for boards without an FPU
+typedef BasicAstroCalcs<FixedMath> FixedAstroCalcs;
+
 #endif
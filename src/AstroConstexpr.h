@@ -0,0 +1,414 @@
+/**
+ * @file AstroConstexpr.h
+ * @brief The date, sidereal time and coordinate maths as `constexpr` functions, so fixed values can be worked out when compiling
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+// Everything here is C++11 `constexpr`, so a fixed site's constants, a built-in catalog precessed to a fixed epoch, or a lookup
+// table can be put in flash by the compiler instead of being worked out at startup:
+//
+//     constexpr double SITE_LST = siderealTime(2025, 1, 1, 0, 0, 0, 172.5);
+//     static const double VEGA_RA_2030 PROGMEM = precessRa(hmsToDegrees(18, 36, 56.3), dmsToDegrees(38, 47, 1.3), 2030);
+//
+// AstroCalcs and Position call the same functions at run time, so the two always agree.
+
+#ifndef ASTROCONSTEXPR_H
+
+#define ASTROCONSTEXPR_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+
+/// milliseconds in a day
+#define MS_PER_DAY 86400000L
+
+/// 360 degrees in the units `gmstDegrees()` sums in (1e-12 degrees)
+#define PICODEGREES_PER_TURN 360000000000000LL
+
+
+/**
+ * Division that rounds down rather than towards zero
+ *
+ * @param a the numerator
+ * @param b the denominator, which must be positive
+ * @returns the largest whole number not greater than a / b
+ */
+constexpr long floorDivide(long a, long b)
+{
+    return a / b - ((a % b < 0) ? 1 : 0);
+}
+
+/**
+ * The remainder that goes with `floorDivide()`
+ *
+ * @param a the numerator
+ * @param b the denominator, which must be positive
+ * @returns a modulo b, in [0, b)
+ */
+constexpr long floorModulo(long a, long b)
+{
+    return a % b + ((a % b < 0) ? b : 0);
+}
+
+/**
+ * The whole days from J2000 of a date before the time of day is added, with January and February already counted as
+ * months 13 and 14 of the year before. The half day of the -1524.5 goes into `julianMilliseconds()`.
+ *
+ * @param Y the year
+ * @param M the month, from 3 to 14
+ * @param D the day of the month
+ * @returns the days from J2000 before the time of day is added
+ */
+constexpr long julianMarchDays(int Y, int M, int D)
+{
+    return (long)(2 - Y / 100 + (Y / 100) / 4) + (long)D + ((long)(365.25 * (Y + 4716)) - 2451545L) + (long)(30.6001 * (M + 1)) - 1525L;
+}
+
+/**
+ * The milliseconds of the time of day, counted from noon the day before as the Julian date is
+ *
+ * @param h the hour
+ * @param m the minute
+ * @param s the second
+ * @returns the milliseconds, which can be more than a day
+ */
+constexpr long julianMarchMilliseconds(int h, int m, int s)
+{
+    return MS_PER_DAY / 2 + long(h) * 3600000L + long(m) * 60000L + long(s) * 1000L;
+}
+
+/**
+ * The whole days from J2000 of a date and time, which is what `AstroCalcs` keeps the date as.
+ *
+ * Months 13 and 14 of the year before are taken as January and February, so this also takes the date as `AstroCalcs` holds it.
+ *
+ * @param Y the year
+ * @param M the month
+ * @param D the day of the month
+ * @param h the hour
+ * @param m the minute
+ * @param s the second
+ * @returns the whole days from J2000
+ */
+constexpr long julianDay(int Y, int M, int D, int h, int m, int s)
+{
+    return (M <= 2) ? julianDay(Y - 1, M + 12, D, h, m, s)
+                    : julianMarchDays(Y, M, D) + floorDivide(julianMarchMilliseconds(h, m, s), MS_PER_DAY);
+}
+
+/**
+ * The milliseconds into the day of `julianDay()`
+ *
+ * @param h the hour
+ * @param m the minute
+ * @param s the second
+ * @returns the milliseconds, in [0, 86400000)
+ */
+constexpr long julianMilliseconds(int h, int m, int s)
+{
+    return floorModulo(julianMarchMilliseconds(h, m, s), MS_PER_DAY);
+}
+
+/**
+ * @param day whole days from J2000
+ * @param ms milliseconds into the day
+ * @returns the Julian Date in days from J2000, for the work that does not need it split
+ */
+constexpr double julianDate(long day, long ms)
+{
+    return (double)day + (double)ms / (double)MS_PER_DAY;
+}
+
+/**
+ * The small t^2 and t^3 terms of the GMST
+ *
+ * @param t Julian centuries from J2000
+ * @returns the terms in 1e-12 degrees
+ */
+constexpr long long gmstCorrection(double t)
+{
+    return (long long)((0.000387933 * (t*t) - (t*t*t) / 38710000.0) * 1e12);
+}
+
+/**
+ * @param x an angle in 1e-12 degrees
+ * @returns x, but in the interval [0, PICODEGREES_PER_TURN)
+ */
+constexpr long long wrapPicodegrees(long long x)
+{
+    return (x % PICODEGREES_PER_TURN < 0) ? x % PICODEGREES_PER_TURN + PICODEGREES_PER_TURN : x % PICODEGREES_PER_TURN;
+}
+
+/**
+ * The Greenwich mean sidereal time, 280.46061837 + 360.98564736629 * jd + 0.000387933 * t^2 - t^3 / 38710000.
+ *
+ * The large terms are summed as integers (in units of 1e-12 degrees) and reduced to [0, 360) before they are turned into a
+ * double, so the GMST is good to 0.1" even in single precision. A whole day is 360.98564736629 degrees, which is
+ * 0.98564736629 once the whole turn is dropped, and a millisecond is 360.98564736629 / 86400000 degrees.
+ *
+ * @param day whole days from J2000
+ * @param ms milliseconds into the day
+ * @returns the GMST in degrees, in [0, 360)
+ */
+constexpr double gmstDegrees(long day, long ms)
+{
+    return (double)wrapPicodegrees(280460618370000LL
+                                   + (long long)day * 985647366290LL
+                                   + (long long)ms * 41780746223LL / 10000LL
+                                   + gmstCorrection(julianDate(day, ms) / 36525.0)) * 1e-12;
+}
+
+/**
+ * The local sidereal time of a date and time, as `AstroCalcs::updateTime()` works it out
+ *
+ * @param Y the year
+ * @param M the month
+ * @param D the day of the month
+ * @param h the hour
+ * @param m the minute
+ * @param s the second
+ * @param longitude the observer's longitude, east positive
+ * @returns the LST in degrees, in [0, 360)
+ */
+constexpr double siderealTime(int Y, int M, int D, int h, int m, int s, double longitude)
+{
+    return wrapDegrees(gmstDegrees(julianDay(Y, M, D, h, m, s), julianMilliseconds(h, m, s)) + longitude);
+}
+
+/**
+ * The whole part of an angle split into degrees:minutes:seconds (or hours:minutes:seconds), rounded towards zero
+ *
+ * @param x the angle
+ * @returns the whole degrees (or hours)
+ */
+template<class T> constexpr int sexagesimalWhole(T x)
+{
+    return (int)x;
+}
+
+/**
+ * The minutes of an angle split into degrees:minutes:seconds, with the same sign as the angle
+ *
+ * @param x the angle
+ * @returns the whole minutes
+ */
+template<class T> constexpr int sexagesimalMinutes(T x)
+{
+    return (int)((x - T(sexagesimalWhole(x))) * T(60.0));
+}
+
+/**
+ * The seconds of an angle split into degrees:minutes:seconds, with the same sign as the angle
+ *
+ * @param x the angle
+ * @returns the seconds
+ */
+template<class T> constexpr T sexagesimalSeconds(T x)
+{
+    return ((x - T(sexagesimalWhole(x))) * T(60.0) - T(sexagesimalMinutes(x))) * T(60.0);
+}
+
+/**
+ * @param h the hours
+ * @param m the minutes
+ * @param s the seconds
+ * @returns the angle in degrees
+ */
+constexpr double hmsToDegrees(int h, int m, double s)
+{
+    return 15.0 * ((double)h + (double)m / 60.0 + s / 3600.0);
+}
+
+/**
+ * Joins degrees:minutes:seconds into degrees. The angle is negative if any part is, so -0:30:00 can be written as (0, -30, 0).
+ *
+ * @param d the degrees
+ * @param m the minutes
+ * @param s the seconds
+ * @returns the angle in degrees
+ */
+constexpr double dmsToDegrees(int d, int m, double s)
+{
+    return (d < 0 || m < 0 || s < 0.0) ? -((double)(d < 0 ? -d : d) + (double)(m < 0 ? -m : m) / 60.0 + (s < 0.0 ? -s : s) / 3600.0)
+                                       : (double)d + (double)m / 60.0 + s / 3600.0;
+}
+
+/**
+ * The terms of the sine's Taylor series from `term` on
+ *
+ * @param x2 the angle squared
+ * @param term the current term
+ * @param k the index of the current term
+ * @returns the sum of the rest of the series
+ */
+constexpr double sineSeries(double x2, double term, int k)
+{
+    return (k > 15) ? 0.0 : term + sineSeries(x2, -term * x2 / (double)((2 * k) * (2 * k + 1)), k + 1);
+}
+
+/**
+ * The terms of the cosine's Taylor series from `term` on
+ *
+ * @param x2 the angle squared
+ * @param term the current term
+ * @param k the index of the current term
+ * @returns the sum of the rest of the series
+ */
+constexpr double cosineSeries(double x2, double term, int k)
+{
+    return (k > 15) ? 0.0 : term + cosineSeries(x2, -term * x2 / (double)((2 * k - 1) * (2 * k)), k + 1);
+}
+
+/**
+ * @param x an angle in radians
+ * @returns the same angle in [-pi, pi), where the series converge quickly
+ */
+constexpr double reduceRadians(double x)
+{
+    return x - TWO_PI * (double)floorToLong(x / TWO_PI + 0.5);
+}
+
+/**
+ * A sine that can be worked out when compiling, to double precision
+ *
+ * @param x an angle in degrees
+ * @returns the sine of x
+ */
+constexpr double sinDegrees(double x)
+{
+    return sineSeries(reduceRadians(x * DEG_TO_RAD) * reduceRadians(x * DEG_TO_RAD), reduceRadians(x * DEG_TO_RAD), 1);
+}
+
+/**
+ * A cosine that can be worked out when compiling, to double precision
+ *
+ * @param x an angle in degrees
+ * @returns the cosine of x
+ */
+constexpr double cosDegrees(double x)
+{
+    return cosineSeries(reduceRadians(x * DEG_TO_RAD) * reduceRadians(x * DEG_TO_RAD), 1.0, 1);
+}
+
+/**
+ * A tangent that can be worked out when compiling
+ *
+ * @param x an angle in degrees
+ * @returns the tangent of x
+ */
+constexpr double tanDegrees(double x)
+{
+    return sinDegrees(x) / cosDegrees(x);
+}
+
+/**
+ * Gilmore's precession in right ascention that does not depend on the target, 3.07s of time per year
+ *
+ * @param year the year to precess to
+ * @returns the offset in degrees
+ */
+constexpr double gilmoreRaOffset(int year)
+{
+    return (307.0 * (((double)year - 2000.0) / 100.0)) / 240.0;
+}
+
+/**
+ * Gilmore's precession in right ascention that is multiplied by sin(ra) tan(dec), 1.34s of time per year
+ *
+ * @param year the year to precess to
+ * @returns the scale in degrees
+ */
+constexpr double gilmoreRaScale(int year)
+{
+    return (134.0 * (((double)year - 2000.0) / 100.0)) / 240.0;
+}
+
+/**
+ * Gilmore's precession in declination, which is multiplied by cos(ra), 20.04" per year
+ *
+ * @param year the year to precess to
+ * @returns the scale in degrees
+ */
+constexpr double gilmoreDecScale(int year)
+{
+    return (2004.0 * (((double)year - 2000.0) / 100.0)) / 3600.0;
+}
+
+/**
+ * Precesses a J2000 right ascention to a fixed year with Gilmore's coefficients, as `PRECESSION_GILMORE` does.
+ * Like `Precession::apply()`, the result is not wrapped into [0, 360).
+ *
+ * @param ra the J2000 right ascention
+ * @param dec the J2000 declination
+ * @param year the year to precess to
+ * @returns the precessed right ascention
+ */
+constexpr double precessRa(double ra, double dec, int year)
+{
+    return ra + gilmoreRaOffset(year) + gilmoreRaScale(year) * sinDegrees(ra) * tanDegrees(dec);
+}
+
+/**
+ * Precesses a J2000 declination to a fixed year with Gilmore's coefficients, as `PRECESSION_GILMORE` does
+ *
+ * @param ra the J2000 right ascention
+ * @param dec the J2000 declination
+ * @param year the year to precess to
+ * @returns the precessed declination
+ */
+constexpr double precessDec(double ra, double dec, int year)
+{
+    return dec + gilmoreDecScale(year) * cosDegrees(ra);
+}
+
+/**
+ * @param a a value
+ * @param b the value it should be
+ * @param tolerance how far apart they can be
+ * @returns whether a is within the tolerance of b
+ */
+constexpr bool within(double a, double b, double tolerance)
+{
+    return a - b <= tolerance && b - a <= tolerance;
+}
+
+
+// known values, checked whenever the library is compiled. The tolerances allow for AVR, where double is 32 bits.
+
+// J2000.0 is noon on the 1st of January 2000, and the day before starts at noon on the 31st of December
+static_assert(julianDay(2000, 1, 1, 12, 0, 0) == 0 && julianMilliseconds(12, 0, 0) == 0, "J2000 is day 0");
+static_assert(julianDay(2000, 1, 1, 0, 0, 0) == -1 && julianMilliseconds(0, 0, 0) == MS_PER_DAY / 2, "midnight is half a day before");
+static_assert(julianDay(2024, 3, 1, 12, 0, 0) - julianDay(2024, 2, 28, 12, 0, 0) == 2, "2024 is a leap year");
+
+// Meeus, Astronomical Algorithms, examples 12.a and 12.b
+static_assert(within(gmstDegrees(julianDay(1987, 4, 10, 0, 0, 0), julianMilliseconds(0, 0, 0)), 197.693195, 1e-4), "GMST at 0h");
+static_assert(within(siderealTime(1987, 4, 10, 19, 21, 0, 0.0), 128.7378734, 1e-4), "GMST at 19:21");
+
+// 13h 10m 46.3668s, the GMST of example 12.a
+static_assert(sexagesimalWhole(197.693195 / 15.0) == 13 && sexagesimalMinutes(197.693195 / 15.0) == 10, "hours and minutes");
+static_assert(within(sexagesimalSeconds(197.693195 / 15.0), 46.3668, 1e-2), "seconds");
+static_assert(sexagesimalWhole(-43.52) == -43 && sexagesimalMinutes(-43.52) == -31, "negative angles round towards zero");
+static_assert(within(hmsToDegrees(13, 10, 46.3668), 197.693195, 1e-4) && within(dmsToDegrees(0, -30, 0.0), -0.5, 1e-6), "joining");
+
+static_assert(within(wrapDegrees(-30.0), 330.0, 1e-6) && within(wrapDegrees(725.0), 5.0, 1e-6), "wrapping");
+static_assert(within(sinDegrees(30.0), 0.5, 1e-6) && within(cosDegrees(-420.0), 0.5, 1e-6), "trig");
+
+// a century of precession: 1.279 + 0.558 degrees of ra at ra 90, dec 45, and 0.557 degrees of dec at ra 0
+static_assert(within(precessRa(90.0, 45.0, 2100), 91.8375, 1e-4) && within(precessDec(0.0, 10.0, 2100), 10.5566667, 1e-4), "precession");
+
+#endif
@@ -0,0 +1,357 @@
+/**
+ * @file AstroMath.h
+ * @brief Trig backends of different accuracy for Position and AstroCalcs
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef ASTROMATH_H
+
+#define ASTROMATH_H 1
+#include "Arduino.h"
+#include "Fixed.h"
+
+/**
+ * Degrees to radians, without leaving the scalar type (the `radians()` macro would turn a float into a double)
+ *
+ * @param x an angle in degrees
+ * @returns the angle in radians
+ */
+template<class T> inline T toRadians(T x)
+{
+    return x * T(DEG_TO_RAD);
+}
+
+/**
+ * Restricts an angle into the interval [0, 360) in constant time, without looping
+ *
+ * @param x an angle in degrees
+ * @returns x, but in the interval [0,360)
+ */
+template<class T> inline T wrapDegrees(T x)
+{
+    x -= T(360.0) * floor(x / T(360.0));
+    if(x >= T(360.0))
+    {
+        x -= T(360.0);
+    }
+    return x;
+}
+
+/**
+ * `floor()` for a constant expression, as the C library's is not `constexpr`
+ *
+ * @param x a number within the range of a `long`
+ * @returns the largest whole number not greater than x
+ */
+constexpr long floorToLong(double x)
+{
+    return ((double)(long)x > x) ? (long)x - 1 : (long)x;
+}
+
+/**
+ * @param x an angle in degrees, in [0, 720)
+ * @returns x, but in the interval [0,360)
+ */
+constexpr double wrapTurn(double x)
+{
+    return (x >= 360.0) ? x - 360.0 : x;
+}
+
+/**
+ * `wrapDegrees()` for doubles, which can also be worked out at compile time. Every double Math backend uses this one.
+ *
+ * @param x an angle in degrees
+ * @returns x, but in the interval [0,360)
+ */
+constexpr double wrapDegrees(double x)
+{
+    return wrapTurn(x - 360.0 * (double)floorToLong(x / 360.0));
+}
+
+/**
+ * The length of (x, y), which `Fixed` has its own version of
+ *
+ * @param x the first side
+ * @param y the second side
+ * @returns sqrt(x * x + y * y)
+ */
+template<class T> inline T hypotenuse(T x, T y)
+{
+    return sqrt(x * x + y * y);
+}
+
+/**
+ * Radians to degrees, without leaving the scalar type
+ *
+ * @param x an angle in radians
+ * @returns the angle in degrees
+ */
+template<class T> inline T toDegrees(T x)
+{
+    return x * T(RAD_TO_DEG);
+}
+
+/**
+ * The full precision trig functions from the C library.
+ *
+ * This is the default for `Position` and `AstroCalcs`.
+ */
+struct ExactMath
+{
+    typedef double Scalar;
+
+    static double sin(double x) { return ::sin(x); }
+    static double cos(double x) { return ::cos(x); }
+    static double tan(double x) { return ::tan(x); }
+    static double asin(double x) { return ::asin(x); }
+    static double atan2(double y, double x) { return ::atan2(y, x); }
+
+    static void sincos(double x, double* s, double* c)
+    {
+        *s = ::sin(x);
+        *c = ::cos(x);
+    }
+};
+
+
+/**
+ * The single precision trig functions from the C library, for boards whose floating point unit only does `float` (Cortex-M4F).
+ *
+ * `Position` and `AstroCalcs` built on this do all of their arithmetic in `float`. The Julian date is kept as whole days and
+ * milliseconds, and the sidereal time is worked out from them with integer arithmetic, so the LST stays within 0.2".
+ * Through `calcPosJ2000()` and `setAltAz()` the positions are within 0.25" of `ExactMath`.
+ */
+struct FloatMath
+{
+    typedef float Scalar;
+
+    static float sin(float x) { return ::sinf(x); }
+    static float cos(float x) { return ::cosf(x); }
+    static float tan(float x) { return ::tanf(x); }
+    static float asin(float x) { return ::asinf(x); }
+    static float atan2(float y, float x) { return ::atan2f(y, x); }
+
+    static void sincos(float x, float* s, float* c)
+    {
+        *s = ::sinf(x);
+        *c = ::cosf(x);
+    }
+};
+
+
+/**
+ * Trig functions built from short polynomials, with the coefficients supplied by `Coefficients`.
+ *
+ * Angles are reduced by quadrant to [-pi/4, pi/4] for sine and cosine, and ratios are reduced to [-tan(pi/8), tan(pi/8)]
+ * for the arctangent, so only a handful of multiply-adds are needed per function.
+ * Arcsine is worked out as `atan2(x, sqrt(1 - x^2))`, which keeps its precision near +/-1.
+ *
+ * @tparam Coefficients a struct with `sinPoly(z)`, `cosPoly(z)` and `atanPoly(z)`, where `z` is the square of the reduced argument
+ * @tparam T the scalar type the polynomials are worked out in (`double`, `float` or `Fixed`)
+ */
+template<class Coefficients, class T = double> struct PolynomialMath
+{
+    typedef T Scalar;
+
+    static T sin(T x)
+    {
+        T s, c;
+        sincos(x, &s, &c);
+        return s;
+    }
+
+    static T cos(T x)
+    {
+        T s, c;
+        sincos(x, &s, &c);
+        return c;
+    }
+
+    static T tan(T x)
+    {
+        T s, c;
+        sincos(x, &s, &c);
+        return s / c;
+    }
+
+    static T asin(T x)
+    {
+        return atan2(x, sqrt((T(1.0) - x) * (T(1.0) + x)));
+    }
+
+    static T atan2(T y, T x)
+    {
+        T ax = fabs(x);
+        T ay = fabs(y);
+        if(ax == T(0.0) && ay == T(0.0))
+        {
+            return T(0.0);
+        }
+
+        // the ratio is kept in [0, 1]
+        T a;
+        if(ay > ax)
+        {
+            a = T(PI / 2.0) - atan(ax / ay);
+        }
+        else
+        {
+            a = atan(ay / ax);
+        }
+
+        if(x < T(0.0))
+        {
+            a = T(PI) - a;
+        }
+        return (y < T(0.0)) ? -a : a;
+    }
+
+    /**
+     * Calculates the sine and cosine of `x` with one range reduction
+     *
+     * @param x the angle in radians
+     * @param s a pointer where the sine will be set
+     * @param c a pointer where the cosine will be set
+     */
+    static void sincos(T x, T* s, T* c)
+    {
+        T q = floor(x * T(2.0 / PI) + T(0.5));
+        int quadrant = (int)((long)q & 3);
+
+        // pi/2 split in two so the reduction does not lose the low bits
+        T r = (x - q * T(1.57079632673412561417E0)) - q * T(6.07710050650619224932E-11);
+        T z = r * r;
+        T sin_r = r + r * z * Coefficients::sinPoly(z);
+        T cos_r = T(1.0) + z * Coefficients::cosPoly(z);
+
+        switch(quadrant)
+        {
+            case 0: *s = sin_r;  *c = cos_r;  break;
+            case 1: *s = cos_r;  *c = -sin_r; break;
+            case 2: *s = -sin_r; *c = -cos_r; break;
+            default: *s = -cos_r; *c = sin_r; break;
+        }
+    }
+
+    private:
+        /**
+         * Arctangent of a ratio in [0, 1]
+         */
+        static T atan(T t)
+        {
+            T offset = T(0.0);
+
+            // tan(pi/8)
+            if(t > T(0.41421356237309504880))
+            {
+                offset = T(PI / 4.0);
+                t = (t - T(1.0)) / (t + T(1.0));
+            }
+            return offset + t + t * (t * t) * Coefficients::atanPoly(t * t);
+        }
+};
+
+
+/**
+ * Coefficients for `ArcsecMath`: Taylor series for sine (degree 7) and cosine (degree 8), and the Cephes single precision arctangent.
+ */
+struct ArcsecCoefficients
+{
+    template<class T> static T sinPoly(T z) { return T(-1.0 / 6.0) + z * (T(1.0 / 120.0) + z * T(-1.0 / 5040.0)); }
+    template<class T> static T cosPoly(T z) { return T(-1.0 / 2.0) + z * (T(1.0 / 24.0) + z * (T(-1.0 / 720.0) + z * T(1.0 / 40320.0))); }
+    template<class T> static T atanPoly(T z) { return T(-3.33329491539E-1) + z * (T(1.99777106478E-1) + z * (T(-1.38776856032E-1) + z * T(8.05374449538E-2))); }
+};
+
+
+/**
+ * Coefficients for `ArcminMath`: Taylor series for sine (degree 5), cosine (degree 6) and arctangent (degree 7).
+ */
+struct ArcminCoefficients
+{
+    template<class T> static T sinPoly(T z) { return T(-1.0 / 6.0) + z * T(1.0 / 120.0); }
+    template<class T> static T cosPoly(T z) { return T(-1.0 / 2.0) + z * (T(1.0 / 24.0) + z * T(-1.0 / 720.0)); }
+    template<class T> static T atanPoly(T z) { return T(-1.0 / 3.0) + z * (T(1.0 / 5.0) + z * T(-1.0 / 7.0)); }
+};
+
+
+/**
+ * Trig accurate to well under an arc-second, for GOTO.
+ *
+ * Worst-case absolute error: sin/cos 3.2e-7 (0.065"), tan 0.05" in angle, asin/atan2 8e-9 rad (0.002").
+ * Through `calcPosJ2000()` and `setAltAz()` the positions are within 0.1" of `ExactMath` (0.15" with `PRECESSION_IAU2006`).
+ */
+typedef PolynomialMath<ArcsecCoefficients> ArcsecMath;
+
+/**
+ * Trig accurate to well under an arc-minute, for display.
+ *
+ * Worst-case absolute error: sin/cos 3.7e-5 (7.5"), tan 5.9" in angle, asin/atan2 3.5e-5 rad (7.3").
+ * Through `calcPosJ2000()` and `setAltAz()` the positions are within 15" of `ExactMath` (20" with `PRECESSION_IAU2006`).
+ */
+typedef PolynomialMath<ArcminCoefficients> ArcminMath;
+
+/**
+ * The arc-second polynomials worked out in Q15.16 fixed point, for 8-bit boards where every floating point operation is done in software.
+ *
+ * The resolution of `Fixed` (1.5e-5, or 3" of arc in radians) limits this rather than the polynomials.
+ * Through `calcPosJ2000()` and `setAltAz()` the positions are within 15" of `ExactMath` (20" with `PRECESSION_IAU2006`), and the LST within 0.6".
+ */
+typedef PolynomialMath<ArcsecCoefficients, Fixed> FixedMath;
+
+
+/**
+ * Saemundsson's refraction, 1.02 cot(h + 10.3 / (h + 5.11)) arc-minutes for a true altitude of h degrees
+ *
+ * @see BasicRefraction, which tabulates it for other weather and goes both ways
+ *
+ * @tparam Math the trig backend to work it out with
+ * @param alt the true (airless) altitude, in degrees
+ * @returns how much higher refraction makes the target look, in degrees
+ */
+template<class Math> inline typename Math::Scalar refraction(typename Math::Scalar alt)
+{
+    typedef typename Math::Scalar Scalar;
+    return Scalar(1.02 / 60.0) / Math::tan(toRadians(alt + Scalar(10.3) / (alt + Scalar(5.11))));
+}
+
+/**
+ * Works out the CRC-32 (the zlib one) of some bytes, a nibble at a time so the table is 64 bytes of flash instead of 1 KB
+ *
+ * @param data the bytes
+ * @param size the amount of bytes
+ * @returns the CRC-32
+ */
+inline uint32_t crc32Bytes(const uint8_t* data, unsigned long size)
+{
+    static const uint32_t table[16] PROGMEM = {
+        0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+        0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+    };
+
+    uint32_t crc = 0xFFFFFFFFUL;
+    for(unsigned long i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ pgm_read_dword(&table[crc & 15]);
+        crc = (crc >> 4) ^ pgm_read_dword(&table[crc & 15]);
+    }
+    return ~crc;
+}
+
+#endif
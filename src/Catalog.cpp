@@ -0,0 +1,249 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "Catalog.h"
+#include "AstroMath.h"
+#include <limits.h>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// the byte order mark, as it reads on the machine that wrote the catalog
+#define CATALOG_BYTE_ORDER 0x01020304UL
+
+// amount of double columns
+#define CATALOG_DOUBLE_COLUMNS 6
+
+// bytes per target: 8 per double, 4 for the magnitude and 4 for the ID
+#define CATALOG_TARGET_BYTES (CATALOG_DOUBLE_COLUMNS * 8 + 4 + 4)
+
+// AVR's double is 4 bytes, which shortens the header, but catalogs cannot be opened there anyway
+static_assert(sizeof(double) != 8 || sizeof(CatalogHeader) == CATALOG_HEADER_SIZE, "the catalog header must be CATALOG_HEADER_SIZE bytes");
+
+
+Catalog::Catalog()
+{
+    _mapping = 0;
+    _mappingSize = 0;
+    close();
+}
+
+
+Catalog::~Catalog()
+{
+    close();
+}
+
+
+/**
+ * Checks that a catalog of `count` targets fits in `size` bytes, by dividing the size rather than multiplying the count,
+ * so a count read from an untrusted header cannot wrap around an `unsigned long` (32 bits on most boards). The count
+ * also has to fit in an `int`, which is how `size()` and the kernels take it.
+ *
+ * @param count the amount of targets
+ * @param size the length of the data in bytes
+ * @returns whether `bytes(count)` is at most `size`
+ */
+static bool fits(uint32_t count, unsigned long size)
+{
+    return size >= CATALOG_HEADER_SIZE && count <= (size - CATALOG_HEADER_SIZE) / CATALOG_TARGET_BYTES &&
+           count <= (uint32_t)INT_MAX;
+}
+
+
+unsigned long Catalog::bytes(uint32_t count)
+{
+    return CATALOG_HEADER_SIZE + (unsigned long)count * CATALOG_TARGET_BYTES;
+}
+
+
+CatalogStatus Catalog::open(const void* data, unsigned long size)
+{
+    close();
+
+    if(sizeof(double) != 8)
+    {
+        return CATALOG_UNSUPPORTED;
+    }
+    const CatalogHeader* header = (const CatalogHeader*)data;
+    if(size < CATALOG_HEADER_SIZE || ((uintptr_t)data & 7) != 0)
+    {
+        return CATALOG_TRUNCATED;
+    }
+    if(memcmp(header->magic, CATALOG_MAGIC, 4) != 0)
+    {
+        return CATALOG_BAD_MAGIC;
+    }
+    if(header->byteOrder != CATALOG_BYTE_ORDER)
+    {
+        return CATALOG_WRONG_BYTE_ORDER;
+    }
+    if(header->version != CATALOG_VERSION || header->headerSize != CATALOG_HEADER_SIZE)
+    {
+        return CATALOG_WRONG_VERSION;
+    }
+    if(!fits(header->count, size))
+    {
+        return CATALOG_TRUNCATED;
+    }
+    unsigned long n = header->count;
+
+    const double* columns = (const double*)((const uint8_t*)data + CATALOG_HEADER_SIZE);
+    this->ra = columns;
+    this->dec = columns + n;
+    this->x = columns + 2 * n;
+    this->y = columns + 3 * n;
+    this->z = columns + 4 * n;
+    this->cosDec = columns + 5 * n;
+    this->mag = (const float*)(columns + CATALOG_DOUBLE_COLUMNS * n);
+    this->id = (const uint32_t*)(this->mag + n);
+    _header = header;
+    return CATALOG_OK;
+}
+
+
+CatalogStatus Catalog::openFile(const char* path)
+{
+    close();
+#if defined(__unix__)
+    int file = ::open(path, O_RDONLY);
+    if(file < 0)
+    {
+        return CATALOG_NO_FILE;
+    }
+    struct stat info;
+    if(fstat(file, &info) != 0 || info.st_size <= 0)
+    {
+        ::close(file);
+        return CATALOG_NO_FILE;
+    }
+
+    // the pages are only read in as the columns are used, and are shared with the page cache
+    void* mapping = mmap(0, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if(mapping == MAP_FAILED)
+    {
+        return CATALOG_NO_FILE;
+    }
+
+    CatalogStatus status = open(mapping, (unsigned long)info.st_size);
+    if(status != CATALOG_OK)
+    {
+        munmap(mapping, (size_t)info.st_size);
+        return status;
+    }
+    _mapping = mapping;
+    _mappingSize = (unsigned long)info.st_size;
+    return CATALOG_OK;
+#else
+    (void)path;
+    return CATALOG_NO_FILE;
+#endif
+}
+
+
+void Catalog::close()
+{
+#if defined(__unix__)
+    if(_mapping)
+    {
+        munmap(_mapping, (size_t)_mappingSize);
+    }
+#endif
+    _mapping = 0;
+    _mappingSize = 0;
+    _header = 0;
+    this->ra = 0;
+    this->dec = 0;
+    this->x = 0;
+    this->y = 0;
+    this->z = 0;
+    this->cosDec = 0;
+    this->mag = 0;
+    this->id = 0;
+}
+
+
+CatalogStatus Catalog::verify()
+{
+    if(!_header)
+    {
+        return CATALOG_NO_FILE;
+    }
+    const uint8_t* data = (const uint8_t*)_header + CATALOG_HEADER_SIZE;
+    if(crc32Bytes(data, bytes(_header->count) - CATALOG_HEADER_SIZE) != _header->checksum)
+    {
+        return CATALOG_BAD_CHECKSUM;
+    }
+    return CATALOG_OK;
+}
+
+
+int Catalog::size()
+{
+    return _header ? (int)_header->count : 0;
+}
+
+
+double Catalog::epoch()
+{
+    return _header ? _header->epoch : 2000.0;
+}
+
+
+CatalogStatus Catalog::write(void* buffer, unsigned long size, const double* ra, const double* dec, const float* mag,
+                             const uint32_t* id, int n, double epoch)
+{
+    if(n < 0 || !fits((uint32_t)n, size))
+    {
+        return CATALOG_TRUNCATED;
+    }
+
+    CatalogHeader* header = (CatalogHeader*)buffer;
+    memset(header, 0, CATALOG_HEADER_SIZE);
+    memcpy(header->magic, CATALOG_MAGIC, 4);
+    header->byteOrder = CATALOG_BYTE_ORDER;
+    header->version = CATALOG_VERSION;
+    header->headerSize = CATALOG_HEADER_SIZE;
+    header->count = (uint32_t)n;
+    header->epoch = epoch;
+
+    double* columns = (double*)((uint8_t*)buffer + CATALOG_HEADER_SIZE);
+    float* mags = (float*)(columns + CATALOG_DOUBLE_COLUMNS * n);
+    uint32_t* ids = (uint32_t*)(mags + n);
+    for(int i = 0; i < n; i++)
+    {
+        double r = radians(ra[i]);
+        double d = radians(dec[i]);
+        columns[i] = ra[i];
+        columns[n + i] = dec[i];
+        columns[2 * n + i] = cos(d) * cos(r);
+        columns[3 * n + i] = cos(d) * sin(r);
+        columns[4 * n + i] = sin(d);
+        columns[5 * n + i] = cos(d);
+        mags[i] = mag[i];
+        ids[i] = id[i];
+    }
+
+    header->checksum = crc32Bytes((const uint8_t*)columns, bytes(n) - CATALOG_HEADER_SIZE);
+    return CATALOG_OK;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file Catalog.h
+ * @brief A binary star catalog, read in place from a memory-mapped file or from flash
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef CATALOG_H
+
+#define CATALOG_H 1
+#include "Arduino.h"
+
+/// the first four bytes of a catalog
+#define CATALOG_MAGIC "ACAT"
+
+/// the version of the format written by `Catalog::write()`, and the only one `Catalog::open()` reads
+#define CATALOG_VERSION 1
+
+/// the size of the header in bytes, which keeps the double columns after it 8-byte aligned
+#define CATALOG_HEADER_SIZE 64
+
+/**
+ * What `Catalog::open()` found
+ */
+enum CatalogStatus
+{
+    /// the catalog is open and its columns can be used
+    CATALOG_OK,
+
+    /// the data does not start with `CATALOG_MAGIC`
+    CATALOG_BAD_MAGIC,
+
+    /// the catalog is a version this library does not read
+    CATALOG_WRONG_VERSION,
+
+    /// the catalog was written on a machine with the other byte order
+    CATALOG_WRONG_BYTE_ORDER,
+
+    /// the data is shorter than the header says, or not aligned for its columns
+    CATALOG_TRUNCATED,
+
+    /// this board's `double` is not 64 bits (AVR), so the columns cannot be used in place
+    CATALOG_UNSUPPORTED,
+
+    /// the file could not be opened or mapped
+    CATALOG_NO_FILE,
+
+    /// `verify()` found the data does not match the checksum in the header
+    CATALOG_BAD_CHECKSUM
+};
+
+/**
+ * The header at the start of a catalog. Every field is in the byte order of the machine that wrote it, which is
+ * little-endian on everything the library runs on, and `byteOrder` catches the rest.
+ */
+struct CatalogHeader
+{
+    /// @brief `CATALOG_MAGIC`, not null terminated
+    char magic[4];
+
+    /// @brief 0x01020304 as it was stored by the writer, to catch a catalog from a machine with the other byte order
+    uint32_t byteOrder;
+
+    /// @brief `CATALOG_VERSION`
+    uint16_t version;
+
+    /// @brief `CATALOG_HEADER_SIZE`, so later versions can add fields
+    uint16_t headerSize;
+
+    /// @brief amount of targets
+    uint32_t count;
+
+    /// @brief the epoch of the coordinates, as a Julian year (2000.0 for J2000)
+    double epoch;
+
+    /// @brief CRC-32 of every byte after the header
+    uint32_t checksum;
+
+    /// @brief zero, for later versions
+    uint8_t reserved[CATALOG_HEADER_SIZE - 28];
+};
+
+/**
+ * Catalog Class
+ *
+ * A catalog is a header followed by one column (array) per field, in this order:
+ * right ascention, declination, the unit vector x, y and z, cos(dec) (all `double`), magnitude (`float`) and ID (`uint32_t`).
+ *
+ * `open()` only checks the header and points the columns into the data, so it takes the same time for any size of catalog,
+ * and nothing is copied. The columns are the arrays the batch routines take: for example
+ * `AltAzKernels::altAz(c.ra, c.z, c.cosDec, ...)` converts a whole catalog, as z is sin(dec).
+ *
+ * On Linux `openFile()` maps the file into memory. On boards with memory-mapped flash (ARM, ESP32, RP2040) a catalog made
+ * into a `const` array with extras/catalog is read from flash in place. AVR is not supported, as its `double` is 32 bits
+ * and its flash is not in the data address space.
+ */
+class Catalog
+{
+    public:
+        /// @brief right ascention of each target
+        const double* ra;
+
+        /// @brief declination of each target
+        const double* dec;
+
+        /// @brief x component (towards ra 0, dec 0) of each target's unit vector
+        const double* x;
+
+        /// @brief y component (towards ra 90, dec 0) of each target's unit vector
+        const double* y;
+
+        /// @brief z component (towards the pole) of each target's unit vector, which is also sin(dec)
+        const double* z;
+
+        /// @brief cosine of each declination
+        const double* cosDec;
+
+        /// @brief magnitude of each target
+        const float* mag;
+
+        /// @brief ID of each target
+        const uint32_t* id;
+
+        /**
+         * Constructor
+         *
+         * The catalog is empty until `open()` or `openFile()`.
+         */
+        Catalog();
+
+        /**
+         * Destructor
+         *
+         * Unmaps the file if `openFile()` mapped one.
+         */
+        ~Catalog();
+
+        /**
+         * Opens a catalog that is already in memory (or in memory-mapped flash). The data must stay there while the catalog is used.
+         *
+         * @param data the catalog, aligned to 8 bytes
+         * @param size the length of the data in bytes
+         * @returns `CATALOG_OK`, or why it could not be opened
+         */
+        CatalogStatus open(const void* data, unsigned long size);
+
+        /**
+         * Maps a catalog file into memory and opens it. Only on Linux (and other unix-like systems).
+         *
+         * @param path the path of the file
+         * @returns `CATALOG_OK`, or why it could not be opened
+         */
+        CatalogStatus openFile(const char* path);
+
+        /**
+         * Closes the catalog, unmapping the file if there is one.
+         *
+         * @returns acts in place on data in the class
+         */
+        void close();
+
+        /**
+         * Checks every byte against the checksum in the header. This reads the whole catalog, so it is not done by `open()`.
+         *
+         * @returns `CATALOG_OK` or `CATALOG_BAD_CHECKSUM`
+         */
+        CatalogStatus verify();
+
+        /**
+         * @returns the amount of targets in the catalog
+         */
+        int size();
+
+        /**
+         * @returns the epoch of the coordinates, as a Julian year
+         */
+        double epoch();
+
+        /**
+         * Returns the length of a catalog in bytes. On a board with a 32-bit `unsigned long` this wraps above about 76
+         * million targets, far more than fit in its memory; `open()` checks the count against the size without it.
+         *
+         * @param count the amount of targets
+         * @returns the length in bytes
+         */
+        static unsigned long bytes(uint32_t count);
+
+        /**
+         * Writes a catalog into memory, working out the unit vectors and the checksum.
+         *
+         * @param buffer where the catalog will be written, at least `bytes(n)` long and aligned to 8 bytes
+         * @param size the length of the buffer in bytes
+         * @param ra the right ascention of each target
+         * @param dec the declination of each target
+         * @param mag the magnitude of each target
+         * @param id the ID of each target
+         * @param n the amount of targets
+         * @param epoch the epoch of the coordinates, as a Julian year
+         * @returns `CATALOG_OK`, or `CATALOG_TRUNCATED` if the buffer is too short
+         */
+        static CatalogStatus write(void* buffer, unsigned long size, const double* ra, const double* dec, const float* mag,
+                                   const uint32_t* id, int n, double epoch);
+
+    private:
+        /// @brief the catalog's header, or 0 if it is not open
+        const CatalogHeader* _header;
+
+        /// @brief the file mapping made by `openFile()`, or 0
+        void* _mapping;
+
+        /// @brief the length of the file mapping in bytes
+        unsigned long _mappingSize;
+
+        // the mapping is owned by the catalog, so it must not be copied
+        Catalog(const Catalog&);
+        Catalog& operator=(const Catalog&);
+};
+
+#endif
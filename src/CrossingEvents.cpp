@@ -0,0 +1,360 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "CrossingEvents.h"
+
+
+// the events in the order they come in a day, from one rise to the next
+static const uint8_t SEQUENCE[3] = {CROSSING_RISE, CROSSING_TRANSIT, CROSSING_SET};
+
+
+/**
+ * @param event a `CrossingEvent`
+ * @returns where it is in `SEQUENCE`
+ */
+static int order(uint8_t event)
+{
+    return (event == CROSSING_RISE) ? 0 : (event == CROSSING_TRANSIT) ? 1 : 2;
+}
+
+
+/**
+ * @param t a target
+ * @param event a `CrossingEvent`
+ * @returns the hour angle the target has the event at, in degrees
+ */
+static double hourAngle(const CrossingTarget& t, uint8_t event)
+{
+    return (event == CROSSING_RISE) ? -t.arc : (event == CROSSING_SET) ? t.arc : 0.0;
+}
+
+
+/**
+ * @param t a target
+ * @returns the events the target can have: rising and setting only if it crosses its altitude
+ */
+static uint8_t possible(const CrossingTarget& t)
+{
+    return (t.kind == RISESET_RISES_AND_SETS) ? t.events : (uint8_t)(t.events & CROSSING_TRANSIT);
+}
+
+
+CrossingEvents::CrossingEvents(int capacity, double latitude)
+{
+    _owns = true;
+    init(new CrossingTarget[capacity], new int[capacity], capacity, latitude);
+}
+
+
+CrossingEvents::CrossingEvents(CrossingTarget* targets, int* heap, int capacity, double latitude)
+{
+    _owns = false;
+    init(targets, heap, capacity, latitude);
+}
+
+
+CrossingEvents::~CrossingEvents()
+{
+    if(_owns)
+    {
+        delete[] _targets;
+        delete[] _heap;
+    }
+}
+
+
+void CrossingEvents::init(CrossingTarget* targets, int* heap, int capacity, double latitude)
+{
+    _targets = targets;
+    _heap = heap;
+    _capacity = capacity;
+    _count = 0;
+    _LST = 0.0;
+    _time = 0.0;
+    _callback = NULL;
+    _context = NULL;
+    setLatitude(latitude);
+}
+
+
+void CrossingEvents::setCallback(CrossingCallback callback, void* context)
+{
+    _callback = callback;
+    _context = context;
+}
+
+
+int CrossingEvents::add(double right_ascention, double declination, double altitude, uint8_t events)
+{
+    if(_count >= _capacity)
+    {
+        return -1;
+    }
+    int i = _count++;
+    _heap[i] = i;
+    _targets[i].slot = i;
+
+    // from the bottom of the heap, so it is moved up to where it goes
+    _targets[i].due = HUGE_VAL;
+    set(i, right_ascention, declination, altitude, events);
+    return i;
+}
+
+
+void CrossingEvents::set(int i, double right_ascention, double declination, double altitude, uint8_t events)
+{
+    CrossingTarget& t = _targets[i];
+    double before = t.due;
+    t.ra = wrapDegrees(right_ascention);
+    t.sinDec = sin(radians(declination));
+    t.cosDec = cos(radians(declination));
+    t.sinAltitude = sin(radians(altitude));
+    t.events = events;
+    solve(t);
+    schedule(t);
+    if(t.due < before)
+    {
+        siftUp(t.slot);
+    }
+    else
+    {
+        siftDown(t.slot);
+    }
+}
+
+
+void CrossingEvents::clear()
+{
+    _count = 0;
+}
+
+
+int CrossingEvents::size()
+{
+    return _count;
+}
+
+
+int CrossingEvents::capacity()
+{
+    return _capacity;
+}
+
+
+void CrossingEvents::setLatitude(double latitude)
+{
+    _sinLat = sin(radians(latitude));
+    _cosLat = cos(radians(latitude));
+    for(int i = 0; i < _count; i++)
+    {
+        solve(_targets[i]);
+    }
+    scheduleAll();
+}
+
+
+void CrossingEvents::reset(double LST)
+{
+    _LST = wrapDegrees(LST);
+    _time = 0.0;
+    scheduleAll();
+}
+
+
+int CrossingEvents::updateLST(double LST)
+{
+    double current = wrapDegrees(_LST + _time * SIDEREAL_RATE);
+    return advance(wrapDegrees(LST - current) / SIDEREAL_RATE);
+}
+
+
+int CrossingEvents::advance(double seconds)
+{
+    _time += seconds;
+
+    // a target's events follow each other, so one far behind (after a long step) fires each of them in turn
+    int fired = 0;
+    while(_count > 0 && _targets[_heap[0]].due <= _time)
+    {
+        int i = _heap[0];
+        CrossingTarget& t = _targets[i];
+        if(_callback)
+        {
+            _callback(_context, i, t.next, t.due);
+        }
+        follow(t);
+        siftDown(0);
+        fired++;
+    }
+    return fired;
+}
+
+
+double CrossingEvents::now()
+{
+    return _time;
+}
+
+
+double CrossingEvents::remaining()
+{
+    return (_count > 0) ? _targets[_heap[0]].due - _time : HUGE_VAL;
+}
+
+
+const CrossingTarget& CrossingEvents::get(int i)
+{
+    return _targets[i];
+}
+
+
+void CrossingEvents::solve(CrossingTarget& t)
+{
+    // as in RiseSet::solve()
+    double denominator = _cosLat * t.cosDec;
+    double numerator = t.sinAltitude - _sinLat * t.sinDec;
+    if(numerator >= denominator)
+    {
+        t.kind = RISESET_NEVER_RISES;
+        t.arc = 0.0;
+    }
+    else if(numerator <= -denominator)
+    {
+        t.kind = RISESET_CIRCUMPOLAR;
+        t.arc = 180.0;
+    }
+    else
+    {
+        t.kind = RISESET_RISES_AND_SETS;
+        t.arc = degrees(acos(numerator / denominator));
+    }
+}
+
+
+void CrossingEvents::schedule(CrossingTarget& t)
+{
+    uint8_t events = possible(t);
+    t.due = HUGE_VAL;
+    t.next = 0;
+    if(!events)
+    {
+        return;
+    }
+
+    double ha = wrapDegrees(_LST + _time * SIDEREAL_RATE - t.ra);
+    double soonest = 360.0;
+    for(int k = 0; k < 3; k++)
+    {
+        if(events & SEQUENCE[k])
+        {
+            double left = wrapDegrees(hourAngle(t, SEQUENCE[k]) - ha);
+            if(left < soonest)
+            {
+                soonest = left;
+                t.next = SEQUENCE[k];
+            }
+        }
+    }
+    t.due = _time + soonest / SIDEREAL_RATE;
+}
+
+
+void CrossingEvents::follow(CrossingTarget& t)
+{
+    // the hour angles only go up through rise, transit and set, so the gap to the next one asked for is never negative,
+    // and the target moves on by at least a day each time round
+    uint8_t events = possible(t);
+    int from = order(t.next);
+    for(int step = 1; step <= 3; step++)
+    {
+        int k = (from + step) % 3;
+        if(events & SEQUENCE[k])
+        {
+            double gap = hourAngle(t, SEQUENCE[k]) - hourAngle(t, t.next);
+            if(k <= from)
+            {
+                gap += 360.0;
+            }
+            t.due += gap / SIDEREAL_RATE;
+            t.next = SEQUENCE[k];
+            return;
+        }
+    }
+}
+
+
+void CrossingEvents::scheduleAll()
+{
+    for(int i = 0; i < _count; i++)
+    {
+        schedule(_targets[i]);
+        _heap[i] = i;
+        _targets[i].slot = i;
+    }
+    for(int k = _count / 2 - 1; k >= 0; k--)
+    {
+        siftDown(k);
+    }
+}
+
+
+void CrossingEvents::siftUp(int k)
+{
+    int i = _heap[k];
+    double due = _targets[i].due;
+    while(k > 0)
+    {
+        int parent = (k - 1) / 2;
+        if(_targets[_heap[parent]].due <= due)
+        {
+            break;
+        }
+        _heap[k] = _heap[parent];
+        _targets[_heap[k]].slot = k;
+        k = parent;
+    }
+    _heap[k] = i;
+    _targets[i].slot = k;
+}
+
+
+void CrossingEvents::siftDown(int k)
+{
+    int i = _heap[k];
+    double due = _targets[i].due;
+    while(true)
+    {
+        int child = 2 * k + 1;
+        if(child >= _count)
+        {
+            break;
+        }
+        if(child + 1 < _count && _targets[_heap[child + 1]].due < _targets[_heap[child]].due)
+        {
+            child++;
+        }
+        if(due <= _targets[_heap[child]].due)
+        {
+            break;
+        }
+        _heap[k] = _heap[child];
+        _targets[_heap[k]].slot = k;
+        k = child;
+    }
+    _heap[k] = i;
+    _targets[i].slot = k;
+}
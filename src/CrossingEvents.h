@@ -0,0 +1,329 @@
+/**
+ * @file CrossingEvents.h
+ * @brief Predicts when each target of a catalog next rises, transits or sets, and calls back as the time passes it
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef CROSSINGEVENTS_H
+
+#define CROSSINGEVENTS_H 1
+#include "Arduino.h"
+#include "RiseSet.h"
+
+/**
+ * The events a target can have. They are bits, so a target can ask for any of them.
+ */
+enum CrossingEvent
+{
+    /// the target climbs through its altitude
+    CROSSING_RISE = 1,
+
+    /// the target is at its highest (hour angle zero)
+    CROSSING_TRANSIT = 2,
+
+    /// the target sinks through its altitude
+    CROSSING_SET = 4
+};
+
+/**
+ * Called for each event as the time passes it, in the order they happen.
+ *
+ * @param context the pointer given to `CrossingEvents::setCallback()`
+ * @param index the index of the target
+ * @param event the `CrossingEvent`
+ * @param time when it happened, in seconds on the engine's clock (see `CrossingEvents::now()`)
+ */
+typedef void (*CrossingCallback)(void* context, int index, uint8_t event, double time);
+
+/**
+ * One target in a `CrossingEvents`
+ */
+struct CrossingTarget
+{
+    /// @brief right ascention
+    double ra;
+
+    /// @brief sine of the declination
+    double sinDec;
+
+    /// @brief cosine of the declination
+    double cosDec;
+
+    /// @brief sine of the altitude it rises and sets through
+    double sinAltitude;
+
+    /// @brief the hour angle it sets at (and minus the one it rises at), in degrees
+    double arc;
+
+    /// @brief when its next event is, in seconds on the engine's clock
+    double due;
+
+    /// @brief where it is in the heap
+    int slot;
+
+    /// @brief the events asked for, as `CrossingEvent` bits
+    uint8_t events;
+
+    /// @brief the next event
+    uint8_t next;
+
+    /// @brief whether it crosses its altitude, as a `RiseSetKind`
+    uint8_t kind;
+};
+
+/**
+ * CrossingEvents Class
+ *
+ * Instead of polling every target's altitude on every tick, works out when each one next crosses its altitude (the
+ * horizon or any limit) or transits, and keeps the targets in a binary min-heap on that time. A target crosses an
+ * altitude at the hour angles +/-H of `RiseSet`, and its hour angle goes up at the sidereal rate, so the time to any event
+ * is the hour angle left over the rate.
+ *
+ * `advance()` and `updateLST()` move the clock on and take the targets off the top of the heap whose events it has passed,
+ * calling back for each one. Only the target that fired has its next event worked out, which needs no trig (its hour
+ * angles were found when it was added), so the cost goes with the amount of events, not the size of the catalog times the
+ * tick rate.
+ *
+ * The altitudes are true (airless) ones. For where a target looks to rise, pass `RiseSet::horizon()` to `add()`.
+ */
+class CrossingEvents
+{
+    public:
+        /**
+         * Constructor
+         *
+         * Allocates room for `capacity` targets on the heap.
+         *
+         * @param capacity the maximum amount of targets
+         * @param latitude the observer's latitude
+         */
+        CrossingEvents(int capacity, double latitude);
+
+        /**
+         * Constructor
+         *
+         * Uses memory provided by the caller instead of the heap, which is useful on boards where the heap should not be touched.
+         *
+         * @param targets an array of at least `capacity` targets
+         * @param heap an array of at least `capacity` ints
+         * @param capacity the maximum amount of targets
+         * @param latitude the observer's latitude
+         */
+        CrossingEvents(CrossingTarget* targets, int* heap, int capacity, double latitude);
+
+        /**
+         * Destructor
+         *
+         * Frees the arrays if they were allocated by the engine.
+         */
+        ~CrossingEvents();
+
+        /**
+         * Sets the function called for each event.
+         *
+         * @param callback the function, or NULL for none
+         * @param context a pointer handed back to it
+         * @returns acts in place on data in the class
+         */
+        void setCallback(CrossingCallback callback, void* context);
+
+        /**
+         * Adds a target, and works out its next event from now.
+         *
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @param altitude the true altitude it rises and sets through, in degrees
+         * @param events the events to call back for, as `CrossingEvent` bits
+         * @returns the index of the target, or -1 if the engine is full
+         */
+        int add(double right_ascention, double declination, double altitude = 0.0, uint8_t events = CROSSING_RISE | CROSSING_SET);
+
+        /**
+         * Replaces a target, and works out its next event from now.
+         *
+         * @param i the index of the target
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @param altitude the true altitude it rises and sets through, in degrees
+         * @param events the events to call back for, as `CrossingEvent` bits
+         * @returns acts in place on data in the class
+         */
+        void set(int i, double right_ascention, double declination, double altitude = 0.0, uint8_t events = CROSSING_RISE | CROSSING_SET);
+
+        /**
+         * Removes every target.
+         *
+         * @returns acts in place on data in the class
+         */
+        void clear();
+
+        /**
+         * @returns the amount of targets
+         */
+        int size();
+
+        /**
+         * @returns the maximum amount of targets
+         */
+        int capacity();
+
+        /**
+         * Sets the observer's latitude, and works out every target's next event again from now.
+         *
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void setLatitude(double latitude);
+
+        /**
+         * Sets the local sidereal time without calling back for anything in between, and starts the clock again from 0.
+         * Every target's next event is worked out again from here.
+         *
+         * @param LST the local sidereal time
+         * @returns acts in place on data in the class
+         */
+        void reset(double LST);
+
+        /**
+         * Moves the clock on to a new local sidereal time, such as `AstroCalcs::getLST()` after `updateTime()` or
+         * `advance()`, and calls back for every event passed. The LST has to have moved on by less than a sidereal day.
+         *
+         * @param LST the local sidereal time
+         * @returns the amount of events called back for
+         */
+        int updateLST(double LST);
+
+        /**
+         * Moves the clock on, and calls back for every event passed.
+         *
+         * @param seconds the amount of seconds, at least 0
+         * @returns the amount of events called back for
+         */
+        int advance(double seconds);
+
+        /**
+         * @returns seconds on the engine's clock since the last `reset()`
+         */
+        double now();
+
+        /**
+         * @returns the seconds before the next event, which a loop can sleep for. Infinite if no target has any.
+         */
+        double remaining();
+
+        /**
+         * @param i the index of the target
+         * @returns the target, with its next event and when it is due
+         */
+        const CrossingTarget& get(int i);
+
+    private:
+        /**
+         * Sets up the engine over its arrays.
+         *
+         * @param targets the targets
+         * @param heap the heap
+         * @param capacity the length of both
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void init(CrossingTarget* targets, int* heap, int capacity, double latitude);
+
+        /**
+         * Works out the hour angles a target crosses its altitude at.
+         *
+         * @param t the target
+         * @returns acts in place on the target
+         */
+        void solve(CrossingTarget& t);
+
+        /**
+         * Works out a target's first event after now.
+         *
+         * @param t the target
+         * @returns acts in place on the target
+         */
+        void schedule(CrossingTarget& t);
+
+        /**
+         * Works out the event after the one a target has just had, from the hour angles alone.
+         *
+         * @param t the target
+         * @returns acts in place on the target
+         */
+        void follow(CrossingTarget& t);
+
+        /**
+         * Works out every target's next event from now, and builds the heap from nothing.
+         *
+         * @returns acts in place on data in the class
+         */
+        void scheduleAll();
+
+        /**
+         * Moves the target at a place in the heap up until its parent is due before it.
+         *
+         * @param k the place in the heap
+         * @returns acts in place on the heap
+         */
+        void siftUp(int k);
+
+        /**
+         * Moves the target at a place in the heap down until both of its children are due after it.
+         *
+         * @param k the place in the heap
+         * @returns acts in place on the heap
+         */
+        void siftDown(int k);
+
+        /// @brief the targets, in the order they were added
+        CrossingTarget* _targets;
+
+        /// @brief the indices of the targets, as a binary min-heap on the time their next event is due
+        int* _heap;
+
+        /// @brief the maximum amount of targets
+        int _capacity;
+
+        /// @brief the amount of targets
+        int _count;
+
+        /// @brief whether the arrays were allocated by the engine
+        bool _owns;
+
+        /// @brief sine of the latitude
+        double _sinLat;
+
+        /// @brief cosine of the latitude
+        double _cosLat;
+
+        /// @brief the local sidereal time at the last `reset()`, in degrees
+        double _LST;
+
+        /// @brief seconds since the last `reset()`
+        double _time;
+
+        /// @brief the function called for each event
+        CrossingCallback _callback;
+
+        /// @brief the pointer handed back to it
+        void* _context;
+};
+
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file Fixed.h
+ * @brief A Q15.16 fixed point number, for boards without a floating point unit
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef FIXED_H
+
+#define FIXED_H 1
+#include "Arduino.h"
+
+/// the amount of bits after the binary point in a `Fixed`
+#define FIXED_FRACTION_BITS 16
+
+/// the raw value of 1.0 in a `Fixed`
+#define FIXED_ONE (1L << FIXED_FRACTION_BITS)
+
+/**
+ * Divides by multiplying with a reciprocal, as a 64-bit division is a long library call on boards without a divider
+ * (`__divdi3` on AVR). The divisor is shifted up into [2^31, 2^32), its reciprocal is worked out with three
+ * Newton-Raphson steps from a straight line fit, and the quotient that gives is put right from its remainder.
+ *
+ * @param n the dividend
+ * @param d the divisor
+ * @returns n / d rounded down, or 2^31 - 1 if that does not fit in 31 bits (which includes d = 0)
+ */
+inline uint32_t fixedQuotient(uint64_t n, uint32_t d)
+{
+    if(n >= ((uint64_t)d << 31))
+    {
+        return 0x7FFFFFFFUL;
+    }
+
+    // m = d * 2^shift, read as a Q0.32 number in [0.5, 1)
+    uint32_t m = d;
+    int shift = 0;
+    if(m < 0x10000UL) { m <<= 16; shift += 16; }
+    if(m < 0x1000000UL) { m <<= 8; shift += 8; }
+    if(m < 0x10000000UL) { m <<= 4; shift += 4; }
+    if(m < 0x40000000UL) { m <<= 2; shift += 2; }
+    if(m < 0x80000000UL) { m <<= 1; shift += 1; }
+
+    // 1 / m in Q1.31: 48/17 - 32/17 m is within 1/17, and each step squares the error, so three are within 2^-32
+    uint32_t r = (uint32_t)(6063670618ULL - (((uint64_t)m * 4042447078UL) >> 32));
+    for(int i = 0; i < 3; i++)
+    {
+        uint32_t error = 0UL - (uint32_t)(((uint64_t)m * r) >> 32);
+        r = (uint32_t)(((uint64_t)r * error) >> 31);
+    }
+
+    // rounding down m r can leave each step up to 2 over, and the last one is not squared away
+    r -= 2;
+
+    // n * r / 2^(63 - shift), with n split in two so the product fits in 64 bits. r is under 1 / m and every step
+    // rounds down, so q is never over and at most a few under
+    uint64_t product = (n >> 32) * r + (((n & 0xFFFFFFFFUL) * r) >> 32);
+    uint32_t q = (uint32_t)(product >> (31 - shift));
+    uint64_t remainder = n - (uint64_t)q * d;
+    while(remainder >= d)
+    {
+        q++;
+        remainder -= d;
+    }
+    return q;
+}
+
+/**
+ * Makes the Q0.32 form of a constant, for `fixedScale()`
+ *
+ * @param x the constant, in [-0.5, 0.5)
+ * @returns x multiplied by 2^32 and rounded
+ */
+constexpr int32_t fixedFraction(double x)
+{
+    return (int32_t)(x * 4294967296.0 + (x < 0.0 ? -0.5 : 0.5));
+}
+
+/**
+ * Fixed Class
+ *
+ * A signed Q15.16 number held in 32 bits: 15 bits of whole number (so +/-32767) and 16 bits of fraction (a resolution of 1.5e-5).
+ * An angle in degrees is held to 0.055", which is why the library works in degrees and only goes to radians for the trig.
+ *
+ * Constants are converted when compiling (the constructor is `constexpr`), and every operation is integer arithmetic,
+ * so on AVR there is no software floating point in the hot path. Division goes through `fixedQuotient()`, and dividing by a
+ * constant is better done with `fixedScale()`. Converting back to `double` has to be asked for with a cast.
+ * Overflow is not checked, except that a division saturates.
+ */
+class Fixed
+{
+    public:
+        /// @brief the value multiplied by 2^16
+        int32_t raw;
+
+        /**
+         * Constructor
+         *
+         * sets the value to zero
+         */
+        constexpr Fixed() : raw(0) {}
+
+        /**
+         * Constructor
+         *
+         * Rounds a number to the nearest `Fixed`. With a constant this happens when compiling.
+         *
+         * @param x the number
+         */
+        constexpr Fixed(double x) : raw((int32_t)(x * (double)FIXED_ONE + (x < 0.0 ? -0.5 : 0.5))) {}
+
+        /**
+         * Makes a `Fixed` from its raw value
+         *
+         * @param raw the value multiplied by 2^16
+         * @returns the `Fixed`
+         */
+        static Fixed fromRaw(int32_t raw)
+        {
+            Fixed f;
+            f.raw = raw;
+            return f;
+        }
+
+        /**
+         * @returns the value as a double
+         */
+        explicit operator double() const
+        {
+            return (double)this->raw / (double)FIXED_ONE;
+        }
+
+        /**
+         * @returns the value rounded towards zero, like casting a double
+         */
+        explicit operator long() const
+        {
+            return (this->raw >= 0) ? (long)(this->raw >> FIXED_FRACTION_BITS) : -(long)((-this->raw) >> FIXED_FRACTION_BITS);
+        }
+
+        /**
+         * @returns the value rounded towards zero, like casting a double
+         */
+        explicit operator int() const
+        {
+            return (int)(long)*this;
+        }
+
+        Fixed operator-() const { return fromRaw(-this->raw); }
+
+        friend Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.raw + b.raw); }
+        friend Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.raw - b.raw); }
+
+        friend Fixed operator*(Fixed a, Fixed b)
+        {
+            // rounded to nearest, so a long chain of multiplies does not drift down
+            return fromRaw((int32_t)(((int64_t)a.raw * b.raw + (FIXED_ONE >> 1)) >> FIXED_FRACTION_BITS));
+        }
+
+        friend Fixed operator/(Fixed a, Fixed b)
+        {
+            // rounded towards zero, as an integer division would be. Saturates instead of overflowing
+            uint32_t n = (a.raw < 0) ? 0UL - (uint32_t)a.raw : (uint32_t)a.raw;
+            uint32_t d = (b.raw < 0) ? 0UL - (uint32_t)b.raw : (uint32_t)b.raw;
+            int32_t q = (int32_t)fixedQuotient((uint64_t)n << FIXED_FRACTION_BITS, d);
+            return fromRaw(((a.raw < 0) != (b.raw < 0)) ? -q : q);
+        }
+
+        Fixed& operator+=(Fixed b) { this->raw += b.raw; return *this; }
+        Fixed& operator-=(Fixed b) { this->raw -= b.raw; return *this; }
+        Fixed& operator*=(Fixed b) { *this = *this * b; return *this; }
+        Fixed& operator/=(Fixed b) { *this = *this / b; return *this; }
+
+        friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+        friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+        friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+        friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+        friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+        friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+};
+
+
+/**
+ * @param x a fixed point number
+ * @returns the largest whole number not greater than x
+ */
+inline Fixed floor(Fixed x)
+{
+    return Fixed::fromRaw(x.raw & ~(int32_t)(FIXED_ONE - 1));
+}
+
+/**
+ * @param x a fixed point number
+ * @returns the smallest whole number not less than x
+ */
+inline Fixed ceil(Fixed x)
+{
+    return -floor(-x);
+}
+
+/**
+ * @param x a fixed point number
+ * @returns the absolute value of x
+ */
+inline Fixed fabs(Fixed x)
+{
+    return (x.raw < 0) ? -x : x;
+}
+
+/**
+ * Integer square root, worked out a bit at a time
+ *
+ * @param n the number
+ * @returns the square root of n, rounded down
+ */
+inline uint64_t fixedSqrt(uint64_t n)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while(bit > n)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @param x a fixed point number, which should not be negative
+ * @returns the square root of x, rounded down
+ */
+inline Fixed sqrt(Fixed x)
+{
+    if(x.raw <= 0)
+    {
+        return Fixed();
+    }
+    return Fixed::fromRaw((int32_t)fixedSqrt((uint64_t)x.raw << FIXED_FRACTION_BITS));
+}
+
+/**
+ * The length of (x, y). The squares are kept at full width, so short vectors (near the pole or the zenith) keep their precision.
+ *
+ * @param x a fixed point number
+ * @param y a fixed point number
+ * @returns sqrt(x * x + y * y)
+ */
+inline Fixed hypotenuse(Fixed x, Fixed y)
+{
+    uint64_t xx = (uint64_t)((int64_t)x.raw * x.raw);
+    uint64_t yy = (uint64_t)((int64_t)y.raw * y.raw);
+    return Fixed::fromRaw((int32_t)fixedSqrt(xx + yy));
+}
+
+/**
+ * Multiplies by a constant held in Q0.32, which keeps far more significant bits of a small constant than a `Fixed`
+ * would, so it takes the place of dividing by the constant's inverse.
+ *
+ * @param x a fixed point number
+ * @param fraction the constant, from `fixedFraction()`
+ * @returns x times the constant, rounded to nearest
+ */
+inline Fixed fixedScale(Fixed x, int32_t fraction)
+{
+    return Fixed::fromRaw((int32_t)(((int64_t)x.raw * fraction + ((int64_t)1 << 31)) >> 32));
+}
+
+/**
+ * Degrees to radians, multiplying by the degrees-to-radians constant in Q0.32
+ *
+ * @param x an angle in degrees
+ * @returns the angle in radians
+ */
+inline Fixed toRadians(Fixed x)
+{
+    return fixedScale(x, fixedFraction(DEG_TO_RAD));
+}
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ * @file Frame.h
+ * @brief One rotation matrix from J2000 straight to the horizon, worked out once per time step
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef FRAME_H
+
+#define FRAME_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+#include "Precession.h"
+#include "Nutation.h"
+#include "AltAzKernels.h"
+
+/// the frame bias from ICRS to the J2000 mean equator and equinox (IERS 2003), in arc-seconds
+#define FRAME_BIAS_RA -0.0146
+#define FRAME_BIAS_XI -0.0166170
+#define FRAME_BIAS_ETA -0.0068192
+
+/**
+ * Frame Class
+ *
+ * `calcPosJ2000()` takes a target through each stage in turn: precession in degrees, then a new `Position`, then `altAz()`,
+ * with a sine and cosine to go into each stage and an arctangent to come out of it. Every stage is a rotation though, so
+ * they can be multiplied into one matrix first:
+ *
+ *     horizon = latitude * Earth rotation (LST) * nutation * precession * frame bias
+ *
+ * The part that depends on the epoch (bias, precession and nutation) is put together in `update()`, once per time update,
+ * and the Earth rotation and latitude are put on it in `setLST()`, which costs one sine and cosine and 45 multiply-adds per
+ * time step. Then a J2000 unit vector (such as the columns of a `Catalog`) goes to the horizon with one matrix-vector
+ * product and two arctangents, and no trig that depends on the target.
+ *
+ * Annual aberration moves each target by a different amount, so it is not a rotation and is left out: with nutation this
+ * gives the true place, which is up to 20.5" from the apparent place of `calcPosJ2000()`. Refraction is left out as well.
+ *
+ * The matrix is worked out in double precision, then held in `Math::Scalar`.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h
+ */
+template<class Math> class BasicFrame
+{
+    public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
+        /// @brief rotation matrix taking a J2000 unit vector to the south, west and up components at the observer
+        Scalar matrix[3][3];
+
+        /**
+         * Constructor
+         *
+         * Starts at J2000 with no precession, at an LST of 0.
+         *
+         * @param latitude the observer's latitude
+         */
+        BasicFrame(double latitude)
+        {
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    this->_celestial[i][j] = (i == j) ? 1.0 : 0.0;
+                }
+            }
+            this->_LST = 0.0;
+            setLatitude(latitude);
+        }
+
+        /**
+         * Sets the observer's latitude.
+         *
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void setLatitude(double latitude)
+        {
+            this->_sinLat = ::sin(radians(latitude));
+            this->_cosLat = ::cos(radians(latitude));
+            setLST(this->_LST);
+        }
+
+        /**
+         * Puts together the part of the rotation that depends on the epoch. Call it after each `AstroCalcs::updateTime()`
+         * (or less often, as it changes slowly), then `setLST()`.
+         *
+         * @param precession the precession to the epoch, such as `AstroCalcs::getPrecession()`
+         * @param nutation the nutation at the epoch, such as `&AstroCalcs::getNutation()`, or NULL to leave it out
+         * @param bias whether the targets are ICRS (Hipparcos, Gaia) rather than J2000 mean places, and need the frame bias
+         * @returns acts in place on data in the class
+         */
+        void update(const BasicPrecession<Math>& precession, const BasicNutation<Math>* nutation = NULL, bool bias = false)
+        {
+            double m[3][3];
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    m[i][j] = (double)precession.matrix[i][j];
+                }
+            }
+
+            if(bias)
+            {
+                // the bias is a few hundredths of an arc-second, so its first order rotation is exact to 1e-14
+                double a = ARCSEC_TO_RADIANS(FRAME_BIAS_RA);
+                double xi = ARCSEC_TO_RADIANS(FRAME_BIAS_XI);
+                double eta = ARCSEC_TO_RADIANS(FRAME_BIAS_ETA);
+                double b[3][3] = {{1.0, a, -xi}, {-a, 1.0, -eta}, {xi, eta, 1.0}};
+                multiply(m, b, m);
+            }
+
+            if(nutation)
+            {
+                // R1(-eps) R3(-dpsi) R1(eps0)
+                double obliquity = radians(nutation->obliquity);
+                double mean = obliquity - ARCSEC_TO_RADIANS(nutation->deps);
+                double psi = ARCSEC_TO_RADIANS(nutation->dpsi);
+                double sin_e = ::sin(obliquity), cos_e = ::cos(obliquity);
+                double sin_m = ::sin(mean), cos_m = ::cos(mean);
+                double sin_p = ::sin(psi), cos_p = ::cos(psi);
+                double n[3][3] = {
+                    {cos_p, -sin_p * cos_m, -sin_p * sin_m},
+                    {sin_p * cos_e, cos_p * cos_e * cos_m + sin_e * sin_m, cos_p * cos_e * sin_m - sin_e * cos_m},
+                    {sin_p * sin_e, cos_p * sin_e * cos_m - cos_e * sin_m, cos_p * sin_e * sin_m + cos_e * cos_m}
+                };
+                multiply(n, m, m);
+            }
+
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    this->_celestial[i][j] = m[i][j];
+                }
+            }
+            setLST(this->_LST);
+        }
+
+        /**
+         * Puts the Earth rotation and the latitude on the epoch's rotation, giving `matrix` for one time step.
+         *
+         * @param LST the local sidereal time, such as `AstroCalcs::getLST()`
+         * @returns acts in place on data in the class
+         */
+        void setLST(double LST)
+        {
+            this->_LST = LST;
+            double sin_t = ::sin(radians(LST));
+            double cos_t = ::cos(radians(LST));
+
+            // the hour angle frame is R2 of the colatitude away from the horizon: south, west and up
+            double e[3][3] = {
+                {this->_sinLat * cos_t, this->_sinLat * sin_t, -this->_cosLat},
+                {sin_t, -cos_t, 0.0},
+                {this->_cosLat * cos_t, this->_cosLat * sin_t, this->_sinLat}
+            };
+            double m[3][3];
+            multiply(e, this->_celestial, m);
+
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    this->matrix[i][j] = Scalar(m[i][j]);
+                    this->_flat[i * 3 + j] = m[i][j];
+                }
+            }
+        }
+
+        /**
+         * Calculates the altitude and azimuth of one J2000 unit vector.
+         *
+         * @param x the x component (towards ra 0, dec 0)
+         * @param y the y component (towards ra 90, dec 0)
+         * @param z the z component (towards the pole)
+         * @param alt a pointer where the altitude will be set
+         * @param az a pointer where the azimuth will be set
+         * @returns acts in place on the pointers
+         */
+        void apply(Scalar x, Scalar y, Scalar z, Scalar* alt, Scalar* az) const
+        {
+            Scalar south = this->matrix[0][0] * x + this->matrix[0][1] * y + this->matrix[0][2] * z;
+            Scalar west = this->matrix[1][0] * x + this->matrix[1][1] * y + this->matrix[1][2] * z;
+            Scalar up = this->matrix[2][0] * x + this->matrix[2][1] * y + this->matrix[2][2] * z;
+
+            Scalar azimuth = toDegrees(Math::atan2(west, south)) + Scalar(180.0);
+            *az = (azimuth >= Scalar(360.0)) ? azimuth - Scalar(360.0) : azimuth;
+            *alt = toDegrees(Math::atan2(up, hypotenuse(south, west)));
+        }
+
+        /**
+         * Calculates the altitude and azimuth of one J2000 coordinate.
+         *
+         * @param ra the J2000 right ascention
+         * @param dec the J2000 declination
+         * @param alt a pointer where the altitude will be set
+         * @param az a pointer where the azimuth will be set
+         * @returns acts in place on the pointers
+         */
+        void applyRaDec(Scalar ra, Scalar dec, Scalar* alt, Scalar* az) const
+        {
+            Scalar sin_r, cos_r, sin_d, cos_d;
+            Math::sincos(toRadians(ra), &sin_r, &cos_r);
+            Math::sincos(toRadians(dec), &sin_d, &cos_d);
+            apply(cos_d * cos_r, cos_d * sin_r, sin_d, alt, az);
+        }
+
+        /**
+         * Calculates the altitude and azimuth of many J2000 unit vectors, such as the `x`, `y` and `z` columns of a `Catalog`.
+         * With `ExactMath` this is the vector kernel `AltAzKernels::frame()`.
+         *
+         * @param x the x component (towards ra 0, dec 0) of each unit vector
+         * @param y the y component (towards ra 90, dec 0) of each unit vector
+         * @param z the z component (towards the pole) of each unit vector
+         * @param alt where the altitudes will be set
+         * @param az where the azimuths will be set
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        void altAz(const Scalar* x, const Scalar* y, const Scalar* z, Scalar* alt, Scalar* az, int n) const
+        {
+            for(int i = 0; i < n; i++)
+            {
+                apply(x[i], y[i], z[i], alt + i, az + i);
+            }
+        }
+
+        /**
+         * @returns the local sidereal time of `matrix`
+         */
+        double getLST() const
+        {
+            return this->_LST;
+        }
+
+    private:
+        /**
+         * Multiplies two 3x3 matrices. The result can be either of them.
+         *
+         * @param a the left matrix
+         * @param b the right matrix
+         * @param out where a times b will be set
+         * @returns acts in place on `out`
+         */
+        static void multiply(const double a[3][3], const double b[3][3], double out[3][3])
+        {
+            double m[3][3];
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    m[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+                }
+            }
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    out[i][j] = m[i][j];
+                }
+            }
+        }
+
+        /// @brief bias, precession and nutation, from `update()`
+        double _celestial[3][3];
+
+        /// @brief `matrix` in double precision, row by row, for `AltAzKernels::frame()`
+        double _flat[9];
+
+        /// @brief the local sidereal time, in degrees
+        double _LST;
+
+        /// @brief sine of the latitude
+        double _sinLat;
+
+        /// @brief cosine of the latitude
+        double _cosLat;
+};
+
+/// `AltAzKernels::frame()`, which works on 2 or 4 targets per instruction
+template<> inline void BasicFrame<ExactMath>::altAz(const double* x, const double* y, const double* z, double* alt, double* az, int n) const
+{
+    AltAzKernels::frame(this->_flat, x, y, z, alt, az, n);
+}
+
+/// frame rotation using the full precision C library trig functions
+typedef BasicFrame<ExactMath> Frame;
+
+/// frame rotation in single precision
+typedef BasicFrame<FloatMath> FloatFrame;
+
+/// frame rotation in Q15.16 fixed point
+typedef BasicFrame<FixedMath> FixedFrame;
+
+#endif
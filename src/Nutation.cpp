@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "Nutation.h"
+
+
+// arc-seconds in a full turn, which the fundamental arguments are reduced by
+#define TURN_ARCSEC 1296000.0
+
+// the series coefficients are in units of 0.1 micro-arc-seconds
+#define SERIES_UNIT_ARCSEC 1e-7
+
+// the planetary terms of IAU 2000B, which are left out, replaced by a fixed offset (in arc-seconds)
+#define PLANETARY_PSI_ARCSEC -0.000135
+#define PLANETARY_EPS_ARCSEC 0.000388
+
+/**
+ * One term of the luni-solar series
+ */
+struct NutationTerm
+{
+    /// multiples of l, l', F, D and Omega
+    int8_t argument[5];
+
+    /// sin and t*sin coefficients of the longitude, then the cos term that goes with them
+    int32_t psi[3];
+
+    /// cos and t*cos coefficients of the obliquity, then the sin term that goes with them
+    int32_t eps[3];
+};
+
+// the largest NUTATION_TERMS terms of IAU 2000B (McCarthy & Luzum 2003), largest first
+static const NutationTerm NUTATION_SERIES[] PROGMEM = {
+    {{ 0,  0,  0,  0,  1}, {-172064161, -174666,  33386}, {92052331,  9086,  15377}},
+    {{ 0,  0,  2, -2,  2}, { -13170906,   -1675, -13696}, { 5730336, -3015,  -4587}},
+    {{ 0,  0,  2,  0,  2}, {  -2276413,    -234,   2796}, {  978459,  -485,   1374}},
+    {{ 0,  0,  0,  0,  2}, {   2074554,     207,   -698}, { -897492,   470,   -291}},
+    {{ 0,  1,  0,  0,  0}, {   1475877,   -3633,  11817}, {   73871,  -184,  -1924}},
+    {{ 0,  1,  2, -2,  2}, {   -516821,    1226,   -524}, {  224386,  -677,   -174}},
+    {{ 1,  0,  0,  0,  0}, {    711159,      73,   -872}, {   -6750,     0,    358}},
+    {{ 0,  0,  2,  0,  1}, {   -387298,    -367,    380}, {  200728,    18,    318}},
+    {{ 1,  0,  2,  0,  2}, {   -301461,     -36,    816}, {  129025,   -63,    367}},
+    {{ 0, -1,  2, -2,  2}, {    215829,    -494,    111}, {  -95929,   299,    132}},
+    {{ 0,  0,  2, -2,  1}, {    128227,     137,    181}, {  -68982,    -9,     39}},
+    {{-1,  0,  2,  0,  2}, {    123457,      11,     19}, {  -53311,    32,     -4}},
+    {{-1,  0,  0,  2,  0}, {    156994,      10,   -168}, {   -1235,     0,     82}},
+    {{ 1,  0,  0,  0,  1}, {     63110,      63,     27}, {  -33228,     0,     -9}},
+    {{-1,  0,  0,  0,  1}, {    -57976,     -63,   -189}, {   31429,     0,    -75}},
+    {{-1,  0,  2,  2,  2}, {    -59641,     -11,    149}, {   25543,   -11,     66}},
+    {{ 1,  0,  2,  0,  1}, {    -51613,     -42,    129}, {   26366,     0,     78}},
+    {{-2,  0,  2,  0,  1}, {     45893,      50,     31}, {  -24236,   -10,     20}},
+    {{ 0,  0,  0,  2,  0}, {     63384,      11,   -150}, {   -1220,     0,     29}},
+    {{ 0,  0,  2,  2,  2}, {    -38571,      -1,    158}, {   16452,   -11,     68}}
+};
+
+static_assert(NUTATION_TERMS <= sizeof(NUTATION_SERIES) / sizeof(NUTATION_SERIES[0]), "NUTATION_TERMS is more than the table holds");
+
+
+/**
+ * @param arcsec an angle in arc-seconds
+ * @returns the angle reduced to one turn, in radians
+ */
+static double fundamental(double arcsec)
+{
+    return fmod(arcsec, TURN_ARCSEC) * (PI / 648000.0);
+}
+
+
+void nutationSeries(double t, double* dpsi, double* deps)
+{
+    // the Delaunay arguments of IAU 2000B: the Moon's and the Sun's mean anomaly, the Moon's argument of latitude,
+    // the elongation of the Moon from the Sun, and the longitude of the Moon's ascending node
+    double arguments[5] = {
+        fundamental(485868.249036 + 1717915923.2178 * t),
+        fundamental(1287104.79305 + 129596581.0481 * t),
+        fundamental(335779.526232 + 1739527262.8478 * t),
+        fundamental(1072260.70369 + 1602961601.2090 * t),
+        fundamental(450160.398036 - 6962890.5431 * t)
+    };
+
+    // summed smallest first, so the small terms are not lost against the large ones in single precision
+    double psi = 0.0;
+    double eps = 0.0;
+    for(int i = NUTATION_TERMS - 1; i >= 0; i--)
+    {
+        const NutationTerm* term = &NUTATION_SERIES[i];
+        double angle = 0.0;
+        for(int j = 0; j < 5; j++)
+        {
+            angle += (double)(int8_t)pgm_read_byte(&term->argument[j]) * arguments[j];
+        }
+        double s = sin(angle);
+        double c = cos(angle);
+
+        psi += ((double)(int32_t)pgm_read_dword(&term->psi[0]) + (double)(int32_t)pgm_read_dword(&term->psi[1]) * t) * s
+             + (double)(int32_t)pgm_read_dword(&term->psi[2]) * c;
+        eps += ((double)(int32_t)pgm_read_dword(&term->eps[0]) + (double)(int32_t)pgm_read_dword(&term->eps[1]) * t) * c
+             + (double)(int32_t)pgm_read_dword(&term->eps[2]) * s;
+    }
+
+    *dpsi = psi * SERIES_UNIT_ARCSEC + PLANETARY_PSI_ARCSEC;
+    *deps = eps * SERIES_UNIT_ARCSEC + PLANETARY_EPS_ARCSEC;
+}
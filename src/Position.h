@@ -25,9 +25,94 @@
 
 #define POSITION_H 1
 #include "Arduino.h"
+#include "AstroMath.h"
+#include "AstroConstexpr.h"
+#include "Angle.h"
+#include "Profile.h"
+#include "Refraction.h"
+
+/// the rate the local sidereal time advances, in degrees per second of time (one sidereal day per 86164.09 seconds)
+#define SIDEREAL_RATE (360.98564736629 / 86400.0)
 
 /// a macro for converting a value in seconds to the increment in LST, instead of recalculating it from the ground up.
-#define SECONDS_TO_LST(x) ((x)*0.00423611)
+#define SECONDS_TO_LST(x) ((x)*SIDEREAL_RATE)
+
+/// how many samples `Position::track()` and `PositionBatch::track()` turn the hour angle on by its recurrence before
+/// working out its sine and cosine again
+#ifndef POSITION_TRACK_RESEED
+#define POSITION_TRACK_RESEED 16
+#endif
+
+/// `POSITION_TRACK_RESEED` in fixed point, where the sine and cosine of a step are only held to 1.5e-5, so each turn
+/// can be 1.6" out
+#ifndef POSITION_TRACK_RESEED_FIXED
+#define POSITION_TRACK_RESEED_FIXED 2
+#endif
+
+/**
+ * Set to 1 to keep the public `ra`, `dec`, `LST`, `latitude`, `ha`, `alt` and `az` fields of a position for one more
+ * release, worked out straight away as they were before `getHA()`, `getAlt()` and `getAz()` took them over. Deprecated:
+ * it goes in the next release, so move to the getters while it is on.
+ */
+#ifndef POSITION_LEGACY_FIELDS
+#define POSITION_LEGACY_FIELDS 0
+#endif
+
+#if POSITION_LEGACY_FIELDS
+#warning "POSITION_LEGACY_FIELDS is deprecated and goes in the next release: use getRA(), getDec(), getHA(), getAlt() and getAz()"
+#endif
+
+/// the bit in a position's dirty flags for when its hour angle has to be worked out again
+#define POSITION_DIRTY_HA 1
+
+/// the bit in a position's dirty flags for when its altitude and azimuth have to be worked out again
+#define POSITION_DIRTY_ALT_AZ 2
+
+/// the bit in a position's dirty flags for when its altitude is the true one, and the refraction still has to be added
+#define POSITION_DIRTY_REFRACT 4
+
+/**
+ * `SECONDS_TO_LST()` without leaving the scalar type
+ *
+ * @param x an amount of seconds
+ * @returns the increment in LST, in degrees
+ */
+template<class T> inline T secondsToLST(T x)
+{
+    return x * T(SIDEREAL_RATE);
+}
+
+/**
+ * `SECONDS_TO_LST()` in fixed point, multiplying by the rate in Q0.32, which holds it to far more significant bits than
+ * a `Fixed` could.
+ *
+ * @param x an amount of seconds
+ * @returns the increment in LST, in degrees
+ */
+inline Fixed secondsToLST(Fixed x)
+{
+    return fixedScale(x, fixedFraction(SIDEREAL_RATE));
+}
+
+/**
+ * @param x any value of the scalar type, which picks the overload
+ * @returns how many samples `Position::track()` can run its recurrence for in this scalar type
+ */
+template<class T> inline int trackReseed(T x)
+{
+    (void)x;
+    return POSITION_TRACK_RESEED;
+}
+
+/**
+ * @param x any fixed point value, which picks the overload
+ * @returns how many samples `Position::track()` can run its recurrence for in fixed point
+ */
+inline int trackReseed(Fixed x)
+{
+    (void)x;
+    return POSITION_TRACK_RESEED_FIXED;
+}
 
 /**
  * Position Class
@@ -35,52 +120,42 @@
  * Useful for storing data about a position.
  * 
  * This class has functions that are used in converting from right ascention and declination to altitude and azimuth.
+ * It holds the target (right ascention and declination) and the observer (latitude and LST), and works out the hour angle
+ * and the altitude and azimuth the first time they are asked for, keeping them until one of those changes. A position that
+ * is only moved on and passed along costs no trig.
  * It also contains functions for parsing ra/dec and alt/az decimals to degrees/minutes/seconds or hour/minutes/seconds for display.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h.
+ *              Its `Scalar` is the type every angle is held and worked out in.
  */
-class Position
+template<class Math> class BasicPosition
 {
     public:
-        /// @brief hour angle
-        double ha;
-
-        /// @brief right ascention
-        double ra;
-
-        /// @brief declination
-        double dec;
-
-        /// @brief local sidereal time
-        double LST;
-
-        /// @brief latitude
-        double latitude;
-
-        /// @brief altitude
-        double alt;
-
-        /// @brief azimuth
-        double az;
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
 
         /**
          * Constructor
          * 
          * sets all values to zero
          */
-        Position()
+        BasicPosition()
         {
-            this->ra = 0.0;
-            this->dec = 0.0;
-            this->ha = 0.0;
-            this->latitude = 0.0;
-            this->LST = 0.0;
-            this->alt = 0.0;
-            this->az = 0.0;
+            this->ra = Scalar(0.0);
+            this->dec = Scalar(0.0);
+            this->latitude = Scalar(0.0);
+            this->LST = Scalar(0.0);
+            this->ha = Scalar(0.0);
+            this->alt = Scalar(0.0);
+            this->az = Scalar(0.0);
+            this->_refraction = NULL;
+            this->_dirty = 0;
         }
 
         /**
          * Constructor
          * 
-         * Calculates the hour angle, altitude and azimuth of the target
+         * The hour angle, altitude and azimuth are worked out when they are first asked for.
          * 
          * @param right_ascention sets the R.A. of the position
          * @param declination sets the declination of the position
@@ -88,43 +163,182 @@ class Position
          * @param latitude the observers latitude
          * @param LST the observers LST
          */
-        Position(double right_ascention, double declination, int offset, double latitude, double LST)
+        BasicPosition(Scalar right_ascention, Scalar declination, int offset, Scalar latitude, Scalar LST)
         {
             this->ra = (limit(right_ascention));
             this->dec = (declination);
-
-            LST = limit(LST + SECONDS_TO_LST(offset));
-
-            this->ha = (limit(LST - right_ascention));
-
-            this->LST = (LST);
+            this->LST = limit(LST + secondsToLST(Scalar(offset)));
             this->latitude = (latitude);
-
-            this->altAz();
+            this->_refraction = NULL;
+            this->_dirty = 0;
+            this->invalidate(POSITION_DIRTY_HA | POSITION_DIRTY_ALT_AZ);
         }
 
         /**
          * Constructor
          * 
-         * Calculates the hour angle, altitude and azimuth of the target
+         * The hour angle, altitude and azimuth are worked out when they are first asked for.
          * 
          * @param r the right ascention
          * @param d the declination
          * @param latitude the observer's latitude
          * @param LST the local sidereal time
          */
-        Position(double r, double d, double latitude, double LST)
+        BasicPosition(Scalar r, Scalar d, Scalar latitude, Scalar LST)
         {
             this->ra = (limit(r));
             this->dec = (d);
-
-            this->ha = (limit(LST - r));
             this->LST = limit(LST);
             this->latitude = (latitude);
+            this->_refraction = NULL;
+            this->_dirty = 0;
+            this->invalidate(POSITION_DIRTY_HA | POSITION_DIRTY_ALT_AZ);
+        }
+
+        /**
+         * @returns the right ascention
+         */
+        Scalar getRA() const
+        {
+            return this->ra;
+        }
+
+        /**
+         * @returns the declination
+         */
+        Scalar getDec() const
+        {
+            return this->dec;
+        }
+
+        /**
+         * @returns the local sidereal time
+         */
+        Scalar getLST() const
+        {
+            return this->LST;
+        }
+
+        /**
+         * @returns the observer's latitude
+         */
+        Scalar getLatitude() const
+        {
+            return this->latitude;
+        }
+
+        /**
+         * @returns the hour angle, worked out from the LST and right ascention if they have changed
+         */
+        Scalar getHA() const
+        {
+            if(this->_dirty & POSITION_DIRTY_HA)
+            {
+                this->ha = wrapDegrees(this->LST - this->ra);
+                this->_dirty &= ~POSITION_DIRTY_HA;
+            }
+            return this->ha;
+        }
+
+        /**
+         * @returns the altitude, worked out by `altAz()` if the position has changed since it last was, and raised by the
+         *          refraction when tables are attached with `setRefraction()`
+         */
+        Scalar getAlt() const
+        {
+            if(this->_dirty & POSITION_DIRTY_ALT_AZ)
+            {
+                this->altAz();
+            }
+            if((this->_dirty & POSITION_DIRTY_REFRACT) && this->_refraction)
+            {
+                this->refract();
+            }
+            return this->alt;
+        }
+
+        /**
+         * @returns the azimuth, worked out by `altAz()` if the position has changed since it last was
+         */
+        Scalar getAz() const
+        {
+            if(this->_dirty & POSITION_DIRTY_ALT_AZ)
+            {
+                this->altAz();
+            }
+            return this->az;
+        }
+
+        /**
+         * Moves the position to another target. The hour angle, altitude and azimuth are worked out again when next asked for.
+         *
+         * @param r the right ascention
+         * @param d the declination
+         * @returns acts in place on data in the class
+         */
+        void setRADEC(Scalar r, Scalar d)
+        {
+            this->ra = limit(r);
+            this->dec = d;
+            this->invalidate(POSITION_DIRTY_HA | POSITION_DIRTY_ALT_AZ);
+        }
+
+        /**
+         * Moves the observer to another latitude. The altitude and azimuth are worked out again when next asked for.
+         *
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void setLatitude(Scalar latitude)
+        {
+            this->latitude = latitude;
+            this->invalidate(POSITION_DIRTY_ALT_AZ);
+        }
 
-            //this->az = 0.0;
-            //this->alt = 0.0;
-            this->altAz();
+        /**
+         * Stores an altitude and azimuth that have been worked out elsewhere, such as by a batch kernel, in place of the ones
+         * `altAz()` would give. They are kept until the target, LST or latitude changes.
+         *
+         * @param alt the true altitude, which is refracted when read if tables are attached
+         * @param az the azimuth
+         * @returns acts in place on data in the class
+         */
+        void cacheAltAz(Scalar alt, Scalar az)
+        {
+            this->alt = alt;
+            this->az = az;
+            this->_dirty &= ~POSITION_DIRTY_ALT_AZ;
+            this->refractLater();
+        }
+
+        /**
+         * Chooses whether `getAlt()` is the apparent altitude, raised by the refraction from `refraction`, or the true
+         * altitude. The refraction is only added when the altitude is next read, so moving the LST or asking for the hour
+         * angle does not pay for the alt/az trig. Copies of the position share the tables, which belong to the caller; after
+         * changing their weather, attach them again so an altitude raised by the old weather is worked out afresh.
+         *
+         * @param refraction the refraction tables, or NULL for the true altitude
+         * @returns acts in place on data in the class
+         */
+        void setRefraction(const BasicRefraction<Math>* refraction)
+        {
+            // an altitude that has already been raised cannot be lowered again, so it is worked out afresh
+            if(this->_refraction && !(this->_dirty & (POSITION_DIRTY_ALT_AZ | POSITION_DIRTY_REFRACT)))
+            {
+                this->_dirty |= POSITION_DIRTY_ALT_AZ;
+            }
+            this->_refraction = refraction;
+            this->_dirty &= ~POSITION_DIRTY_REFRACT;
+            this->refractLater();
+            this->invalidate(0);
+        }
+
+        /**
+         * @returns the refraction tables attached with `setRefraction()`, or NULL
+         */
+        const BasicRefraction<Math>* getRefraction() const
+        {
+            return this->_refraction;
         }
 
         /**
@@ -134,20 +348,15 @@ class Position
          * 
          * @param h an integer pointer where the hours will be set
          * @param m an integer pointer where the minutes will be set
-         * @param s a double pointer to where the seconds will be set
+         * @param s a pointer to where the seconds will be set
          * @returns acts in place on data
          */
-        void raHMS(int* h, int* m, double* s)
+        void raHMS(int* h, int* m, Scalar* s)
         {
-            double hours = (this->ra / 360.0) * 24.0;
-            int rah = floor((this->ra / 360.0) * 24.0);
-            double minutes = (hours - (double)rah) * 60.0;
-            int ram = floor(minutes);
-            double ras = (minutes - (double)ram) * 60.0;
-
-            *h = rah;
-            *m = ram;
-            *s = ras;
+            Scalar hours = this->ra / Scalar(15.0);
+            *h = sexagesimalWhole(hours);
+            *m = sexagesimalMinutes(hours);
+            *s = sexagesimalSeconds(hours);
         }
 
         /**
@@ -157,105 +366,76 @@ class Position
          * 
          * @param d an integer pointer to where the degrees will be set
          * @param m an integer pointer to where the minutes will be set
-         * @param s a double pointer to where the seconds will be set
+         * @param s a pointer to where the seconds will be set
          * @returns acts in place on data
          */
-        void decDMS(int* d, int* m, double* s)
+        void decDMS(int* d, int* m, Scalar* s)
         {
-            if(this->dec >=0.0)
-            {
-                int decd = floor(this->dec);
-                double minutes = (this->dec - (double)decd) * 60.0;
-                int decm = floor(minutes);
-                double decs = (minutes - (double)decm) * 60.0;
-                *d = decd;
-                *m = decm;
-                *s = decs;
-            }
-            else
-            {
-                int decd = ceil(this->dec);
-                double minutes = (this->dec - (double)decd) * 60.0;
-                int decm = ceil(minutes);
-                double decs = (minutes - (double)decm) * 60.0;
-                *d = decd;
-                *m = decm;
-                *s = decs;
-            }
+            // rounded towards zero, so a negative angle has negative minutes and seconds
+            *d = sexagesimalWhole(this->dec);
+            *m = sexagesimalMinutes(this->dec);
+            *s = sexagesimalSeconds(this->dec);
         }
 
         /**
          * Computes the degrees:minutes:seconds for the current altitude.
          * 
-         * Run the `altAz()` function before doing this.
-         * 
          * @param d an integer pointer where the degrees will be set
          * @param m an integer pointer where the minutes will be set
-         * @param s a double pointer to where the seconds will be set
+         * @param s a pointer to where the seconds will be set
          * @returns acts in place on data
          */
-        void altDMS(int* d, int* m, double* s)
+        void altDMS(int* d, int* m, Scalar* s)
         {
-            if(this->alt >=0.0)
-            {
-                int altd = floor(this->alt);
-                double minutes = (this->alt - (double)altd) * 60.0;
-                int altm = floor(minutes);
-                double alts = (minutes - (double)altm) * 60.0;
-                *d = altd;
-                *m = altm;
-                *s = alts;
-            }
-            else
-            {
-                int altd = ceil(this->alt);
-                double minutes = (this->alt - (double)altd) * 60.0;
-                int altm = ceil(minutes);
-                double alts = (minutes - (double)altm) * 60.0;
-                *d = altd;
-                *m = altm;
-                *s = alts;
-            }
+            // rounded towards zero, so a negative angle has negative minutes and seconds
+            Scalar alt = this->getAlt();
+            *d = sexagesimalWhole(alt);
+            *m = sexagesimalMinutes(alt);
+            *s = sexagesimalSeconds(alt);
         }
 
         /**
          * Computes the degrees:minutes:seconds for the current azimuth.
          * 
-         * Run the `altAz()` function before doing this.
-         * 
          * @param d an integer pointer where the degrees will be set
          * @param m an integer pointer where the minutes will be set
-         * @param s a double pointer to where the seconds will be set
+         * @param s a pointer to where the seconds will be set
          * @returns acts in place on data
          */
-        void azDMS(int* d, int* m, double* s)
+        void azDMS(int* d, int* m, Scalar* s)
         {
-            int azd = floor(this->az);
-            double minutes = (this->az - (double)azd) * 60.0;
-            int azm = floor(minutes);
-            double azs = (minutes - (double)azm) * 60.0;
-            *d = azd;
-            *m = azm;
-            *s = azs;
+            Scalar az = this->getAz();
+            *d = sexagesimalWhole(az);
+            *m = sexagesimalMinutes(az);
+            *s = sexagesimalSeconds(az);
         }
 
         /**
-         * Calculates the alt/az for the current hour angle / declination of the target.
-         * Call this as soon as possible after the LST is set.
-         * 
-         * To retrieve the result, access position.alt and position.az.
+         * Calculates the alt/az for the current hour angle / declination of the target now, instead of when `getAlt()` or
+         * `getAz()` next asks for them.
          * 
          * @returns acts in place on the data in the class
          */
-        void altAz()
+        void altAz() const
         {
-            double h = radians(this->ha);
-            double d = radians(this->dec);
-            double l = radians(this->latitude);
-            double azimuth = PI + atan2(sin(h), cos(h) * sin(l) - tan(d) * cos(l));
-            double altitude = asin(sin(l) * sin(d) + cos(h) * cos(d) * cos(l));
-            this->az = limit(degrees(azimuth));
-            this->alt = degrees(altitude);
+            ASTROCALCS_PROFILE_SCOPE(PROFILE_ALT_AZ);
+
+            Scalar sin_h, cos_h, sin_d, cos_d, sin_l, cos_l;
+            Math::sincos(toRadians(this->getHA()), &sin_h, &cos_h);
+            Math::sincos(toRadians(this->dec), &sin_d, &cos_d);
+            Math::sincos(toRadians(this->latitude), &sin_l, &cos_l);
+
+            // the target as a unit vector in the horizon frame. Multiplying through by cos(dec) instead of using tan(dec),
+            // and taking the altitude from atan2 instead of asin, keeps the precision near the poles and the zenith
+            Scalar x = cos_h * cos_d * sin_l - sin_d * cos_l;
+            Scalar y = sin_h * cos_d;
+            Scalar z = sin_l * sin_d + cos_h * cos_d * cos_l;
+
+            // in degrees before the half turn is added, so a fixed point azimuth keeps its resolution
+            this->az = wrapDegrees(Scalar(180.0) + toDegrees(Math::atan2(y, x)));
+            this->alt = toDegrees(Math::atan2(z, hypotenuse(x, y)));
+            this->_dirty &= ~POSITION_DIRTY_ALT_AZ;
+            this->refractLater();
         }
 
         /**
@@ -264,48 +444,243 @@ class Position
          * 
          * @returns acts in place on data in the class.
          */
-        void increment(double t)
+        void increment(Scalar t)
+        {
+            this->updateLST(this->LST + secondsToLST(t));
+        }
+
+        /**
+         * Works out where the target is at `count` times, `step` seconds apart, the first `start` seconds after the position's
+         * LST. Each sample is the position `increment()` would give, without the trig of a new hour angle for every one.
+         *
+         * Only the hour angle changes from one sample to the next, so its sine and cosine are turned on by the step with an
+         * angle-addition (rotation) recurrence, and the declination and latitude terms are worked out once. Every
+         * `POSITION_TRACK_RESEED` samples (`POSITION_TRACK_RESEED_FIXED` in fixed point) the sine and cosine are worked
+         * out from the hour angle again, so rounding in the recurrence cannot build up. A sample then costs the two
+         * `atan2` for the altitude and azimuth.
+         *
+         * The LST is summed with compensation, so in single precision it stays within a rounding of the exact time. In fixed
+         * point the step itself is rounded to 0.05", which adds up over the track the same as it would for `increment()`.
+         *
+         * @see PositionBatch::track()
+         *
+         * @param start the seconds from the position's LST to the first sample, which can be negative
+         * @param step the seconds between samples, which can be negative
+         * @param count the amount of samples
+         * @param out an array of at least `count` positions, where the samples will be set
+         * @returns acts in place on the array
+         */
+        void track(Scalar start, Scalar step, int count, BasicPosition<Math>* out) const
         {
-            this->LST = limit(this->LST + SECONDS_TO_LST(t));
-            this->ha = (limit(LST - this->ra));
-            this->altAz();
+            Scalar sin_d, cos_d, sin_l, cos_l, sin_step, cos_step;
+            Math::sincos(toRadians(this->dec), &sin_d, &cos_d);
+            Math::sincos(toRadians(this->latitude), &sin_l, &cos_l);
+
+            Scalar turn = secondsToLST(step);
+            Math::sincos(toRadians(turn), &sin_step, &cos_step);
+
+            // x = cos(h) a - b, y = sin(h) cos(d), z = c + cos(h) e, as in altAz()
+            Scalar a = cos_d * sin_l;
+            Scalar b = sin_d * cos_l;
+            Scalar c = sin_l * sin_d;
+            Scalar e = cos_d * cos_l;
+
+            // the LST is summed with Kahan's compensation, so a long track in single precision is not rounded at every step
+            Scalar LST = wrapDegrees(this->LST + secondsToLST(start));
+            Scalar lost = Scalar(0.0);
+            Scalar sin_h = Scalar(0.0);
+            Scalar cos_h = Scalar(1.0);
+            int reseed = trackReseed(turn);
+            int turns = reseed;
+            for(int k = 0; k < count; k++)
+            {
+                Scalar hour_angle = wrapDegrees(LST - this->ra);
+                if(turns == reseed)
+                {
+                    Math::sincos(toRadians(hour_angle), &sin_h, &cos_h);
+                    turns = 1;
+                }
+                else
+                {
+                    Scalar turned = sin_h * cos_step + cos_h * sin_step;
+                    cos_h = cos_h * cos_step - sin_h * sin_step;
+                    sin_h = turned;
+                    turns++;
+                }
+
+                Scalar x = cos_h * a - b;
+                Scalar y = sin_h * cos_d;
+                Scalar z = c + cos_h * e;
+
+                BasicPosition<Math>& sample = out[k];
+                sample.ra = this->ra;
+                sample.dec = this->dec;
+                sample.latitude = this->latitude;
+                sample.LST = LST;
+                sample.ha = hour_angle;
+                sample.az = wrapDegrees(Scalar(180.0) + toDegrees(Math::atan2(y, x)));
+                sample.alt = toDegrees(Math::atan2(z, hypotenuse(x, y)));
+                sample._refraction = this->_refraction;
+                sample._dirty = 0;
+                sample.refractLater();
+
+                Scalar add = turn - lost;
+                Scalar next = LST + add;
+                lost = (next - LST) - add;
+                LST = wrapDegrees(next);
+            }
         }
 
         /**
-         * Updates the local sidereal time in the position. Useful in calculating the alt/az.
+         * Updates the local sidereal time in the position. The hour angle, altitude and azimuth are worked out again when
+         * next asked for.
          * @param LST the local sidereal time.
          * @returns acts in place on data in class.
          */
-        void updateLST(double LST)
+        void updateLST(Scalar LST)
         {
             this->LST = limit(LST);
-            this->ha = (limit(this->LST - this->ra));
-            this->altAz();
+            this->invalidate(POSITION_DIRTY_HA | POSITION_DIRTY_ALT_AZ);
+        }
+
+        /**
+         * Updates the local sidereal time from a binary angle. The hour angle is the difference of the two angles,
+         * which wraps for free, so neither needs limiting.
+         * @param LST the local sidereal time.
+         * @returns acts in place on data in class.
+         */
+        void updateLST(Angle LST)
+        {
+            this->LST = LST.getDegrees<Scalar>();
+            this->ha = (LST - raAngle()).template getDegrees<Scalar>();
+            this->_dirty &= ~POSITION_DIRTY_HA;
+            this->invalidate(POSITION_DIRTY_ALT_AZ);
+        }
+
+        /**
+         * @returns the right ascention as a binary angle
+         */
+        Angle raAngle() const
+        {
+            return Angle::fromDegrees(this->ra);
+        }
+
+        /**
+         * @returns the hour angle as a binary angle
+         */
+        Angle haAngle() const
+        {
+            return Angle::fromDegrees(this->getHA());
+        }
+
+        /**
+         * @returns the local sidereal time as a binary angle
+         */
+        Angle lstAngle() const
+        {
+            return Angle::fromDegrees(this->LST);
+        }
+
+        /**
+         * @returns the azimuth as a binary angle
+         */
+        Angle azAngle() const
+        {
+            return Angle::fromDegrees(this->getAz());
         }
 
     private:
         /**
-         * Restricts a value into the interval [0, 360)
-         * @param x a double of degrees.
-         * @returns x, but in the interval [0,360)
+         * Marks worked out values as out of date. With `POSITION_LEGACY_FIELDS` they are worked out again straight away
+         * instead, so the public fields can be read as they are.
+         *
+         * @param bits `POSITION_DIRTY_HA` and/or `POSITION_DIRTY_ALT_AZ`
+         * @returns acts in place on data in the class
+         */
+        void invalidate(uint8_t bits)
+        {
+            this->_dirty |= bits;
+#if POSITION_LEGACY_FIELDS
+            this->getAlt();
+#endif
+        }
+
+        /**
+         * Marks a true altitude that has just been worked out, so `getAlt()` adds the refraction if tables are attached
+         *
+         * @returns acts in place on data in the class
          */
-        double limit(double x)
+        void refractLater() const
         {
-            int diff = floor(x/360);
-            
-            for(int i = 0; i < diff; i++)
+            if(this->_refraction)
             {
-                x -= 360.0;
+                this->_dirty |= POSITION_DIRTY_REFRACT;
             }
+        }
 
-            diff = ceil(-x/360);
+        /**
+         * Raises the true altitude by the refraction from the attached tables. Only the altitude changes, the right
+         * ascention and declination stay the true ones.
+         *
+         * @returns acts in place on data in the class
+         */
+        void refract() const
+        {
+            ASTROCALCS_PROFILE_SCOPE(PROFILE_REFRACT);
 
-            for(int i = 0; i < diff; i++)
-            {
-                x += 360.0;
-            }
-            return x;
+            this->alt = this->_refraction->toApparent(this->alt);
+            this->_dirty &= ~POSITION_DIRTY_REFRACT;
+        }
+
+        /**
+         * Restricts a value into the interval [0, 360), in constant time
+         * @param x an angle in degrees.
+         * @returns x, but in the interval [0,360)
+         */
+        Scalar limit(Scalar x)
+        {
+            return wrapDegrees(x);
         }
+
+        /// @brief which of the worked out values are out of date (`POSITION_DIRTY_HA`, `POSITION_DIRTY_ALT_AZ` and
+        /// `POSITION_DIRTY_REFRACT`). First, so a copy moves it with the padding after it instead of in a piece of its own.
+        mutable uint8_t _dirty;
+
+        /// @brief the caller's refraction tables, or NULL when `getAlt()` is the true altitude
+        const BasicRefraction<Math>* _refraction;
+
+#if POSITION_LEGACY_FIELDS
+    public:
+#endif
+        /// @brief right ascention
+        Scalar ra;
+
+        /// @brief declination
+        Scalar dec;
+
+        /// @brief local sidereal time
+        Scalar LST;
+
+        /// @brief latitude
+        Scalar latitude;
+
+        /// @brief hour angle, when `POSITION_DIRTY_HA` is clear
+        mutable Scalar ha;
+
+        /// @brief altitude, when `POSITION_DIRTY_ALT_AZ` is clear
+        mutable Scalar alt;
+
+        /// @brief azimuth, when `POSITION_DIRTY_ALT_AZ` is clear
+        mutable Scalar az;
 };
 
+/// a position using the full precision C library trig functions
+typedef BasicPosition<ExactMath> Position;
+
+/// a position held and worked out in single precision
+typedef BasicPosition<FloatMath> FloatPosition;
+
+/// a position held and worked out in Q15.16 fixed point
+typedef BasicPosition<FixedMath> FixedPosition;
+
 #endif
\ No newline at end of file
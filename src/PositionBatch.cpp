@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "PositionBatch.h"
+#include "AltAzKernels.h"
+
+
+// amount of arrays that make up a batch
+#define POSITIONBATCH_ARRAYS 7
+
+
+PositionBatch::PositionBatch(int capacity, double latitude)
+{
+    _capacity = capacity;
+    _owns = true;
+    assign(new double[bufferSize(capacity)]);
+    clear();
+    setLatitude(latitude);
+    _LST = 0.0;
+}
+
+
+PositionBatch::PositionBatch(double* buffer, int capacity, double latitude)
+{
+    _capacity = capacity;
+    _owns = false;
+    assign(buffer);
+    clear();
+    setLatitude(latitude);
+    _LST = 0.0;
+}
+
+
+PositionBatch::~PositionBatch()
+{
+    if(_owns)
+    {
+        delete[] this->ra;
+    }
+}
+
+
+int PositionBatch::bufferSize(int capacity)
+{
+    return POSITIONBATCH_ARRAYS * capacity;
+}
+
+
+void PositionBatch::assign(double* buffer)
+{
+    this->ra = buffer;
+    this->dec = buffer + _capacity;
+    this->ha = buffer + 2 * _capacity;
+    this->alt = buffer + 3 * _capacity;
+    this->az = buffer + 4 * _capacity;
+    _sinDec = buffer + 5 * _capacity;
+    _cosDec = buffer + 6 * _capacity;
+}
+
+
+int PositionBatch::add(double right_ascention, double declination)
+{
+    if(_count >= _capacity)
+    {
+        return -1;
+    }
+    set(_count, right_ascention, declination);
+    this->ha[_count] = 0.0;
+    this->alt[_count] = 0.0;
+    this->az[_count] = 0.0;
+    return _count++;
+}
+
+
+void PositionBatch::set(int i, double right_ascention, double declination)
+{
+    double d = radians(declination);
+    this->ra[i] = wrapDegrees(right_ascention);
+    this->dec[i] = declination;
+    _sinDec[i] = sin(d);
+    _cosDec[i] = cos(d);
+}
+
+
+void PositionBatch::clear()
+{
+    _count = 0;
+}
+
+
+int PositionBatch::size()
+{
+    return _count;
+}
+
+
+int PositionBatch::capacity()
+{
+    return _capacity;
+}
+
+
+void PositionBatch::setLatitude(double latitude)
+{
+    double l = radians(latitude);
+    _latitude = latitude;
+    _sinLat = sin(l);
+    _cosLat = cos(l);
+}
+
+
+void PositionBatch::updateLST(double LST)
+{
+    _LST = wrapDegrees(LST);
+    altAz();
+}
+
+
+void PositionBatch::altAz()
+{
+    AltAzKernels::altAz(this->ra, _sinDec, _cosDec, _LST, _sinLat, _cosLat, this->ha, this->alt, this->az, _count);
+}
+
+
+void PositionBatch::setAltAz(const double* altitudes, const double* azimuths, int n)
+{
+    if(n > _capacity)
+    {
+        n = _capacity;
+    }
+    _count = n;
+    AltAzKernels::raDec(altitudes, azimuths, _LST, _sinLat, _cosLat, this->ra, this->dec, _sinDec, _cosDec, n);
+    altAz();
+}
+
+
+void PositionBatch::track(double start, double step, int count, double* alt, double* az)
+{
+    double LST = wrapDegrees(_LST + SECONDS_TO_LST(start));
+    AltAzKernels::track(this->ra, _sinDec, _cosDec, LST, SECONDS_TO_LST(step), _sinLat, _cosLat, alt, az, count, _count);
+}
+
+
+void PositionBatch::precess(const Precession& precession)
+{
+    // the hour angle, altitude and azimuth columns hold the unit vectors, as altAz() writes over them afterwards
+    double* x = this->ha;
+    double* y = this->alt;
+    double* z = this->az;
+
+    for(int i = 0; i < _count; i++)
+    {
+        double r = radians(this->ra[i]);
+        x[i] = _cosDec[i] * cos(r);
+        y[i] = _cosDec[i] * sin(r);
+        z[i] = _sinDec[i];
+    }
+
+    precession.rotate(x, y, z, x, y, z, _count);
+
+    for(int i = 0; i < _count; i++)
+    {
+        double cos_d = sqrt(x[i] * x[i] + y[i] * y[i]);
+        this->ra[i] = wrapDegrees(degrees(atan2(y[i], x[i])));
+        this->dec[i] = degrees(atan2(z[i], cos_d));
+
+        // the rotation keeps the vector unit length, so the declination cache comes straight from it
+        _sinDec[i] = z[i];
+        _cosDec[i] = cos_d;
+    }
+
+    altAz();
+}
+
+
+void PositionBatch::precess(int year)
+{
+    Precession precession(PRECESSION_GILMORE);
+    precession.update(year, 0.0);
+    precess(precession);
+}
+
+
+void PositionBatch::riseSet(double* rise, double* transit, double* set, uint8_t* kind, double altitude, int iterations)
+{
+    double h = radians(RiseSet::horizon(altitude, iterations));
+    RiseSet::solve(this->ra, _sinDec, _cosDec, _LST, _sinLat, _cosLat, sin(h), rise, transit, set, kind, _count);
+}
+
+
+Position PositionBatch::get(int i)
+{
+    Position p(this->ra[i], this->dec[i], _latitude, _LST);
+    p.cacheAltAz(this->alt[i], this->az[i]);
+    return p;
+}
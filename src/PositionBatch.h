@@ -0,0 +1,279 @@
+/**
+ * @file PositionBatch.h
+ * @brief A structure-of-arrays container for converting many targets at once
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef POSITIONBATCH_H
+
+#define POSITIONBATCH_H 1
+#include "Arduino.h"
+#include "Position.h"
+#include "Precession.h"
+#include "RiseSet.h"
+
+/**
+ * PositionBatch Class
+ *
+ * Holds a whole catalog of targets as contiguous arrays (one array per coordinate) instead of one `Position` per target.
+ *
+ * `updateLST()`, `altAz()` and `precess()` work over every target in a single call. The sine and cosine of each declination
+ * and of the latitude are cached, so a new LST only costs the hour angle terms and two `atan2` per target.
+ * The results are the same as building a `Position` for every target, to within `ALTAZKERNELS_TOLERANCE`.
+ */
+class PositionBatch
+{
+    public:
+        /// @brief right ascention of each target
+        double* ra;
+
+        /// @brief declination of each target
+        double* dec;
+
+        /// @brief hour angle of each target
+        double* ha;
+
+        /// @brief altitude of each target
+        double* alt;
+
+        /// @brief azimuth of each target
+        double* az;
+
+        /**
+         * Constructor
+         *
+         * Allocates room for `capacity` targets on the heap.
+         *
+         * @param capacity the maximum amount of targets in the batch
+         * @param latitude the observer's latitude
+         */
+        PositionBatch(int capacity, double latitude);
+
+        /**
+         * Constructor
+         *
+         * Uses memory provided by the caller instead of the heap, which is useful on boards where the heap should not be touched.
+         *
+         * @see bufferSize()
+         *
+         * @param buffer an array of at least `bufferSize(capacity)` doubles
+         * @param capacity the maximum amount of targets in the batch
+         * @param latitude the observer's latitude
+         */
+        PositionBatch(double* buffer, int capacity, double latitude);
+
+        /**
+         * Destructor
+         *
+         * Frees the arrays if they were allocated by the batch.
+         */
+        ~PositionBatch();
+
+        /**
+         * Returns the amount of doubles needed for a caller-provided buffer
+         *
+         * @param capacity the maximum amount of targets in the batch
+         * @returns the length of the buffer in doubles
+         */
+        static int bufferSize(int capacity);
+
+        /**
+         * Adds a target to the end of the batch.
+         *
+         * The hour angle, altitude and azimuth of the target are not calculated until the next `altAz()` or `updateLST()`.
+         *
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @returns the index of the target, or -1 if the batch is full
+         */
+        int add(double right_ascention, double declination);
+
+        /**
+         * Replaces the right ascention and declination of a target.
+         *
+         * @param i the index of the target
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @returns acts in place on data in the class
+         */
+        void set(int i, double right_ascention, double declination);
+
+        /**
+         * Removes every target from the batch.
+         *
+         * @returns acts in place on data in the class
+         */
+        void clear();
+
+        /**
+         * @returns the amount of targets in the batch
+         */
+        int size();
+
+        /**
+         * @returns the maximum amount of targets in the batch
+         */
+        int capacity();
+
+        /**
+         * Sets the observer's latitude.
+         *
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void setLatitude(double latitude);
+
+        /**
+         * Updates the local sidereal time, then recalculates the hour angle, altitude and azimuth of every target.
+         *
+         * @param LST the local sidereal time
+         * @returns acts in place on data in the class
+         */
+        void updateLST(double LST);
+
+        /**
+         * Calculates the hour angle, altitude and azimuth of every target for the current LST.
+         *
+         * @see Position::altAz()
+         * @see AltAzKernels::altAz()
+         *
+         * @returns acts in place on data in the class
+         */
+        void altAz();
+
+        /**
+         * Replaces the targets in the batch with altitude/azimuth pairs, which are converted into ra/dec for the current LST.
+         *
+         * @see AstroCalcs::setAltAz()
+         * @see AltAzKernels::raDec()
+         *
+         * @param altitudes the altitude of each target
+         * @param azimuths the azimuth of each target
+         * @param n the amount of targets, at most `capacity()`
+         * @returns acts in place on data in the class
+         */
+        void setAltAz(const double* altitudes, const double* azimuths, int n);
+
+        /**
+         * Corrects every J2000 coordinate in the batch for precession, then recalculates the altitude and azimuth.
+         *
+         * Each target is turned into a unit vector and multiplied by the precession matrix, so nothing that depends on the
+         * time is worked out per target. Pass `AstroCalcs::getPrecession()` to use the library's epoch and model.
+         *
+         * @param precession the precession for the epoch to precess to
+         * @returns acts in place on data in the class
+         */
+        void precess(const Precession& precession);
+
+        /**
+         * Corrects every J2000 coordinate in the batch for precession with the Gilmore model, then recalculates the altitude and azimuth.
+         *
+         * This is the rotation with the same first order effect as `AstroCalcs::precess()`, which agrees with it to under an arc-second
+         * away from the poles.
+         *
+         * @param year the year to precess to
+         * @returns acts in place on data in the class
+         */
+        void precess(int year);
+
+        /**
+         * Works out the altitude and azimuth of every target in the batch at `count` times, `step` seconds apart, the first
+         * `start` seconds after the current LST. The batch itself is left as it is.
+         *
+         * For dense tracks to plot or schedule from. Only the hour angle changes from one sample to the next, so its sine and
+         * cosine are turned on by the step instead of being worked out again, and the samples of a target go through the
+         * vector kernels a vector at a time.
+         *
+         * @see Position::track()
+         * @see AltAzKernels::track()
+         *
+         * @param start the seconds from the current LST to the first sample, which can be negative
+         * @param step the seconds between samples, which can be negative
+         * @param count the amount of samples of each target
+         * @param alt where the altitudes will be set, at least `size() * count`, with target `i` at sample `k` at `i * count + k`
+         * @param az where the azimuths will be set, in the same order as `alt`
+         * @returns acts in place on the output arrays
+         */
+        void track(double start, double step, int count, double* alt, double* az);
+
+        /**
+         * Works out when every target in the batch rises, transits and sets, counting from the current LST.
+         *
+         * @see RiseSet::solve()
+         *
+         * @param rise where the rise times will be set, in seconds from the LST
+         * @param transit where the transit times will be set, in seconds from the LST
+         * @param set where the set times will be set, in seconds from the LST
+         * @param kind where each target's `RiseSetKind` will be set
+         * @param altitude the apparent altitude that counts as rising or setting, in degrees
+         * @param iterations the amount of times to refine the refraction at that altitude, where 0 leaves it out
+         * @returns acts in place on the output arrays
+         */
+        void riseSet(double* rise, double* transit, double* set, uint8_t* kind, double altitude = 0.0, int iterations = 6);
+
+        /**
+         * Copies a target out of the batch.
+         *
+         * @param i the index of the target
+         * @returns the target as a position
+         */
+        Position get(int i);
+
+    private:
+        /**
+         * Points the coordinate arrays into one block of memory.
+         *
+         * @param buffer an array of at least `bufferSize(capacity)` doubles
+         * @returns acts in place on data in the class
+         */
+        void assign(double* buffer);
+
+        /// @brief sine of each declination
+        double* _sinDec;
+
+        /// @brief cosine of each declination
+        double* _cosDec;
+
+        /// @brief local sidereal time
+        double _LST;
+
+        /// @brief latitude
+        double _latitude;
+
+        /// @brief sine of the latitude
+        double _sinLat;
+
+        /// @brief cosine of the latitude
+        double _cosLat;
+
+        /// @brief amount of targets in the batch
+        int _count;
+
+        /// @brief maximum amount of targets in the batch
+        int _capacity;
+
+        /// @brief whether the arrays were allocated by the batch
+        bool _owns;
+
+        // the arrays are owned by the batch, so it must not be copied
+        PositionBatch(const PositionBatch&);
+        PositionBatch& operator=(const PositionBatch&);
+};
+
+#endif
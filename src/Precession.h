@@ -0,0 +1,237 @@
+/**
+ * @file Precession.h
+ * @brief Precession from J2000 to the current epoch, worked out once per time update
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef PRECESSION_H
+
+#define PRECESSION_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+#include "AstroConstexpr.h"
+
+/// the amount of arc-seconds in a radian
+#define ARCSEC_TO_RADIANS(x) ((x) * (PI / 648000.0))
+
+/**
+ * The precession models that `BasicPrecession` can use
+ */
+enum PrecessionModel
+{
+    /// Alan Gilmore's first order correction (the original `AstroCalcs::precess()`), good to a few arc-seconds near J2000
+    PRECESSION_GILMORE,
+
+    /// the IAU 2006 (Capitaine et al. P03) precession angles, as a rotation matrix
+    PRECESSION_IAU2006
+};
+
+/**
+ * Precession Class
+ *
+ * Holds everything about precession that only depends on the time, so it can be worked out once per `updateTime()`
+ * and then applied to any number of targets with no time-dependent work.
+ *
+ * With `PRECESSION_GILMORE` the coefficients of the original formula are kept, and `apply()` gives the same result as before.
+ * With `PRECESSION_IAU2006` the rigorous rotation matrix is used. Either way `matrix` holds a rotation from J2000 to the epoch
+ * (for Gilmore it is the rotation with the same first order effect), so a batch of unit vectors can be precessed with one
+ * 3x3 matrix multiply per target.
+ *
+ * The epoch is worked out in double precision, as it only happens once per time update. Applying it is done in `Math::Scalar`.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h
+ */
+template<class Math> class BasicPrecession
+{
+    public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
+        /// @brief rotation matrix taking a J2000 unit vector to the epoch
+        Scalar matrix[3][3];
+
+        /**
+         * Constructor
+         *
+         * Starts at J2000, where precession does nothing.
+         *
+         * @param model the precession model to use
+         */
+        BasicPrecession(PrecessionModel model = PRECESSION_GILMORE)
+        {
+            this->_model = model;
+            update(2000, 0.0);
+        }
+
+        /**
+         * Changes the precession model. Takes effect on the next `update()`.
+         *
+         * @param model the precession model to use
+         */
+        void setModel(PrecessionModel model)
+        {
+            this->_model = model;
+        }
+
+        /**
+         * @returns the precession model in use
+         */
+        PrecessionModel getModel() const
+        {
+            return this->_model;
+        }
+
+        /**
+         * Works out the precession for a new epoch.
+         *
+         * @param year the year, used by the Gilmore coefficients
+         * @param jd the Julian date in days from J2000, used by the IAU 2006 angles
+         * @returns acts in place on data in the class
+         */
+        void update(int year, double jd)
+        {
+            // Gilmore's coefficients, converted from seconds of time (ra) and seconds of arc (dec) to degrees
+            double raOffset = gilmoreRaOffset(year);
+            double decScale = gilmoreDecScale(year);
+            this->_raOffset = Scalar(raOffset);
+            this->_raScale = Scalar(gilmoreRaScale(year));
+            this->_decScale = Scalar(decScale);
+
+            double zeta, z, theta;
+            if(this->_model == PRECESSION_IAU2006)
+            {
+                // Julian centuries from J2000, in arc-seconds
+                double t = jd / 36525.0;
+                zeta = 2.650545 + t * (2306.083227 + t * (0.2988499 + t * (0.01801828 + t * (-0.000005971 + t * -0.0000003173))));
+                z = -2.650545 + t * (2306.077181 + t * (1.0927348 + t * (0.01826837 + t * (-0.000028596 + t * -0.0000002904))));
+                theta = t * (2004.191903 + t * (-0.4294934 + t * (-0.04182264 + t * (-0.000007089 + t * -0.0000001274))));
+            }
+            else
+            {
+                // the rotation with the same first order effect: zeta + z = m, theta = n
+                zeta = raOffset * 1800.0;
+                z = zeta;
+                theta = decScale * 3600.0;
+            }
+
+            rotation(ARCSEC_TO_RADIANS(zeta), ARCSEC_TO_RADIANS(z), ARCSEC_TO_RADIANS(theta));
+        }
+
+        /**
+         * Precesses one J2000 coordinate to the epoch.
+         *
+         * @param ra the J2000 right ascention
+         * @param dec the J2000 declination
+         * @param ra_out a pointer where the precessed right ascention will be set
+         * @param dec_out a pointer where the precessed declination will be set
+         * @returns acts in place on the pointers
+         */
+        void apply(Scalar ra, Scalar dec, Scalar* ra_out, Scalar* dec_out) const
+        {
+            Scalar sin_r, cos_r;
+            Math::sincos(toRadians(ra), &sin_r, &cos_r);
+
+            if(this->_model == PRECESSION_GILMORE)
+            {
+                *ra_out = ra + this->_raOffset + this->_raScale * sin_r * Math::tan(toRadians(dec));
+                *dec_out = dec + this->_decScale * cos_r;
+                return;
+            }
+
+            Scalar sin_d, cos_d;
+            Math::sincos(toRadians(dec), &sin_d, &cos_d);
+
+            Scalar x = cos_d * cos_r;
+            Scalar y = cos_d * sin_r;
+            Scalar z = sin_d;
+            rotate(&x, &y, &z, &x, &y, &z, 1);
+
+            Scalar r = toDegrees(Math::atan2(y, x));
+            *ra_out = (r < Scalar(0.0)) ? r + Scalar(360.0) : r;
+            *dec_out = toDegrees(Math::atan2(z, hypotenuse(x, y)));
+        }
+
+        /**
+         * Precesses many J2000 unit vectors with the rotation matrix. The output arrays can be the input arrays.
+         *
+         * @param x the x component (towards ra 0, dec 0) of each unit vector
+         * @param y the y component (towards ra 90, dec 0) of each unit vector
+         * @param z the z component (towards the pole) of each unit vector
+         * @param x_out where the precessed x components will be set
+         * @param y_out where the precessed y components will be set
+         * @param z_out where the precessed z components will be set
+         * @param n the amount of unit vectors
+         * @returns acts in place on the output arrays
+         */
+        void rotate(const Scalar* x, const Scalar* y, const Scalar* z, Scalar* x_out, Scalar* y_out, Scalar* z_out, int n) const
+        {
+            for(int i = 0; i < n; i++)
+            {
+                Scalar a = x[i];
+                Scalar b = y[i];
+                Scalar c = z[i];
+                x_out[i] = this->matrix[0][0] * a + this->matrix[0][1] * b + this->matrix[0][2] * c;
+                y_out[i] = this->matrix[1][0] * a + this->matrix[1][1] * b + this->matrix[1][2] * c;
+                z_out[i] = this->matrix[2][0] * a + this->matrix[2][1] * b + this->matrix[2][2] * c;
+            }
+        }
+
+    private:
+        /**
+         * Builds the matrix R3(-z) R2(theta) R3(-zeta) from the three precession angles
+         *
+         * @param zeta the first rotation about the pole, in radians
+         * @param z the last rotation about the pole, in radians
+         * @param theta the rotation towards the pole, in radians
+         * @returns acts in place on data in the class
+         */
+        void rotation(double zeta, double z, double theta)
+        {
+            double sin_zeta = ::sin(zeta), cos_zeta = ::cos(zeta);
+            double sin_z = ::sin(z), cos_z = ::cos(z);
+            double sin_theta = ::sin(theta), cos_theta = ::cos(theta);
+
+            this->matrix[0][0] = Scalar(cos_z * cos_theta * cos_zeta - sin_z * sin_zeta);
+            this->matrix[0][1] = Scalar(-cos_z * cos_theta * sin_zeta - sin_z * cos_zeta);
+            this->matrix[0][2] = Scalar(-cos_z * sin_theta);
+            this->matrix[1][0] = Scalar(sin_z * cos_theta * cos_zeta + cos_z * sin_zeta);
+            this->matrix[1][1] = Scalar(-sin_z * cos_theta * sin_zeta + cos_z * cos_zeta);
+            this->matrix[1][2] = Scalar(-sin_z * sin_theta);
+            this->matrix[2][0] = Scalar(sin_theta * cos_zeta);
+            this->matrix[2][1] = Scalar(-sin_theta * sin_zeta);
+            this->matrix[2][2] = Scalar(cos_theta);
+        }
+
+        /// @brief the precession model
+        PrecessionModel _model;
+
+        /// @brief Gilmore's constant right ascention term, in degrees
+        Scalar _raOffset;
+
+        /// @brief Gilmore's sin(ra)tan(dec) term, in degrees
+        Scalar _raScale;
+
+        /// @brief Gilmore's declination term, in degrees
+        Scalar _decScale;
+};
+
+/// precession using the full precision C library trig functions
+typedef BasicPrecession<ExactMath> Precession;
+
+#endif
@@ -0,0 +1,142 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "Profile.h"
+
+#if ASTROCALCS_PROFILE
+
+static ProfileStats stats[PROFILE_STAGES];
+
+static const char* const names[PROFILE_STAGES] = {
+    "lst",
+    "precess",
+    "refract",
+    "setAltAz",
+    "altAz"
+};
+
+
+/**
+ * @param ticks the length of a call
+ * @returns the histogram bucket it goes in
+ */
+static int bucket(uint32_t ticks)
+{
+    int b = 0;
+    while(ticks && b < ASTROCALCS_PROFILE_BUCKETS - 1)
+    {
+        ticks >>= 1;
+        b++;
+    }
+    return b;
+}
+
+
+void profileRecord(ProfileStage stage, uint32_t ticks)
+{
+    ProfileStats* s = &stats[stage];
+    if(s->count == 0 || ticks < s->min)
+    {
+        s->min = ticks;
+    }
+    if(ticks > s->max)
+    {
+        s->max = ticks;
+    }
+    if(s->deadline && ticks > s->deadline)
+    {
+        s->late++;
+    }
+    s->count++;
+    s->total += ticks;
+
+    uint16_t* h = &s->histogram[bucket(ticks)];
+    if(*h != 0xFFFF)
+    {
+        (*h)++;
+    }
+}
+
+
+const ProfileStats& profileStats(ProfileStage stage)
+{
+    return stats[stage];
+}
+
+
+const char* profileName(ProfileStage stage)
+{
+    return names[stage];
+}
+
+
+void profileSetDeadline(ProfileStage stage, uint32_t ticks)
+{
+    stats[stage].deadline = ticks;
+}
+
+
+void profileReset()
+{
+    for(int i = 0; i < PROFILE_STAGES; i++)
+    {
+        uint32_t deadline = stats[i].deadline;
+        memset(&stats[i], 0, sizeof(ProfileStats));
+        stats[i].deadline = deadline;
+    }
+}
+
+
+void profileDump(Print& out)
+{
+    out.println("stage calls min mean max late | histogram by ticks: 0 1 2-3 4-7 ...");
+    for(int i = 0; i < PROFILE_STAGES; i++)
+    {
+        const ProfileStats& s = stats[i];
+        if(s.count == 0)
+        {
+            continue;
+        }
+        out.print(names[i]);
+        out.print(' ');
+        out.print((unsigned long)s.count);
+        out.print(' ');
+        out.print((unsigned long)s.min);
+        out.print(' ');
+        out.print((unsigned long)s.mean());
+        out.print(' ');
+        out.print((unsigned long)s.max);
+        out.print(' ');
+        out.print((unsigned long)s.late);
+        out.print(" |");
+
+        // the buckets after the last one used are left off
+        int used = ASTROCALCS_PROFILE_BUCKETS;
+        while(used > 0 && s.histogram[used - 1] == 0)
+        {
+            used--;
+        }
+        for(int b = 0; b < used; b++)
+        {
+            out.print(' ');
+            out.print((unsigned int)s.histogram[b]);
+        }
+        out.println();
+    }
+}
+
+#endif
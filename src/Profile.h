@@ -0,0 +1,199 @@
+/**
+ * @file Profile.h
+ * @brief Optional timing of the library's hot stages on the board itself, compiled out unless it is turned on
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef PROFILE_H
+
+#define PROFILE_H 1
+#include "Arduino.h"
+
+/// set to 1 to time the stages in `ProfileStage`. The library is compiled apart from the sketch, so this has to be a build
+/// flag (`-DASTROCALCS_PROFILE=1`) or set here. When it is 0 nothing is timed, stored or linked in.
+#ifndef ASTROCALCS_PROFILE
+#define ASTROCALCS_PROFILE 0
+#endif
+
+/// the clock the stages are timed with, which has to count up in an unsigned 32-bit integer. `micros()` by default,
+/// which is 4us a tick on a 16MHz AVR; a cycle counter (like `ARM_DWT_CYCCNT` on a Teensy) can be put here instead.
+#ifndef ASTROCALCS_PROFILE_CLOCK
+#define ASTROCALCS_PROFILE_CLOCK() micros()
+#endif
+
+/// amount of histogram buckets per stage. Bucket 0 counts calls of 0 ticks, and bucket b (from 1) the calls of 2^(b-1) to
+/// 2^b - 1 ticks, with the last one holding everything longer.
+#ifndef ASTROCALCS_PROFILE_BUCKETS
+#define ASTROCALCS_PROFILE_BUCKETS 16
+#endif
+
+/**
+ * The stages that are timed. Each is timed from its start to its end, so the stages that build a `Position` include the
+ * `Position::altAz()` inside them.
+ */
+enum ProfileStage
+{
+    /// `AstroCalcs::lst()`, the sidereal time from the date
+    PROFILE_LST,
+
+    /// `AstroCalcs::precess()`, precession and nutation of the current target
+    PROFILE_PRECESS,
+
+    /// `AstroCalcs::refract()`
+    PROFILE_REFRACT,
+
+    /// `AstroCalcs::setAltAz()`
+    PROFILE_SET_ALT_AZ,
+
+    /// `Position::altAz()`
+    PROFILE_ALT_AZ,
+
+    /// amount of stages
+    PROFILE_STAGES
+};
+
+/**
+ * What has been recorded for one stage, in ticks of `ASTROCALCS_PROFILE_CLOCK()`
+ */
+struct ProfileStats
+{
+    /// @brief amount of calls
+    uint32_t count;
+
+    /// @brief shortest call
+    uint32_t min;
+
+    /// @brief longest call
+    uint32_t max;
+
+    /// @brief calls longer than `deadline`
+    uint32_t late;
+
+    /// @brief the longest a call should take, or 0 for none
+    uint32_t deadline;
+
+    /// @brief all of the calls added up
+    uint64_t total;
+
+    /// @brief calls by length, see `ASTROCALCS_PROFILE_BUCKETS`. Each stops counting at 65535.
+    uint16_t histogram[ASTROCALCS_PROFILE_BUCKETS];
+
+    /**
+     * @returns the mean length of a call, or 0 if there have been none
+     */
+    uint32_t mean() const
+    {
+        return this->count ? (uint32_t)(this->total / this->count) : 0;
+    }
+};
+
+#if ASTROCALCS_PROFILE
+
+/**
+ * Adds one call to a stage.
+ *
+ * @param stage the stage
+ * @param ticks how long the call took
+ * @returns acts in place on the stage's stats
+ */
+void profileRecord(ProfileStage stage, uint32_t ticks);
+
+/**
+ * @param stage the stage
+ * @returns what has been recorded for the stage since the last `profileReset()`
+ */
+const ProfileStats& profileStats(ProfileStage stage);
+
+/**
+ * @param stage the stage
+ * @returns the stage's name, as `profileDump()` prints it
+ */
+const char* profileName(ProfileStage stage);
+
+/**
+ * Sets how long a call of a stage should take, so the calls that miss it are counted in `ProfileStats::late`.
+ *
+ * @param stage the stage
+ * @param ticks the deadline, in ticks of `ASTROCALCS_PROFILE_CLOCK()`, or 0 for none
+ * @returns acts in place on the stage's stats
+ */
+void profileSetDeadline(ProfileStage stage, uint32_t ticks);
+
+/**
+ * Forgets every call recorded so far. The deadlines are kept.
+ *
+ * @returns acts in place on every stage's stats
+ */
+void profileReset();
+
+/**
+ * Prints a table of every stage that has been called: the calls, min/mean/max, late calls and the histogram buckets.
+ *
+ * @param out where to print it, such as `Serial` (on a workstation, `Serial` prints to stdout)
+ * @returns prints to `out`
+ */
+void profileDump(Print& out);
+
+/**
+ * ProfileScope Class
+ *
+ * Times from where it is made to where it goes out of scope, and records that against a stage.
+ */
+class ProfileScope
+{
+    public:
+        /**
+         * Constructor
+         *
+         * @param stage the stage to record the time against
+         */
+        explicit ProfileScope(ProfileStage stage)
+        {
+            _stage = stage;
+            _start = ASTROCALCS_PROFILE_CLOCK();
+        }
+
+        /**
+         * Destructor
+         *
+         * Records the time since the constructor.
+         */
+        ~ProfileScope()
+        {
+            profileRecord(_stage, (uint32_t)(ASTROCALCS_PROFILE_CLOCK() - _start));
+        }
+
+    private:
+        /// @brief the stage being timed
+        ProfileStage _stage;
+
+        /// @brief the clock when the scope started
+        uint32_t _start;
+};
+
+/// times the rest of the enclosing scope against a `ProfileStage`
+#define ASTROCALCS_PROFILE_SCOPE(stage) ProfileScope profileScope(stage)
+
+#else
+
+#define ASTROCALCS_PROFILE_SCOPE(stage)
+
+#endif
+
+#endif
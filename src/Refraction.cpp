@@ -0,0 +1,30 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "Refraction.h"
+
+
+double saemundsson(double alt, double* slope)
+{
+    double shift = 10.3 / (alt + 5.11);
+    double s = sin(radians(alt + shift));
+    double c = cos(radians(alt + shift));
+
+    // d/dh cot(h + 10.3 / (h + 5.11)) = -csc^2 * (1 - 10.3 / (h + 5.11)^2), with h in degrees
+    *slope = -(1.02 / 60.0) * (PI / 180.0) * (1.0 - shift / (alt + 5.11)) / (s * s);
+    return (1.02 * c / s + 0.0019279) / 60.0;
+}
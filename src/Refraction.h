@@ -0,0 +1,256 @@
+/**
+ * @file Refraction.h
+ * @brief Atmospheric refraction from a table over altitude, built for the current pressure and temperature
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef REFRACTION_H
+
+#define REFRACTION_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+
+/// amount of altitudes in each refraction table. 24 is within 0.4" of the formula (0.6" going from apparent to true),
+/// 32 within 0.1" (0.2"), and 16 within 1.4" (2") in two thirds of the memory.
+#ifndef REFRACTION_TABLE_SIZE
+#define REFRACTION_TABLE_SIZE 24
+#endif
+
+/// the lowest true altitude in the tables, in degrees. Below it the refraction is held at its value there, both ways.
+#define REFRACTION_LOWEST -1.0
+
+/// the pressure the refraction formula is for, in millibars (hPa)
+#define REFRACTION_PRESSURE 1010.0
+
+/// the temperature the refraction formula is for, in degrees Celsius
+#define REFRACTION_TEMPERATURE 10.0
+
+/**
+ * Saemundsson's refraction, 1.02 cot(h + 10.3 / (h + 5.11)) arc-minutes at 1010 mb and 10 C, with the 0.0019279
+ * arc-minutes Meeus adds so it is zero at the zenith
+ *
+ * @see refraction()
+ *
+ * @param alt the true (airless) altitude, in degrees
+ * @param slope a pointer where the derivative against the altitude will be set
+ * @returns how much higher refraction makes the target look, in degrees
+ */
+double saemundsson(double alt, double* slope);
+
+/**
+ * Refraction Class
+ *
+ * Refraction only depends on the altitude and the weather, so it is tabulated for the current pressure and temperature
+ * and looked up, instead of working out a tangent for every target. There are two tables, one over the true altitude
+ * (for `toApparent()`) and one over the apparent altitude (for `toTrue()`), so both ways are a lookup and neither has
+ * to iterate.
+ *
+ * The refraction changes fastest at the horizon, so the table altitudes are spaced by the square of their index from
+ * `REFRACTION_LOWEST` (or where it looks to be) up to 90, about a fifth of a degree apart at the bottom and eight degrees
+ * at the top. Each one keeps the refraction and its slope, and a lookup is a square root and a cubic (Hermite) between
+ * the two either side.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h
+ */
+template<class Math> class BasicRefraction
+{
+    public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
+        /**
+         * Constructor
+         *
+         * Builds the tables for `REFRACTION_PRESSURE` and `REFRACTION_TEMPERATURE`.
+         */
+        BasicRefraction()
+        {
+            _pressure = REFRACTION_PRESSURE;
+            _temperature = REFRACTION_TEMPERATURE;
+            build();
+        }
+
+        /**
+         * Sets the weather the refraction is for, and builds the tables again if it has changed.
+         *
+         * Building works out a few tangents per table altitude, so call this when the readings change, not per target.
+         *
+         * @param pressure the air pressure at the telescope, in millibars (hPa)
+         * @param temperature the air temperature at the telescope, in degrees Celsius
+         * @returns true if the tables were built again
+         */
+        bool setWeather(double pressure, double temperature)
+        {
+            if(pressure == _pressure && temperature == _temperature)
+            {
+                return false;
+            }
+            _pressure = pressure;
+            _temperature = temperature;
+            build();
+            return true;
+        }
+
+        /**
+         * @returns the air pressure the tables are for, in millibars (hPa)
+         */
+        double getPressure() const
+        {
+            return _pressure;
+        }
+
+        /**
+         * @returns the air temperature the tables are for, in degrees Celsius
+         */
+        double getTemperature() const
+        {
+            return _temperature;
+        }
+
+        /**
+         * Takes a true (airless) altitude to where the target looks to be.
+         *
+         * @param alt the true altitude, in degrees
+         * @returns the apparent altitude, in degrees
+         */
+        Scalar toApparent(Scalar alt) const
+        {
+            return alt + lookup(this->_fromTrue, this->_fromTrueSlope, Scalar(REFRACTION_LOWEST), this->_trueScale, alt);
+        }
+
+        /**
+         * Takes the altitude a target looks to be at (as a telescope is pointed) to its true (airless) altitude.
+         *
+         * @param alt the apparent altitude, in degrees
+         * @returns the true altitude, in degrees
+         */
+        Scalar toTrue(Scalar alt) const
+        {
+            return alt - lookup(this->_fromApparent, this->_fromApparentSlope, this->_apparentLowest, this->_apparentScale, alt);
+        }
+
+    private:
+        /**
+         * Works out the tables for the current weather.
+         *
+         * @returns acts in place on data in the class
+         */
+        void build()
+        {
+            // Meeus chapter 16, the refraction goes with the density of the air
+            double weather = (_pressure / REFRACTION_PRESSURE) * (283.0 / (273.0 + _temperature));
+            double last = REFRACTION_TABLE_SIZE - 1;
+            double slope;
+
+            // the apparent table starts where the lowest true altitude looks to be, so below both the shift is the same
+            // and each direction stays the other's inverse
+            double lowest = REFRACTION_LOWEST + weather * saemundsson(REFRACTION_LOWEST, &slope);
+            double trueSpan = 90.0 - REFRACTION_LOWEST;
+            double apparentSpan = 90.0 - lowest;
+            this->_trueScale = Scalar(last * last / trueSpan);
+            this->_apparentLowest = Scalar(lowest);
+            this->_apparentScale = Scalar(last * last / apparentSpan);
+
+            for(int i = 0; i < REFRACTION_TABLE_SIZE; i++)
+            {
+                // the slopes are against the index, as that is what the lookup interpolates over
+                double fraction = (i / last) * (i / last);
+                double node = REFRACTION_LOWEST + trueSpan * fraction;
+                double r = weather * saemundsson(node, &slope);
+                this->_fromTrue[i] = Scalar(r);
+                this->_fromTrueSlope[i] = Scalar(weather * slope * 2.0 * trueSpan * i / (last * last));
+
+                // the true altitude that looks to be at this one, by Newton's method from a first guess one refraction below
+                node = lowest + apparentSpan * fraction;
+                double h = node - weather * saemundsson(node, &slope);
+                for(int k = 0; k < 4; k++)
+                {
+                    r = weather * saemundsson(h, &slope);
+                    h -= (h + r - node) / (1.0 + weather * slope);
+                }
+                saemundsson(h, &slope);
+                slope *= weather;
+                this->_fromApparent[i] = Scalar(node - h);
+                this->_fromApparentSlope[i] = Scalar(slope / (1.0 + slope) * 2.0 * apparentSpan * i / (last * last));
+            }
+        }
+
+        /**
+         * Interpolates one of the tables.
+         *
+         * @param value the refraction at each table altitude
+         * @param slope its derivative against the index
+         * @param lowest the first table altitude
+         * @param scale the square of the last index over the span of the table altitudes
+         * @param alt the altitude, in degrees
+         * @returns the refraction, in degrees
+         */
+        static Scalar lookup(const Scalar* value, const Scalar* slope, Scalar lowest, Scalar scale, Scalar alt)
+        {
+            if(alt <= lowest)
+            {
+                return value[0];
+            }
+            Scalar x = sqrt((alt - lowest) * scale);
+            int i = (int)x;
+            if(i >= REFRACTION_TABLE_SIZE - 1)
+            {
+                return value[REFRACTION_TABLE_SIZE - 1];
+            }
+            Scalar t = x - Scalar(i);
+
+            // the cubic through both ends with both slopes, in Horner form
+            Scalar rise = value[i + 1] - value[i];
+            Scalar c2 = Scalar(3.0) * rise - Scalar(2.0) * slope[i] - slope[i + 1];
+            Scalar c3 = slope[i] + slope[i + 1] - Scalar(2.0) * rise;
+            return value[i] + t * (slope[i] + t * (c2 + t * c3));
+        }
+
+        /// @brief the air pressure the tables are for, in millibars
+        double _pressure;
+
+        /// @brief the air temperature the tables are for, in degrees Celsius
+        double _temperature;
+
+        /// @brief the square of the last index over the span of the true altitudes
+        Scalar _trueScale;
+
+        /// @brief the first apparent altitude, where `REFRACTION_LOWEST` looks to be
+        Scalar _apparentLowest;
+
+        /// @brief the square of the last index over the span of the apparent altitudes
+        Scalar _apparentScale;
+
+        /// @brief the refraction at each true altitude, in degrees
+        Scalar _fromTrue[REFRACTION_TABLE_SIZE];
+
+        /// @brief the slope of `_fromTrue` against the index
+        Scalar _fromTrueSlope[REFRACTION_TABLE_SIZE];
+
+        /// @brief the refraction at each apparent altitude, in degrees
+        Scalar _fromApparent[REFRACTION_TABLE_SIZE];
+
+        /// @brief the slope of `_fromApparent` against the index
+        Scalar _fromApparentSlope[REFRACTION_TABLE_SIZE];
+};
+
+/// refraction tables in double precision
+typedef BasicRefraction<ExactMath> Refraction;
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "RiseSet.h"
+
+
+void RiseSet::solve(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                    double sinHorizon, double* rise, double* transit, double* set, uint8_t* kind, int n)
+{
+    for(int i = 0; i < n; i++)
+    {
+        // the hour angle is zero at transit, and goes up at the sidereal rate
+        transit[i] = wrapDegrees(ra[i] - LST) / SIDEREAL_RATE;
+
+        double denominator = cosLat * cosDec[i];
+        double numerator = sinHorizon - sinLat * sinDec[i];
+
+        // at the pole (or for a target on it) every hour angle has the same altitude
+        if(numerator >= denominator)
+        {
+            kind[i] = RISESET_NEVER_RISES;
+            rise[i] = transit[i];
+            set[i] = transit[i];
+        }
+        else if(numerator <= -denominator)
+        {
+            kind[i] = RISESET_CIRCUMPOLAR;
+            rise[i] = transit[i];
+            set[i] = transit[i];
+        }
+        else
+        {
+            double h = degrees(acos(numerator / denominator)) / SIDEREAL_RATE;
+            kind[i] = RISESET_RISES_AND_SETS;
+            rise[i] = transit[i] - h;
+            set[i] = transit[i] + h;
+        }
+    }
+}
+
+
+double RiseSet::horizon(double altitude, int iterations)
+{
+    double h = altitude;
+    for(int i = 0; i < iterations; i++)
+    {
+        h = altitude - refraction<ExactMath>(h);
+    }
+    return h;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file RiseSet.h
+ * @brief Rise, transit and set times of many targets, worked out in closed form
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef RISESET_H
+
+#define RISESET_H 1
+#include "Arduino.h"
+#include "Position.h"
+
+/// the length of a sidereal day (one turn of the LST), in seconds
+#define SIDEREAL_DAY_SECONDS (360.0 / SIDEREAL_RATE)
+
+/**
+ * Whether a target crosses the horizon
+ */
+enum RiseSetKind
+{
+    /// the target rises and sets, and all three times are set
+    RISESET_RISES_AND_SETS,
+
+    /// the target never goes below the horizon, so only the transit is set
+    RISESET_CIRCUMPOLAR,
+
+    /// the target never comes above the horizon, so only the transit is set
+    RISESET_NEVER_RISES
+};
+
+/**
+ * RiseSet Class
+ *
+ * A target is at its highest when its hour angle is zero, and crosses an altitude h when its hour angle is +/-H, where
+ * cos(H) = (sin(h) - sin(latitude) sin(dec)) / (cos(latitude) cos(dec)). Both come straight from the right ascention and
+ * declination, so the times need no stepping and no trig per target apart from one `acos`.
+ *
+ * Times are in seconds from the LST they are worked out for. The transit is the next one (in [0, `SIDEREAL_DAY_SECONDS`)),
+ * and the rise and set are the ones either side of it, so a target that is already up has a rise time in the past.
+ * The right ascention and declination are taken as fixed over the day, which is right for anything outside the solar system.
+ */
+class RiseSet
+{
+    public:
+        /**
+         * Works out the rise, transit and set times of many targets.
+         *
+         * @see PositionBatch::riseSet()
+         *
+         * @param ra the right ascention of each target
+         * @param sinDec the sine of each declination
+         * @param cosDec the cosine of each declination
+         * @param LST the local sidereal time the times are counted from
+         * @param sinLat the sine of the observer's latitude
+         * @param cosLat the cosine of the observer's latitude
+         * @param sinHorizon the sine of the true altitude that counts as rising or setting (see `horizon()`)
+         * @param rise where the rise times will be set, in seconds from the LST
+         * @param transit where the transit times will be set, in seconds from the LST
+         * @param set where the set times will be set, in seconds from the LST
+         * @param kind where each target's `RiseSetKind` will be set
+         * @param n the amount of targets
+         * @returns acts in place on the output arrays
+         */
+        static void solve(const double* ra, const double* sinDec, const double* cosDec, double LST, double sinLat, double cosLat,
+                          double sinHorizon, double* rise, double* transit, double* set, uint8_t* kind, int n);
+
+        /**
+         * Works out the true altitude a target is at when it looks like it is at some altitude, by iterating
+         * h = altitude - refraction(h). The refraction only depends on the altitude, so this is done once for a whole catalog.
+         *
+         * @see refraction()
+         *
+         * @param altitude the apparent altitude, in degrees (0 for the horizon)
+         * @param iterations the amount of times to refine it, where 0 leaves out refraction. Each one cuts the error about
+         *                   six times, so 6 is within 0.1" at the horizon.
+         * @returns the true altitude, in degrees
+         */
+        static double horizon(double altitude, int iterations);
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "SiteBatch.h"
+#include "AltAzKernels.h"
+
+#if SITEBATCH_THREADS
+#include <thread>
+#endif
+
+
+// amount of arrays that make up a batch
+#define SITEBATCH_ARRAYS 7
+
+// most threads altAz() will start
+#define SITEBATCH_MAX_THREADS 64
+
+
+SiteBatch::SiteBatch(int capacity)
+{
+    _capacity = capacity;
+    _owns = true;
+    assign(new double[bufferSize(capacity)]);
+    clear();
+}
+
+
+SiteBatch::SiteBatch(double* buffer, int capacity)
+{
+    _capacity = capacity;
+    _owns = false;
+    assign(buffer);
+    clear();
+}
+
+
+SiteBatch::~SiteBatch()
+{
+    if(_owns)
+    {
+        delete[] this->longitude;
+    }
+}
+
+
+int SiteBatch::bufferSize(int capacity)
+{
+    return SITEBATCH_ARRAYS * capacity;
+}
+
+
+void SiteBatch::assign(double* buffer)
+{
+    this->longitude = buffer;
+    this->latitude = buffer + _capacity;
+    this->ha = buffer + 2 * _capacity;
+    this->alt = buffer + 3 * _capacity;
+    this->az = buffer + 4 * _capacity;
+    _sinLat = buffer + 5 * _capacity;
+    _cosLat = buffer + 6 * _capacity;
+}
+
+
+int SiteBatch::add(double site_longitude, double site_latitude)
+{
+    if(_count >= _capacity)
+    {
+        return -1;
+    }
+    set(_count, site_longitude, site_latitude);
+    this->ha[_count] = 0.0;
+    this->alt[_count] = 0.0;
+    this->az[_count] = 0.0;
+    return _count++;
+}
+
+
+void SiteBatch::set(int i, double site_longitude, double site_latitude)
+{
+    double l = radians(site_latitude);
+    this->longitude[i] = site_longitude;
+    this->latitude[i] = site_latitude;
+    _sinLat[i] = sin(l);
+    _cosLat[i] = cos(l);
+}
+
+
+void SiteBatch::clear()
+{
+    _count = 0;
+    _ra = 0.0;
+    _dec = 0.0;
+    _GMST = 0.0;
+}
+
+
+int SiteBatch::size()
+{
+    return _count;
+}
+
+
+int SiteBatch::capacity()
+{
+    return _capacity;
+}
+
+
+void SiteBatch::altAz(double right_ascention, double declination, double GMST, int threads)
+{
+    double d = radians(declination);
+    double sin_d = sin(d);
+    double cos_d = cos(d);
+    _ra = wrapDegrees(right_ascention);
+    _dec = declination;
+    _GMST = wrapDegrees(GMST);
+
+#if SITEBATCH_THREADS
+    if(threads > _count / SITEBATCH_MIN_PER_THREAD)
+    {
+        threads = _count / SITEBATCH_MIN_PER_THREAD;
+    }
+    if(threads > SITEBATCH_MAX_THREADS)
+    {
+        threads = SITEBATCH_MAX_THREADS;
+    }
+    if(threads > 1)
+    {
+        // contiguous slices, so each thread writes its own cache lines; this thread takes the last one
+        std::thread workers[SITEBATCH_MAX_THREADS];
+        int slice = _count / threads;
+        for(int t = 0; t < threads - 1; t++)
+        {
+            int i = t * slice;
+            workers[t] = std::thread(AltAzKernels::sites, _ra, sin_d, cos_d, _GMST, this->longitude + i, _sinLat + i, _cosLat + i,
+                                     this->ha + i, this->alt + i, this->az + i, slice);
+        }
+        int i = (threads - 1) * slice;
+        AltAzKernels::sites(_ra, sin_d, cos_d, _GMST, this->longitude + i, _sinLat + i, _cosLat + i, this->ha + i, this->alt + i,
+                            this->az + i, _count - i);
+        for(int t = 0; t < threads - 1; t++)
+        {
+            workers[t].join();
+        }
+        return;
+    }
+#else
+    (void)threads;
+#endif
+
+    AltAzKernels::sites(_ra, sin_d, cos_d, _GMST, this->longitude, _sinLat, _cosLat, this->ha, this->alt, this->az, _count);
+}
+
+
+Position SiteBatch::get(int i)
+{
+    Position p(_ra, _dec, this->latitude[i], _GMST + this->longitude[i]);
+    p.cacheAltAz(this->alt[i], this->az[i]);
+    return p;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file SiteBatch.h
+ * @brief A structure-of-arrays container of observer sites, for seeing one target from many places at once
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef SITEBATCH_H
+
+#define SITEBATCH_H 1
+#include "Arduino.h"
+#include "Position.h"
+
+/// whether `SiteBatch::altAz()` can split the sites between threads, which is only on workstations
+#if !defined(SITEBATCH_THREADS) && !defined(ARDUINO) && defined(__unix__)
+#define SITEBATCH_THREADS 1
+#endif
+
+/// the fewest sites worth giving a thread of their own, below which starting the thread costs more than it saves
+#define SITEBATCH_MIN_PER_THREAD 8192
+
+/**
+ * SiteBatch Class
+ *
+ * Holds many observer sites as contiguous arrays (one array per coordinate), the way `PositionBatch` holds many targets.
+ *
+ * The sidereal time only depends on the site through its longitude, so the Greenwich mean sidereal time is worked out once
+ * per timestamp (`AstroCalcs::getGMST()`) and each site's LST is that plus its longitude. The sine and cosine of each latitude
+ * are cached when the site is added, and the target's declination terms are worked out once per call, so `altAz()` only costs
+ * the hour angle terms and two `atan2` per site. The results are the same as an `AstroCalcs` per site, to within
+ * `ALTAZKERNELS_TOLERANCE`.
+ *
+ * The target's coordinates are for the epoch of the date (precess them once with `AstroCalcs::getPrecession()`), as precession
+ * does not depend on the site. Parallax is not included, so this is for targets outside the solar system.
+ */
+class SiteBatch
+{
+    public:
+        /// @brief longitude of each site, east positive
+        double* longitude;
+
+        /// @brief latitude of each site
+        double* latitude;
+
+        /// @brief hour angle of the target from each site
+        double* ha;
+
+        /// @brief altitude of the target from each site
+        double* alt;
+
+        /// @brief azimuth of the target from each site
+        double* az;
+
+        /**
+         * Constructor
+         *
+         * Allocates room for `capacity` sites on the heap.
+         *
+         * @param capacity the maximum amount of sites in the batch
+         */
+        SiteBatch(int capacity);
+
+        /**
+         * Constructor
+         *
+         * Uses memory provided by the caller instead of the heap, which is useful on boards where the heap should not be touched.
+         *
+         * @see bufferSize()
+         *
+         * @param buffer an array of at least `bufferSize(capacity)` doubles
+         * @param capacity the maximum amount of sites in the batch
+         */
+        SiteBatch(double* buffer, int capacity);
+
+        /**
+         * Destructor
+         *
+         * Frees the arrays if they were allocated by the batch.
+         */
+        ~SiteBatch();
+
+        /**
+         * Returns the amount of doubles needed for a caller-provided buffer
+         *
+         * @param capacity the maximum amount of sites in the batch
+         * @returns the length of the buffer in doubles
+         */
+        static int bufferSize(int capacity);
+
+        /**
+         * Adds a site to the end of the batch.
+         *
+         * @param site_longitude the longitude of the site, east positive
+         * @param site_latitude the latitude of the site
+         * @returns the index of the site, or -1 if the batch is full
+         */
+        int add(double site_longitude, double site_latitude);
+
+        /**
+         * Replaces the longitude and latitude of a site.
+         *
+         * @param i the index of the site
+         * @param site_longitude the longitude of the site, east positive
+         * @param site_latitude the latitude of the site
+         * @returns acts in place on data in the class
+         */
+        void set(int i, double site_longitude, double site_latitude);
+
+        /**
+         * Removes every site from the batch.
+         *
+         * @returns acts in place on data in the class
+         */
+        void clear();
+
+        /**
+         * @returns the amount of sites in the batch
+         */
+        int size();
+
+        /**
+         * @returns the maximum amount of sites in the batch
+         */
+        int capacity();
+
+        /**
+         * Calculates the hour angle, altitude and azimuth of one target from every site.
+         *
+         * @see AltAzKernels::sites()
+         *
+         * @param right_ascention the right ascention of the target, for the epoch of the date
+         * @param declination the declination of the target, for the epoch of the date
+         * @param GMST the Greenwich mean sidereal time, from `AstroCalcs::getGMST()`
+         * @param threads the most threads to split the sites between, where only workstations (`SITEBATCH_THREADS`) use more than one
+         * @returns acts in place on data in the class
+         */
+        void altAz(double right_ascention, double declination, double GMST, int threads = 1);
+
+        /**
+         * Copies the target as seen from a site out of the batch.
+         *
+         * @param i the index of the site
+         * @returns the target as a position
+         */
+        Position get(int i);
+
+    private:
+        /**
+         * Points the arrays into one block of memory.
+         *
+         * @param buffer an array of at least `bufferSize(capacity)` doubles
+         * @returns acts in place on data in the class
+         */
+        void assign(double* buffer);
+
+        /// @brief sine of each latitude
+        double* _sinLat;
+
+        /// @brief cosine of each latitude
+        double* _cosLat;
+
+        /// @brief right ascention of the last target
+        double _ra;
+
+        /// @brief declination of the last target
+        double _dec;
+
+        /// @brief Greenwich mean sidereal time of the last target
+        double _GMST;
+
+        /// @brief amount of sites in the batch
+        int _count;
+
+        /// @brief maximum amount of sites in the batch
+        int _capacity;
+
+        /// @brief whether the arrays were allocated by the batch
+        bool _owns;
+
+        // the arrays are owned by the batch, so it must not be copied
+        SiteBatch(const SiteBatch&);
+        SiteBatch& operator=(const SiteBatch&);
+};
+
+#endif
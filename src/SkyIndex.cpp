@@ -0,0 +1,261 @@
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#include "Arduino.h"
+#include "SkyIndex.h"
+
+
+// widens every query a little (in degrees), so a target right on the edge of a cell is not lost to rounding
+#define SKYINDEX_MARGIN 1e-9
+
+
+SkyIndex::SkyIndex(int capacity, int bands)
+{
+    _capacity = capacity;
+    _bands = bands;
+    _x = new double[capacity];
+    _y = new double[capacity];
+    _z = new double[capacity];
+    _id = new int[capacity];
+
+    // about 2 * bands * cos(dec) buckets per band, so the cells are about square
+    _bandStart = new int[bands + 1];
+    _bandStart[0] = 0;
+    for(int b = 0; b < bands; b++)
+    {
+        double centre = -90.0 + (b + 0.5) * 180.0 / bands;
+        int buckets = (int)(2.0 * bands * cos(radians(centre)) + 0.5);
+        _bandStart[b + 1] = _bandStart[b] + ((buckets < 1) ? 1 : buckets);
+    }
+    _cellStart = new int[_bandStart[bands] + 1];
+
+    clear();
+}
+
+
+SkyIndex::~SkyIndex()
+{
+    delete[] _x;
+    delete[] _y;
+    delete[] _z;
+    delete[] _id;
+    delete[] _cellStart;
+    delete[] _bandStart;
+}
+
+
+int SkyIndex::add(double right_ascention, double declination)
+{
+    if(_count >= _capacity)
+    {
+        return -1;
+    }
+    double r = radians(right_ascention);
+    double d = radians(declination);
+    _x[_count] = cos(d) * cos(r);
+    _y[_count] = cos(d) * sin(r);
+    _z[_count] = sin(d);
+    _id[_count] = _count;
+    return _count++;
+}
+
+
+void SkyIndex::clear()
+{
+    _count = 0;
+    _built = 0;
+    for(int c = 0; c <= _bandStart[_bands]; c++)
+    {
+        _cellStart[c] = 0;
+    }
+}
+
+
+int SkyIndex::size()
+{
+    return _count;
+}
+
+
+int SkyIndex::capacity()
+{
+    return _capacity;
+}
+
+
+int SkyIndex::band(double declination)
+{
+    int b = (int)floor((declination + 90.0) * _bands / 180.0);
+    if(b < 0)
+    {
+        return 0;
+    }
+    return (b >= _bands) ? _bands - 1 : b;
+}
+
+
+int SkyIndex::cell(double right_ascention, double declination)
+{
+    int b = band(declination);
+    int buckets = _bandStart[b + 1] - _bandStart[b];
+    int k = (int)(wrapDegrees(right_ascention) * buckets / 360.0);
+    return _bandStart[b] + ((k >= buckets) ? buckets - 1 : k);
+}
+
+
+void SkyIndex::build()
+{
+    int cells = _bandStart[_bands];
+    int* dest = new int[2 * _count];
+    int* ids = dest + _count;
+    double* scratch = new double[_count];
+
+    // count the targets in each cell, then turn the counts into the first target of each cell
+    for(int c = 0; c <= cells; c++)
+    {
+        _cellStart[c] = 0;
+    }
+    for(int i = 0; i < _count; i++)
+    {
+        dest[i] = cell(degrees(atan2(_y[i], _x[i])), degrees(atan2(_z[i], sqrt(_x[i] * _x[i] + _y[i] * _y[i]))));
+        _cellStart[dest[i] + 1]++;
+    }
+    for(int c = 0; c < cells; c++)
+    {
+        _cellStart[c + 1] += _cellStart[c];
+    }
+
+    // where each target goes, in the order they are in now, so the sort is stable
+    for(int i = 0; i < _count; i++)
+    {
+        dest[i] = _cellStart[dest[i]]++;
+    }
+    for(int c = cells; c > 0; c--)
+    {
+        _cellStart[c] = _cellStart[c - 1];
+    }
+    _cellStart[0] = 0;
+
+    double* columns[3] = { _x, _y, _z };
+    for(int j = 0; j < 3; j++)
+    {
+        for(int i = 0; i < _count; i++)
+        {
+            scratch[dest[i]] = columns[j][i];
+        }
+        memcpy(columns[j], scratch, _count * sizeof(double));
+    }
+    for(int i = 0; i < _count; i++)
+    {
+        ids[dest[i]] = _id[i];
+    }
+    memcpy(_id, ids, _count * sizeof(int));
+
+    delete[] scratch;
+    delete[] dest;
+    _built = _count;
+}
+
+
+int SkyIndex::cone(double right_ascention, double declination, double radius, int* out, int max)
+{
+    double r = radians(right_ascention);
+    double d = radians(declination);
+    return search(cos(d) * cos(r), cos(d) * sin(r), sin(d), radius, out, max);
+}
+
+
+int SkyIndex::above(double LST, double latitude, double altitude, int* out, int max)
+{
+    return cone(LST, latitude, 90.0 - altitude, out, max);
+}
+
+
+int SkyIndex::above(double LST, double latitude, double altitude, const Precession& precession, int* out, int max)
+{
+    double r = radians(LST);
+    double l = radians(latitude);
+    double x = cos(l) * cos(r);
+    double y = cos(l) * sin(r);
+    double z = sin(l);
+
+    // the matrix is a rotation, so its transpose takes the zenith of the epoch back to J2000
+    const double (*m)[3] = precession.matrix;
+    double cx = m[0][0] * x + m[1][0] * y + m[2][0] * z;
+    double cy = m[0][1] * x + m[1][1] * y + m[2][1] * z;
+    double cz = m[0][2] * x + m[1][2] * y + m[2][2] * z;
+
+    return search(cx, cy, cz, 90.0 - altitude, out, max);
+}
+
+
+int SkyIndex::search(double cx, double cy, double cz, double radius, int* out, int max)
+{
+    if(_built != _count)
+    {
+        build();
+    }
+
+    double ra = wrapDegrees(degrees(atan2(cy, cx)));
+    double dec = degrees(atan2(cz, sqrt(cx * cx + cy * cy)));
+    double min_cos = cos(radians(radius));
+    double low = dec - radius - SKYINDEX_MARGIN;
+    double high = dec + radius + SKYINDEX_MARGIN;
+
+    // the widest the circle gets in right ascention. If it reaches a pole it covers every right ascention.
+    double half_width = 180.0;
+    if(low > -90.0 && high < 90.0)
+    {
+        double s = sin(radians(radius)) / cos(radians(dec));
+        half_width = (s >= 1.0) ? 180.0 : degrees(asin(s)) + SKYINDEX_MARGIN;
+    }
+
+    int found = 0;
+    int last_band = band(high);
+    for(int b = band(low); b <= last_band; b++)
+    {
+        int buckets = _bandStart[b + 1] - _bandStart[b];
+        int first = 0;
+        int last = buckets - 1;
+        if(half_width < 180.0)
+        {
+            first = (int)floor((ra - half_width) * buckets / 360.0);
+            last = (int)floor((ra + half_width) * buckets / 360.0);
+            if(last - first >= buckets)
+            {
+                first = 0;
+                last = buckets - 1;
+            }
+        }
+
+        for(int k = first; k <= last; k++)
+        {
+            int c = _bandStart[b] + ((k % buckets) + buckets) % buckets;
+            for(int i = _cellStart[c]; i < _cellStart[c + 1]; i++)
+            {
+                if(_x[i] * cx + _y[i] * cy + _z[i] * cz >= min_cos)
+                {
+                    if(found >= max)
+                    {
+                        return found;
+                    }
+                    out[found++] = _id[i];
+                }
+            }
+        }
+    }
+    return found;
+}
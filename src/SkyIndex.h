@@ -0,0 +1,205 @@
+/**
+ * @file SkyIndex.h
+ * @brief A grid over the sky, for finding the targets of a large catalog near a point or above the horizon
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef SKYINDEX_H
+
+#define SKYINDEX_H 1
+#include "Arduino.h"
+#include "Precession.h"
+
+/// the default amount of declination bands, so each band is 2 degrees high
+#ifndef SKYINDEX_BANDS
+#define SKYINDEX_BANDS 90
+#endif
+
+/**
+ * SkyIndex Class
+ *
+ * Splits the sky into declination bands, and each band into right ascention buckets. The amount of buckets in a band goes
+ * with the cosine of its declination, so every cell covers about the same area. Targets are kept as J2000 unit vectors,
+ * sorted by cell, so the targets of a cell are next to each other in memory.
+ *
+ * A query works out which cells its circle on the sky can reach, and only tests the targets in those cells. Each
+ * candidate is tested exactly (a dot product with the centre of the circle), so the results are the same as testing every
+ * target, but the cost goes with the amount of results instead of the size of the catalog.
+ *
+ * Targets are given back by their index, in the order they were added, so they can be looked up in the caller's catalog
+ * (or a `PositionBatch` filled in the same order).
+ */
+class SkyIndex
+{
+    public:
+        /**
+         * Constructor
+         *
+         * Allocates room for `capacity` targets on the heap.
+         *
+         * @param capacity the maximum amount of targets in the index
+         * @param bands the amount of declination bands. More bands means fewer candidates per query, but more cells to visit.
+         */
+        SkyIndex(int capacity, int bands = SKYINDEX_BANDS);
+
+        /**
+         * Destructor
+         */
+        ~SkyIndex();
+
+        /**
+         * Adds a target to the index. The target is put in its cell on the next `build()` (or the next query).
+         *
+         * @param right_ascention the J2000 right ascention of the target
+         * @param declination the J2000 declination of the target
+         * @returns the index of the target, or -1 if the index is full
+         */
+        int add(double right_ascention, double declination);
+
+        /**
+         * Removes every target from the index.
+         *
+         * @returns acts in place on data in the class
+         */
+        void clear();
+
+        /**
+         * @returns the amount of targets in the index
+         */
+        int size();
+
+        /**
+         * @returns the maximum amount of targets in the index
+         */
+        int capacity();
+
+        /**
+         * Sorts the targets into their cells. This is a counting sort, so it is linear in the amount of targets.
+         * The queries call it when targets have been added since the last one, so it only needs calling to control when the work happens.
+         *
+         * @returns acts in place on data in the class
+         */
+        void build();
+
+        /**
+         * Finds every target within some angle of a point.
+         *
+         * @param right_ascention the J2000 right ascention of the centre
+         * @param declination the J2000 declination of the centre
+         * @param radius the angle from the centre, in degrees
+         * @param out an array where the index of each target found will be set
+         * @param max the length of `out`. The search stops once it is full.
+         * @returns the amount of targets found
+         */
+        int cone(double right_ascention, double declination, double radius, int* out, int max);
+
+        /**
+         * Finds every target above some altitude, taking the catalog as already being in the coordinates of the epoch.
+         *
+         * Above an altitude is the same as within 90 - altitude of the zenith, which is at ra = LST, dec = latitude,
+         * so this is a cone query. Refraction is not included.
+         *
+         * @param LST the local sidereal time
+         * @param latitude the observer's latitude
+         * @param altitude the lowest altitude to find
+         * @param out an array where the index of each target found will be set
+         * @param max the length of `out`. The search stops once it is full.
+         * @returns the amount of targets found
+         */
+        int above(double LST, double latitude, double altitude, int* out, int max);
+
+        /**
+         * Finds every J2000 target that is above some altitude once it is precessed.
+         *
+         * The zenith is rotated back to J2000 with the transpose of the precession matrix, so the targets stay as they are.
+         * Pass `AstroCalcs::getPrecession()` to use the library's epoch and model.
+         *
+         * @param LST the local sidereal time
+         * @param latitude the observer's latitude
+         * @param altitude the lowest altitude to find
+         * @param precession the precession for the epoch of the LST
+         * @param out an array where the index of each target found will be set
+         * @param max the length of `out`. The search stops once it is full.
+         * @returns the amount of targets found
+         */
+        int above(double LST, double latitude, double altitude, const Precession& precession, int* out, int max);
+
+    private:
+        /**
+         * Finds every target within some angle of a unit vector, visiting only the cells the circle can reach
+         *
+         * @param cx the x component of the centre
+         * @param cy the y component of the centre
+         * @param cz the z component of the centre
+         * @param radius the angle from the centre, in degrees
+         * @param out an array where the index of each target found will be set
+         * @param max the length of `out`
+         * @returns the amount of targets found
+         */
+        int search(double cx, double cy, double cz, double radius, int* out, int max);
+
+        /**
+         * @param declination a declination in degrees
+         * @returns the band the declination is in
+         */
+        int band(double declination);
+
+        /**
+         * @param right_ascention a right ascention in degrees
+         * @param declination a declination in degrees
+         * @returns the cell the coordinate is in
+         */
+        int cell(double right_ascention, double declination);
+
+        /// @brief x component (towards ra 0, dec 0) of each target, sorted by cell
+        double* _x;
+
+        /// @brief y component (towards ra 90, dec 0) of each target, sorted by cell
+        double* _y;
+
+        /// @brief z component (towards the pole) of each target, sorted by cell
+        double* _z;
+
+        /// @brief the index each target was added with, sorted by cell
+        int* _id;
+
+        /// @brief the first target of each cell, with one more entry for the end of the last cell
+        int* _cellStart;
+
+        /// @brief the first cell of each band, with one more entry for the amount of cells
+        int* _bandStart;
+
+        /// @brief amount of declination bands
+        int _bands;
+
+        /// @brief amount of targets in the index
+        int _count;
+
+        /// @brief amount of targets that are sorted into cells
+        int _built;
+
+        /// @brief maximum amount of targets in the index
+        int _capacity;
+
+        // the arrays are owned by the index, so it must not be copied
+        SkyIndex(const SkyIndex&);
+        SkyIndex& operator=(const SkyIndex&);
+};
+
+#endif
@@ -0,0 +1,492 @@
+/**
+ * @file TrackedSet.h
+ * @brief A set of tracked targets where each one is only worked out again when it could have moved by more than a tolerance
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef TRACKEDSET_H
+
+#define TRACKEDSET_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+#include "Position.h"
+
+/// the largest change allowed in a target's altitude or azimuth before it is worked out again, in degrees (1")
+#ifndef TRACKEDSET_TOLERANCE
+#define TRACKEDSET_TOLERANCE (1.0 / 3600.0)
+#endif
+
+/// how many times the rate of a target is allowed for when it is scheduled. The rates are from the start of the interval,
+/// so at 2 the target is worked out again once its first order drift reaches half the tolerance, which leaves the other
+/// half for the rates changing.
+#ifndef TRACKEDSET_MARGIN
+#define TRACKEDSET_MARGIN 2.0
+#endif
+
+/// the longest a target is left before it is worked out again, in seconds, however slowly it moves. The hour angle turns
+/// 0.25 degrees in a minute, which keeps the rates at the start of the interval close to the rates at its end.
+#ifndef TRACKEDSET_MAX_INTERVAL
+#define TRACKEDSET_MAX_INTERVAL 60.0
+#endif
+
+/**
+ * TrackedSet Class
+ *
+ * Keeps a set of targets up to date as the time moves on, without working out every one on every tick. Most targets move
+ * well under an arc-second between ticks, so when a target is worked out its altitude and azimuth rates are found from its
+ * altitude, azimuth and the latitude:
+ *
+ *     d(alt)/dt = w cos(lat) sin(az)
+ *     d(az)/dt  = w (sin(lat) - cos(lat) cos(az) tan(alt))
+ *
+ * with w the sidereal rate, and the target is put in a priority queue (a binary min-heap) keyed by the time its drift would
+ * reach the tolerance. `advance()` only takes the targets that have come due off the top of the heap, so a tick costs
+ * O(k log n) for the k targets that need it, not O(n) for all of them. Between times, each target's position is the last
+ * one worked out, within the tolerance of where it is now.
+ *
+ * Close to the zenith the azimuth rate has no bound, and those targets are worked out on every tick.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h
+ */
+template<class Math> class BasicTrackedSet
+{
+    public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
+        /**
+         * One target in the set
+         */
+        struct Target
+        {
+            /// @brief where the target was when it was last worked out
+            BasicPosition<Math> position;
+
+            /// @brief when it has to be worked out again, in seconds from the last `updateLST()`
+            double due;
+
+            /// @brief where it is in the heap
+            int slot;
+        };
+
+        /**
+         * Constructor
+         *
+         * Allocates room for `capacity` targets on the heap.
+         *
+         * @param capacity the maximum amount of targets in the set
+         * @param latitude the observer's latitude
+         * @param tolerance the largest change allowed in a target's altitude or azimuth before it is worked out again, in degrees
+         */
+        BasicTrackedSet(int capacity, Scalar latitude, Scalar tolerance = Scalar(TRACKEDSET_TOLERANCE))
+        {
+            this->_owns = true;
+            this->init(new Target[capacity], new int[capacity], capacity, latitude, tolerance);
+        }
+
+        /**
+         * Constructor
+         *
+         * Uses memory provided by the caller instead of the heap, which is useful on boards where the heap should not be touched.
+         *
+         * @param targets an array of at least `capacity` targets
+         * @param heap an array of at least `capacity` ints
+         * @param capacity the maximum amount of targets in the set
+         * @param latitude the observer's latitude
+         * @param tolerance the largest change allowed in a target's altitude or azimuth before it is worked out again, in degrees
+         */
+        BasicTrackedSet(Target* targets, int* heap, int capacity, Scalar latitude, Scalar tolerance = Scalar(TRACKEDSET_TOLERANCE))
+        {
+            this->_owns = false;
+            this->init(targets, heap, capacity, latitude, tolerance);
+        }
+
+        /**
+         * Destructor
+         *
+         * Frees the arrays if they were allocated by the set.
+         */
+        ~BasicTrackedSet()
+        {
+            if(this->_owns)
+            {
+                delete[] this->_targets;
+                delete[] this->_heap;
+            }
+        }
+
+        /**
+         * Adds a target, and works out where it is now.
+         *
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @returns the index of the target, or -1 if the set is full
+         */
+        int add(Scalar right_ascention, Scalar declination)
+        {
+            if(this->_count >= this->_capacity)
+            {
+                return -1;
+            }
+            int i = this->_count++;
+            this->_targets[i].position = BasicPosition<Math>(right_ascention, declination, this->_latitude, this->LST());
+            this->_targets[i].slot = i;
+            this->_heap[i] = i;
+            this->refresh(i);
+            this->siftUp(i);
+            return i;
+        }
+
+        /**
+         * Moves a target, and works out where it is now.
+         *
+         * @param i the index of the target
+         * @param right_ascention the right ascention of the target
+         * @param declination the declination of the target
+         * @returns acts in place on data in the class
+         */
+        void set(int i, Scalar right_ascention, Scalar declination)
+        {
+            this->_targets[i].position.setRADEC(right_ascention, declination);
+            this->_targets[i].position.updateLST(this->LST());
+            this->refresh(i);
+            this->reschedule(i);
+        }
+
+        /**
+         * Removes every target from the set.
+         *
+         * @returns acts in place on data in the class
+         */
+        void clear()
+        {
+            this->_count = 0;
+        }
+
+        /**
+         * @returns the amount of targets in the set
+         */
+        int size() const
+        {
+            return this->_count;
+        }
+
+        /**
+         * @returns the maximum amount of targets in the set
+         */
+        int capacity() const
+        {
+            return this->_capacity;
+        }
+
+        /**
+         * Sets the observer's latitude, and works out every target again.
+         *
+         * @param latitude the observer's latitude
+         * @returns acts in place on data in the class
+         */
+        void setLatitude(Scalar latitude)
+        {
+            this->_latitude = latitude;
+            this->_sinLat = ::sin(radians((double)latitude));
+            this->_cosLat = ::cos(radians((double)latitude));
+            for(int i = 0; i < this->_count; i++)
+            {
+                this->_targets[i].position.setLatitude(latitude);
+            }
+            this->refreshAll();
+        }
+
+        /**
+         * Sets the largest change allowed in a target's altitude or azimuth. Each target keeps the time it was given until it
+         * next comes due.
+         *
+         * @param tolerance the tolerance, in degrees
+         * @returns acts in place on data in the class
+         */
+        void setTolerance(Scalar tolerance)
+        {
+            this->_tolerance = (double)tolerance;
+        }
+
+        /**
+         * Sets the local sidereal time, and works out every target again. The time the targets are due is counted from here.
+         *
+         * @param LST the local sidereal time
+         * @returns acts in place on data in the class
+         */
+        void updateLST(Scalar LST)
+        {
+            this->_LST = (double)LST;
+            this->_time = 0.0;
+            this->refreshAll();
+        }
+
+        /**
+         * Moves the time on, and works out the targets that could have moved by more than the tolerance since they last were.
+         *
+         * @param seconds the amount of seconds since the last tick, at least 0
+         * @returns the amount of targets that were worked out
+         */
+        int advance(double seconds)
+        {
+            this->_time += seconds;
+            // a target worked out now is due again no earlier than now, so strictly before keeps one right at the zenith
+            // to once a tick
+            int refreshed = 0;
+            while(this->_count > 0 && this->_targets[this->_heap[0]].due < this->_time)
+            {
+                int i = this->_heap[0];
+                this->_targets[i].position.updateLST(this->LST());
+                this->refresh(i);
+                this->siftDown(0);
+                refreshed++;
+            }
+            return refreshed;
+        }
+
+        /**
+         * @returns the seconds before the next target comes due, which a loop can sleep for
+         */
+        double remaining() const
+        {
+            return (this->_count > 0) ? this->_targets[this->_heap[0]].due - this->_time : (double)TRACKEDSET_MAX_INTERVAL;
+        }
+
+        /**
+         * @param i the index of the target
+         * @returns the target, within the tolerance of where it is now
+         */
+        const BasicPosition<Math>& get(int i) const
+        {
+            return this->_targets[i].position;
+        }
+
+    private:
+        /**
+         * Sets up the set over its arrays.
+         *
+         * @param targets the targets
+         * @param heap the heap
+         * @param capacity the length of both
+         * @param latitude the observer's latitude
+         * @param tolerance the tolerance, in degrees
+         * @returns acts in place on data in the class
+         */
+        void init(Target* targets, int* heap, int capacity, Scalar latitude, Scalar tolerance)
+        {
+            this->_targets = targets;
+            this->_heap = heap;
+            this->_capacity = capacity;
+            this->_count = 0;
+            this->_LST = 0.0;
+            this->_time = 0.0;
+            this->_tolerance = (double)tolerance;
+            this->setLatitude(latitude);
+        }
+
+        /**
+         * @returns the local sidereal time now. It is summed in double precision from the last `updateLST()`, so a fixed
+         *          point set can run for longer than its seconds would hold.
+         */
+        Scalar LST() const
+        {
+            return Scalar(wrapDegrees(this->_LST + this->_time * SIDEREAL_RATE));
+        }
+
+        /**
+         * Works out a target's position now, and the time it is next due from its rates.
+         *
+         * @param i the index of the target
+         * @returns acts in place on the target
+         */
+        void refresh(int i)
+        {
+            Target& t = this->_targets[i];
+
+            // the rates only set how soon the target is due, so the arc-minute polynomials are plenty
+            double sin_a, cos_a, sin_z, cos_z;
+            ArcminMath::sincos(radians((double)t.position.getAlt()), &sin_a, &cos_a);
+            ArcminMath::sincos(radians((double)t.position.getAz()), &sin_z, &cos_z);
+
+            // the azimuth rate is multiplied through by cos(alt), so it needs no tangent and its bound is a product
+            double altRate = fabs(this->_cosLat * sin_z);
+            double azRate = fabs(this->_sinLat * cos_a - this->_cosLat * cos_z * sin_a);
+            double reach = cos_a * this->_tolerance / (SIDEREAL_RATE * TRACKEDSET_MARGIN);
+
+            double interval = TRACKEDSET_MAX_INTERVAL;
+            if(altRate * interval * SIDEREAL_RATE * TRACKEDSET_MARGIN > this->_tolerance)
+            {
+                interval = this->_tolerance / (altRate * SIDEREAL_RATE * TRACKEDSET_MARGIN);
+            }
+            if(azRate * interval > reach)
+            {
+                interval = reach / azRate;
+            }
+            t.due = this->_time + interval;
+        }
+
+        /**
+         * Works out every target again, and builds the heap from nothing.
+         *
+         * @returns acts in place on data in the class
+         */
+        void refreshAll()
+        {
+            for(int i = 0; i < this->_count; i++)
+            {
+                this->_targets[i].position.updateLST(this->LST());
+                this->refresh(i);
+                this->_heap[i] = i;
+                this->_targets[i].slot = i;
+            }
+            for(int k = this->_count / 2 - 1; k >= 0; k--)
+            {
+                this->siftDown(k);
+            }
+        }
+
+        /**
+         * Moves a target up or down the heap after its time has changed.
+         *
+         * @param i the index of the target
+         * @returns acts in place on the heap
+         */
+        void reschedule(int i)
+        {
+            int k = this->_targets[i].slot;
+            if(k > 0 && this->_targets[i].due < this->_targets[this->_heap[(k - 1) / 2]].due)
+            {
+                this->siftUp(k);
+            }
+            else
+            {
+                this->siftDown(k);
+            }
+        }
+
+        /**
+         * Moves the target at a place in the heap up until its parent is due before it.
+         *
+         * @param k the place in the heap
+         * @returns acts in place on the heap
+         */
+        void siftUp(int k)
+        {
+            int i = this->_heap[k];
+            double due = this->_targets[i].due;
+            while(k > 0)
+            {
+                int parent = (k - 1) / 2;
+                if(this->_targets[this->_heap[parent]].due <= due)
+                {
+                    break;
+                }
+                this->place(k, this->_heap[parent]);
+                k = parent;
+            }
+            this->place(k, i);
+        }
+
+        /**
+         * Moves the target at a place in the heap down until both of its children are due after it.
+         *
+         * @param k the place in the heap
+         * @returns acts in place on the heap
+         */
+        void siftDown(int k)
+        {
+            int i = this->_heap[k];
+            double due = this->_targets[i].due;
+            while(true)
+            {
+                int child = 2 * k + 1;
+                if(child >= this->_count)
+                {
+                    break;
+                }
+                if(child + 1 < this->_count && this->_targets[this->_heap[child + 1]].due < this->_targets[this->_heap[child]].due)
+                {
+                    child++;
+                }
+                if(due <= this->_targets[this->_heap[child]].due)
+                {
+                    break;
+                }
+                this->place(k, this->_heap[child]);
+                k = child;
+            }
+            this->place(k, i);
+        }
+
+        /**
+         * @param k a place in the heap
+         * @param i the index of the target to put there
+         * @returns acts in place on the heap
+         */
+        void place(int k, int i)
+        {
+            this->_heap[k] = i;
+            this->_targets[i].slot = k;
+        }
+
+        /// @brief the targets, in the order they were added
+        Target* _targets;
+
+        /// @brief the indices of the targets, as a binary min-heap on the time they are due
+        int* _heap;
+
+        /// @brief the maximum amount of targets
+        int _capacity;
+
+        /// @brief the amount of targets
+        int _count;
+
+        /// @brief whether the arrays were allocated by the set
+        bool _owns;
+
+        /// @brief the observer's latitude
+        Scalar _latitude;
+
+        /// @brief sine of the latitude
+        double _sinLat;
+
+        /// @brief cosine of the latitude
+        double _cosLat;
+
+        /// @brief the largest change allowed before a target is worked out again, in degrees
+        double _tolerance;
+
+        /// @brief the local sidereal time at the last `updateLST()`, in degrees
+        double _LST;
+
+        /// @brief seconds since the last `updateLST()`
+        double _time;
+};
+
+/// a tracked set using the full precision C library trig functions
+typedef BasicTrackedSet<ExactMath> TrackedSet;
+
+/// a tracked set held and worked out in single precision
+typedef BasicTrackedSet<FloatMath> FloatTrackedSet;
+
+/// a tracked set held and worked out in Q15.16 fixed point
+typedef BasicTrackedSet<FixedMath> FixedTrackedSet;
+
+#endif
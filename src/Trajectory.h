@@ -0,0 +1,441 @@
+/**
+ * @file Trajectory.h
+ * @brief Chebyshev fits of a target's altitude and azimuth over a short window, for high rate servo loops
+ * @author Nathan Carter
+ */
+
+/*
+    Copyright (C) 2024 Nathan Carter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    To read the full terms and conditions, see https://www.gnu.org/licenses/.
+*/
+
+#ifndef TRAJECTORY_H
+
+#define TRAJECTORY_H 1
+#include "Arduino.h"
+#include "AstroMath.h"
+#include "Position.h"
+
+/// the amount of Chebyshev terms in each fit
+#define TRAJECTORY_TERMS 8
+
+/// the length of a window, in seconds, when the target is well away from the zenith
+#ifndef TRAJECTORY_WINDOW
+#define TRAJECTORY_WINDOW 4.0
+#endif
+
+/// the shortest window, in seconds. If a fit this short is still out, the ticks fall back to `Position::altAz()`.
+#ifndef TRAJECTORY_MIN_WINDOW
+#define TRAJECTORY_MIN_WINDOW 0.05
+#endif
+
+/// the largest difference allowed between a fit and `Position::altAz()`, in degrees (1")
+#ifndef TRAJECTORY_TOLERANCE
+#define TRAJECTORY_TOLERANCE (1.0 / 3600.0)
+#endif
+
+/// how many seconds the windows' LST is worked out from one starting LST, before that is moved on to the current window
+#ifndef TRAJECTORY_RESYNC_SECONDS
+#define TRAJECTORY_RESYNC_SECONDS 600.0
+#endif
+
+/**
+ * Trajectory Class
+ *
+ * Follows a target for a mount's servo loop. Instead of the whole `altAz()` chain every tick, the altitude and azimuth
+ * are fitted with Chebyshev polynomials over a window of a few seconds, and each tick is a Clenshaw sum of
+ * `TRAJECTORY_TERMS` multiply-adds per axis. The rates come from the derivative of the same fits, for velocity feed-forward.
+ *
+ * A new fit is made when `advance()` moves the time out of the window. The azimuth is unwrapped before fitting, so a window
+ * crossing north is as smooth as any other. Close to the zenith the azimuth swings round quickly, so every fit is checked
+ * against `Position` between its nodes, and the window is halved until it is within `TRAJECTORY_TOLERANCE`. If a window of
+ * `TRAJECTORY_MIN_WINDOW` is still out (the target goes within a few arc-seconds of the zenith), the ticks in that window
+ * use `Position` directly.
+ *
+ * @tparam Math the trig backend (`ExactMath`, `ArcsecMath`, `ArcminMath`, `FloatMath` or `FixedMath`), see AstroMath.h
+ */
+template<class Math> class BasicTrajectory
+{
+    public:
+        /// the type every angle is held in (`double`, `float` or `Fixed`)
+        typedef typename Math::Scalar Scalar;
+
+        /// @brief altitude at the current time, in degrees
+        Scalar alt;
+
+        /// @brief azimuth at the current time, in degrees, in [0, 360)
+        Scalar az;
+
+        /// @brief rate the altitude is changing at, in degrees per second
+        Scalar altRate;
+
+        /// @brief rate the azimuth is changing at, in degrees per second
+        Scalar azRate;
+
+        /**
+         * Constructor
+         *
+         * @param window the length of a window, in seconds
+         * @param tolerance the largest difference allowed between a fit and `Position`, in degrees. The fixed point and
+         *                  arc-minute backends are only good to 15", so they need a looser tolerance than the default.
+         */
+        BasicTrajectory(Scalar window = Scalar(TRAJECTORY_WINDOW), Scalar tolerance = Scalar(TRAJECTORY_TOLERANCE))
+        {
+            this->_window = window;
+            this->_tolerance = tolerance;
+            this->start(BasicPosition<Math>());
+        }
+
+        /**
+         * Starts following a target from now. Pass `AstroCalcs::curr_pos` to follow the library's current target.
+         *
+         * @param target the target, with its right ascention, declination, latitude and LST
+         * @returns acts in place on data in the class
+         */
+        void start(const BasicPosition<Math>& target)
+        {
+            this->_ra = target.getRA();
+            this->_dec = target.getDec();
+            this->_latitude = target.getLatitude();
+            this->_LST = target.getLST();
+            this->_syncLST = this->_LST;
+            this->_elapsedMs = 0;
+            this->_elapsedRest = 0.0;
+            this->_startMs = 0;
+            this->_startRest = 0.0;
+            this->_length = this->_window;
+            this->fit();
+            this->evaluate();
+        }
+
+        /**
+         * Moves the time on by some amount of seconds (the servo period) and updates `alt`, `az` and their rates.
+         * Makes a new fit when the time leaves the window.
+         *
+         * The time is a `double`, and is added up as whole milliseconds and a remainder, so a millisecond tick (which is
+         * not exact in any of the scalar types) does not drift over a long run. Each window's LST is worked out from the
+         * time since one starting LST, rather than added on window by window.
+         *
+         * @param seconds the amount of seconds since the last tick, which can be negative
+         * @returns acts in place on data in the class
+         */
+        void advance(double seconds)
+        {
+            double rest = this->_elapsedRest + seconds;
+            long ms = (long)floor(rest * 1000.0);
+            this->_elapsedMs += ms;
+            this->_elapsedRest = rest - (double)ms * 0.001;
+
+            double t = this->time();
+            if(t < 0.0 || t >= (double)this->_length)
+            {
+                double elapsed = (double)this->_elapsedMs * 0.001 + this->_elapsedRest;
+                this->_LST = wrapDegrees(this->_syncLST + secondsToLST(Scalar(elapsed)));
+                if(labs(this->_elapsedMs) >= (long)(TRAJECTORY_RESYNC_SECONDS * 1000.0))
+                {
+                    this->_syncLST = this->_LST;
+                    this->_elapsedMs = 0;
+                    this->_elapsedRest = 0.0;
+                }
+                this->_startMs = this->_elapsedMs;
+                this->_startRest = this->_elapsedRest;
+                this->_length = this->_window;
+                this->fit();
+            }
+            this->evaluate();
+        }
+
+        /**
+         * @returns the seconds left before the next fit
+         */
+        Scalar remaining() const
+        {
+            return this->_length - Scalar(this->time());
+        }
+
+    private:
+        /**
+         * @returns the seconds since the start of the window
+         */
+        double time() const
+        {
+            return (double)(this->_elapsedMs - this->_startMs) * 0.001 + (this->_elapsedRest - this->_startRest);
+        }
+
+        /**
+         * Fits the altitude and azimuth over `_length` seconds from `_LST`, halving the window until the fit is within the tolerance.
+         *
+         * @returns acts in place on data in the class
+         */
+        void fit()
+        {
+            while(true)
+            {
+                this->coefficients();
+                this->_exact = !this->check();
+                if(!this->_exact || this->_length <= Scalar(2.0 * TRAJECTORY_MIN_WINDOW))
+                {
+                    return;
+                }
+                this->_length = this->_length / Scalar(2.0);
+            }
+        }
+
+        /**
+         * Works out the Chebyshev coefficients of the altitude and azimuth, and of their rates, from `Position` at the
+         * Chebyshev nodes of the window.
+         *
+         * @returns acts in place on data in the class
+         */
+        void coefficients()
+        {
+            Scalar alt[TRAJECTORY_TERMS], az[TRAJECTORY_TERMS];
+            for(int j = 0; j < TRAJECTORY_TERMS; j++)
+            {
+                // node j is at x = cos(pi (j + 1/2) / n), which runs from the end of the window back to the start
+                double x = ::cos(PI * (j + 0.5) / TRAJECTORY_TERMS);
+                BasicPosition<Math> p = this->at(this->_length * Scalar((x + 1.0) / 2.0));
+                alt[j] = p.getAlt();
+                az[j] = p.getAz();
+
+                // keep the azimuth continuous across north
+                if(j > 0)
+                {
+                    while(az[j] - az[j - 1] > Scalar(180.0))
+                    {
+                        az[j] -= Scalar(360.0);
+                    }
+                    while(az[j] - az[j - 1] < Scalar(-180.0))
+                    {
+                        az[j] += Scalar(360.0);
+                    }
+                }
+            }
+
+            // the fits are of the change from the first node, which is small, so the basis is not multiplied up by whole
+            // degrees (in fixed point that would be up to 20" per term)
+            this->_altOffset = alt[0];
+            this->_azOffset = az[0];
+            for(int j = 0; j < TRAJECTORY_TERMS; j++)
+            {
+                alt[j] -= this->_altOffset;
+                az[j] -= this->_azOffset;
+            }
+
+            for(int k = 0; k < TRAJECTORY_TERMS; k++)
+            {
+                Scalar a = Scalar(0.0), b = Scalar(0.0);
+                for(int j = 0; j < TRAJECTORY_TERMS; j++)
+                {
+                    Scalar basis = Scalar(::cos(PI * k * (j + 0.5) / TRAJECTORY_TERMS) * 2.0 / TRAJECTORY_TERMS);
+                    a += basis * alt[j];
+                    b += basis * az[j];
+                }
+                this->_altC[k] = a;
+                this->_azC[k] = b;
+            }
+
+            // the derivative of the series, d[k - 1] = d[k + 1] + 2 k c[k], then from d/dx to d/dt
+            Scalar scale = Scalar(2.0) / this->_length;
+            Scalar altNext = Scalar(0.0), azNext = Scalar(0.0);
+            Scalar altD = Scalar(0.0), azD = Scalar(0.0);
+            this->_altD[TRAJECTORY_TERMS - 1] = Scalar(0.0);
+            this->_azD[TRAJECTORY_TERMS - 1] = Scalar(0.0);
+            for(int k = TRAJECTORY_TERMS - 1; k > 0; k--)
+            {
+                Scalar a = altNext + Scalar(2.0 * k) * this->_altC[k];
+                Scalar b = azNext + Scalar(2.0 * k) * this->_azC[k];
+                altNext = altD;
+                azNext = azD;
+                altD = a;
+                azD = b;
+                this->_altD[k - 1] = a * scale;
+                this->_azD[k - 1] = b * scale;
+            }
+
+            // the first term of a Chebyshev series counts half
+            this->_altC[0] = this->_altC[0] / Scalar(2.0);
+            this->_azC[0] = this->_azC[0] / Scalar(2.0);
+            this->_altD[0] = this->_altD[0] / Scalar(2.0);
+            this->_azD[0] = this->_azD[0] / Scalar(2.0);
+        }
+
+        /**
+         * Compares the fit with `Position` half way between the nodes, where a polynomial is furthest out
+         *
+         * @returns whether the fit is within the tolerance
+         */
+        bool check()
+        {
+            for(int j = 0; j <= TRAJECTORY_TERMS; j++)
+            {
+                double x = ::cos(PI * j / TRAJECTORY_TERMS);
+                Scalar t = this->_length * Scalar((x + 1.0) / 2.0);
+                BasicPosition<Math> p = this->at(t);
+                Scalar u = this->toUnit(t);
+                Scalar az = wrapDegrees(this->_azOffset + series(this->_azC, u)) - p.getAz();
+                if(fabs(this->_altOffset + series(this->_altC, u) - p.getAlt()) > this->_tolerance)
+                {
+                    return false;
+                }
+                if(fabs(az) > this->_tolerance && fabs(az) < Scalar(360.0) - this->_tolerance)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Sets `alt`, `az` and their rates for the current time
+         *
+         * @returns acts in place on data in the class
+         */
+        void evaluate()
+        {
+            Scalar t = Scalar(this->time());
+            if(this->_exact)
+            {
+                // close enough to the zenith that no fit holds, so the rates come from a step of a millisecond
+                BasicPosition<Math> p = this->at(t);
+                BasicPosition<Math> q = this->at(t + Scalar(0.001));
+                Scalar daz = q.getAz() - p.getAz();
+                if(daz > Scalar(180.0))
+                {
+                    daz -= Scalar(360.0);
+                }
+                else if(daz < Scalar(-180.0))
+                {
+                    daz += Scalar(360.0);
+                }
+                this->alt = p.getAlt();
+                this->az = p.getAz();
+                this->altRate = (q.getAlt() - p.getAlt()) * Scalar(1000.0);
+                this->azRate = daz * Scalar(1000.0);
+                return;
+            }
+
+            Scalar u = this->toUnit(t);
+            this->alt = this->_altOffset + series(this->_altC, u);
+            this->az = wrapDegrees(this->_azOffset + series(this->_azC, u));
+            this->altRate = series(this->_altD, u);
+            this->azRate = series(this->_azD, u);
+        }
+
+        /**
+         * @param t seconds into the window
+         * @returns the target at that time
+         */
+        BasicPosition<Math> at(Scalar t)
+        {
+            return BasicPosition<Math>(this->_ra, this->_dec, this->_latitude, this->_LST + secondsToLST(t));
+        }
+
+        /**
+         * @param t seconds into the window
+         * @returns the time as x in [-1, 1], which the Chebyshev series are in
+         */
+        Scalar toUnit(Scalar t)
+        {
+            return (t + t) / this->_length - Scalar(1.0);
+        }
+
+        /**
+         * Sums a Chebyshev series with Clenshaw's recurrence
+         *
+         * @param c the coefficients, with the first already halved
+         * @param x where to sum it, in [-1, 1]
+         * @returns the value of the series
+         */
+        static Scalar series(const Scalar* c, Scalar x)
+        {
+            Scalar x2 = x + x;
+            Scalar b1 = Scalar(0.0), b2 = Scalar(0.0);
+            for(int k = TRAJECTORY_TERMS - 1; k > 0; k--)
+            {
+                Scalar b0 = x2 * b1 - b2 + c[k];
+                b2 = b1;
+                b1 = b0;
+            }
+            return x * b1 - b2 + c[0];
+        }
+
+        /// @brief right ascention of the target
+        Scalar _ra;
+
+        /// @brief declination of the target
+        Scalar _dec;
+
+        /// @brief latitude of the observer
+        Scalar _latitude;
+
+        /// @brief local sidereal time at the start of the window
+        Scalar _LST;
+
+        /// @brief local sidereal time the windows' LST is worked out from
+        Scalar _syncLST;
+
+        /// @brief whole milliseconds since `_syncLST`
+        long _elapsedMs;
+
+        /// @brief seconds since `_syncLST` on top of `_elapsedMs`, in [0, 0.001)
+        double _elapsedRest;
+
+        /// @brief `_elapsedMs` at the start of the window
+        long _startMs;
+
+        /// @brief `_elapsedRest` at the start of the window
+        double _startRest;
+
+        /// @brief length of the current window, in seconds
+        Scalar _length;
+
+        /// @brief length of a window away from the zenith, in seconds
+        Scalar _window;
+
+        /// @brief largest difference allowed between a fit and `Position`, in degrees
+        Scalar _tolerance;
+
+        /// @brief whether no fit held, so the ticks in this window use `Position`
+        bool _exact;
+
+        /// @brief altitude at the first node, which the altitude fit is relative to
+        Scalar _altOffset;
+
+        /// @brief azimuth at the first node, which the azimuth fit is relative to
+        Scalar _azOffset;
+
+        /// @brief Chebyshev coefficients of the altitude
+        Scalar _altC[TRAJECTORY_TERMS];
+
+        /// @brief Chebyshev coefficients of the (unwrapped) azimuth
+        Scalar _azC[TRAJECTORY_TERMS];
+
+        /// @brief Chebyshev coefficients of the altitude rate, per second
+        Scalar _altD[TRAJECTORY_TERMS];
+
+        /// @brief Chebyshev coefficients of the azimuth rate, per second
+        Scalar _azD[TRAJECTORY_TERMS];
+};
+
+/// a trajectory using the full precision C library trig functions
+typedef BasicTrajectory<ExactMath> Trajectory;
+
+/// a trajectory held and worked out in single precision
+typedef BasicTrajectory<FloatMath> FloatTrajectory;
+
+/// a trajectory held and worked out in Q15.16 fixed point
+typedef BasicTrajectory<FixedMath> FixedTrajectory;
+
+#endif